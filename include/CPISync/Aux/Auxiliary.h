@@ -28,6 +28,10 @@
 #include <climits>
 #include <cstring>
 #include <memory>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <functional>
 #include <CPISync/Aux/ConstantsAndTypes.h>
 #include <CPISync/Aux/Logger.h>
 
@@ -152,6 +156,31 @@ inline string zzToString(ZZ num)
     return out;
 }
 
+/**
+ * Writes a 64-bit word as 8 little-endian bytes, as toBytes<unsigned long> does, but without allocating.
+ * @param word The word to write
+ * @param buf The buffer to write into; must have room for 8 bytes
+ * @return the byte after the written word
+ */
+inline byte *writeWordLE(std::uint64_t word, byte *buf) {
+    for (int ii = 0; ii < 8; ii++) {
+        buf[ii] = (byte) (word & 0xFF);
+        word >>= 8;
+    }
+    return buf + 8;
+}
+
+/**
+ * @param buf 8 little-endian bytes, as written by writeWordLE
+ * @return the word in buf
+ */
+inline std::uint64_t readWordLE(const byte *buf) {
+    std::uint64_t res = 0;
+    for (int ii = 7; ii >= 0; ii--)
+        res = (res << 8) | buf[ii];
+    return res;
+}
+
 /**
  * convert bytes from buffer to a number
  * @tparam T - numerics of types int, long, unsigned long
@@ -174,7 +203,7 @@ inline T fromBytes(const byte* buffer) {
  */
 inline ZZ fromBytesZZ(const byte* buf, long &bytesRead) {
     ZZ res{0};
-    long numBytes = fromBytes<long>(buf);
+    auto numBytes = (long) readWordLE(buf);
     res = ZZFromBytes(buf+sizeof(long), numBytes);
     // the no of bytes that were used to represent this ZZ
     bytesRead = numBytes + sizeof(long);
@@ -213,6 +242,109 @@ inline vector<byte> toBytes(ZZ num) {
     return res;
 }
 
+/**
+ * @param num A number
+ * @return the number of bytes that toBytes(num) produces
+ */
+inline size_t serialSizeZZ(const ZZ &num) {
+    long numBytes = NumBytes(num);
+    return sizeof(long) + (numBytes == 0 ? 1 : numBytes);
+}
+
+/**
+ * Writes the representation toBytes(num) directly into a buffer.
+ * @param num The number to write
+ * @param buf The buffer to write into; must have room for serialSizeZZ(num) bytes
+ * @return the byte after the written number
+ */
+inline byte *writeBytesZZ(const ZZ &num, byte *buf) {
+    long numBytes = NumBytes(num);
+    if (numBytes == 0) numBytes = 1; // special case to send 0 value
+    buf = writeWordLE((std::uint64_t) numBytes, buf);
+    BytesFromZZ(buf, num, numBytes);
+    return buf + numBytes;
+}
+
+// ... seeded hashing
+
+// the 64-bit golden ratio, used to spread seeds and lengths over the hash state
+const std::uint64_t HASH_GOLDEN = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * Mixes the bits of a 64-bit value (the splitmix64 finalizer).  This is a bijection.
+ * @param xx The value to mix
+ * @return a well-mixed 64-bit value
+ */
+inline std::uint64_t mix64(std::uint64_t xx) {
+    xx ^= xx >> 30;
+    xx *= 0xBF58476D1CE4E5B9ULL;
+    xx ^= xx >> 27;
+    xx *= 0x94D049BB133111EBULL;
+    xx ^= xx >> 31;
+    return xx;
+}
+
+/**
+ * A seeded 64-bit hash of len bytes that are stored little-endian in 64-bit words, in the style of wyhash/xxHash.
+ * Does not allocate.
+ * @param words ceil(len/8) words, the last of which is zero-padded beyond len bytes
+ * @param len The number of bytes to hash
+ * @param seed Selects a member of the hash family
+ * @return the hash of the bytes, independent of the host's endianness and word size
+ */
+inline std::uint64_t seededHashWords(const std::uint64_t *words, size_t len, std::uint64_t seed) {
+    std::uint64_t state = mix64(seed ^ (len * HASH_GOLDEN));
+    for (size_t ii = 0; ii * sizeof(std::uint64_t) < len; ii++)
+        state = mix64((state ^ words[ii]) + HASH_GOLDEN);
+    return mix64(state);
+}
+
+/**
+ * A seeded 64-bit hash of a byte string.  Equal to seededHashWords of the same bytes.
+ * @param data The bytes to hash
+ * @param len The number of bytes to hash
+ * @param seed Selects a member of the hash family
+ */
+inline std::uint64_t seededHash(const byte *data, size_t len, std::uint64_t seed) {
+    std::uint64_t state = mix64(seed ^ (len * HASH_GOLDEN));
+    for (size_t ii = 0; ii < len; ii += sizeof(std::uint64_t)) {
+        std::uint64_t chunk = 0;
+        for (size_t jj = std::min(len, ii + sizeof(std::uint64_t)); jj > ii; jj--)
+            chunk = (chunk << 8) | data[jj - 1];
+        state = mix64((state ^ chunk) + HASH_GOLDEN);
+    }
+    return mix64(state);
+}
+
+/**
+ * A seeded 64-bit hash of a ZZ, computed over its little-endian bytes (as produced by BytesFromZZ).
+ * Does not allocate unless num is larger than 64 bytes.
+ * @param num The number to hash
+ * @param seed Selects a member of the hash family
+ */
+inline std::uint64_t seededHash(const ZZ &num, std::uint64_t seed) {
+    const size_t STACK_BYTES = 64;
+    if (sign(num) < 0) seed = ~seed; // BytesFromZZ drops the sign
+    auto len = (size_t) NumBytes(num);
+    if (len <= STACK_BYTES) {
+        byte buf[STACK_BYTES];
+        BytesFromZZ(buf, num, len);
+        return seededHash(buf, len, seed);
+    }
+    vector<byte> buf(len);
+    BytesFromZZ(buf.data(), num, len);
+    return seededHash(buf.data(), len, seed);
+}
+
+/**
+ * Derives the kk-th member of a family of hashes from a single seeded hash of an item.
+ * @param base A seededHash of the item
+ * @param kk The index of the desired hash
+ */
+inline std::uint64_t seededHashK(std::uint64_t base, long kk) {
+    return mix64(base ^ ((std::uint64_t) (kk + 1) * HASH_GOLDEN));
+}
+
 
 
 
@@ -764,7 +896,7 @@ public:
      */
     operator T() const { return operator*(); }
 
-    bool isNullQ() { return nulled; }
+    bool isNullQ() const { return nulled; }
 private:
     bool nulled=true;
     T val;
@@ -772,5 +904,71 @@ private:
 
 template <class T>
 Nullable<T> NOT_SET() { return Nullable<T>(); }
+
+/**
+ * An STL allocator that returns memory aligned to an ALIGN-byte boundary (e.g. a cache line).
+ * In C++17, this can be replaced with aligned operator new.
+ * @tparam T The type being allocated
+ * @tparam ALIGN The alignment in bytes; must be a power of two and a multiple of sizeof(void *)
+ */
+template <class T, size_t ALIGN>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+
+    template <class U>
+    struct rebind { typedef AlignedAllocator<U, ALIGN> other; };
+
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, ALIGN>&) {}
+
+    T *allocate(size_t num) {
+        void *mem = nullptr;
+        if (posix_memalign(&mem, ALIGN, num * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T *>(mem);
+    }
+
+    void deallocate(T *mem, size_t) { free(mem); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, ALIGN>&) const { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, ALIGN>&) const { return false; }
+};
+
+/**
+ * @param requested A requested number of worker threads, or 0 for one per hardware thread
+ * @param work The number of work items to be shared among the threads
+ * @param minPerThread The fewest work items worth starting a thread for
+ * @return the number of threads to use, at least 1
+ */
+inline size_t numWorkers(size_t requested, size_t work, size_t minPerThread) {
+    if (requested == 0)
+        requested = std::max(1u, std::thread::hardware_concurrency());
+    size_t useful = std::max((size_t) 1, work / std::max((size_t) 1, minPerThread));
+    return std::min(requested, useful);
+}
+
+/**
+ * Splits [0, size) into numThreads contiguous slices and runs func on each slice in its own thread.
+ * Returns once every slice is done.
+ * @param size The number of work items
+ * @param numThreads The number of slices; the calling thread runs the last one
+ * @param func Called as func(first, last, slice) for the items [first, last) of the slice-th slice
+ */
+inline void parallelFor(size_t size, size_t numThreads, const std::function<void(size_t, size_t, size_t)> &func) {
+    vector<std::thread> workers;
+    for (size_t ii = 0; ii < numThreads; ii++) {
+        size_t first = size * ii / numThreads, last = size * (ii + 1) / numThreads;
+        if (ii + 1 == numThreads)
+            func(first, last, ii);
+        else
+            workers.emplace_back(func, first, last, ii);
+    }
+    for (auto &worker : workers)
+        worker.join();
+}
 #endif	/* AUX_H */
 
@@ -52,7 +52,8 @@ enum class SYNC_TYPE : byte {
   FullSync,
   IBLTSync,
   IBLTSync_HalfRound,
-  IBLTSync_Multiset
+  IBLTSync_Multiset,
+  RatelessIBLTSync
 };
 
 // ... Error constants
@@ -0,0 +1,62 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   MappedFile.h
+ * A file mapped into memory, so that a data structure stored in it is updated in place and outlives the process.
+ * Changes reach the file as the kernel writes the mapped pages back, and at the latest on flush or destruction.
+ */
+
+#ifndef CPISYNC_MAPPEDFILE_H
+#define CPISYNC_MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <CPISync/Aux/ConstantsAndTypes.h>
+
+using std::string;
+
+class MappedFile {
+public:
+    /**
+     * Maps a file into memory, creating it if it does not exist.
+     * A file of any size other than the requested one is truncated or zero-extended to that size.
+     * @param fileName The path of the file
+     * @param size The number of bytes to map; must be positive
+     */
+    MappedFile(const string &fileName, size_t size);
+
+    // Unmaps the file, after writing back any changes
+    ~MappedFile();
+
+    // A mapping has a single owner
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // @return the first mapped byte, aligned to a page
+    byte *data() { return mem; }
+    const byte *data() const { return mem; }
+
+    // @return the number of mapped bytes
+    size_t size() const { return len; }
+
+    // @return true iff the file did not exist, or had a different size, so that its contents are all zero
+    bool fresh() const { return isFresh; }
+
+    /**
+     * Writes changes back to the file, and waits until they are written.
+     * @param prefix Only the first prefix bytes are written back; by default, all of them
+     */
+    void flush(size_t prefix = SIZE_MAX);
+
+    // @return the name of the mapped file
+    const string &name() const { return fileName; }
+
+private:
+    string fileName;
+    byte *mem;
+    size_t len;
+    bool isFresh;
+};
+
+#endif //CPISYNC_MAPPEDFILE_H
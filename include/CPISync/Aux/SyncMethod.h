@@ -7,6 +7,7 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <unordered_map>
 #include <CPISync/Communicants/Communicant.h>
 
 // namespaces
@@ -70,17 +71,59 @@ public:
      * hash, so it is advisable not to change the datum dereference hereafter.
      * @return true iff the addition was successful
      */
-    virtual bool addElem(shared_ptr<DataObject> datum) { elements.push_back(datum); return true; };
+    virtual bool addElem(shared_ptr<DataObject> datum) {
+        positions.emplace(datum.get(), elements.size());
+        elements.push_back(datum);
+        return true;
+    };
+
+    /**
+     * Add a batch of elements to the data structure that will be performing the synchronization.
+     * Sync methods that can build their structures faster in bulk override this; by default, each datum is added with addElem.
+     * @param data The elements to add.
+     * @return true iff every addition was successful
+     */
+    virtual bool addElems(const vector<shared_ptr<DataObject>> &data) {
+        for (const auto &datum : data)
+            if (!addElem(datum))
+                return false;
+        return true;
+    };
 
     /**
      * Delete an element from the data structure that will be performing the synchronization.
+     * Each copy of the element is replaced by the last element, so that deletion takes constant time
+     * but changes the order in which the remaining elements are iterated.
      * @param datum The element to delete.
      * @return true iff the removal was successful
      */
-    virtual bool delElem(shared_ptr<DataObject> datum) { 
-        long int before = elements.size();
-        elements.erase(std::remove(elements.begin(), elements.end(), datum), elements.end());
-        return before > elements.size(); // true iff there were more elements before removal than after
+    virtual bool delElem(shared_ptr<DataObject> datum) {
+        auto found = positions.equal_range(datum.get());
+        if (found.first == found.second)
+            return false;
+
+        // remove the copies from the back, so that the last element is never one still to be removed
+        vector<size_t> where;
+        for (auto iter = found.first; iter != found.second; ++iter)
+            where.push_back(iter->second);
+        positions.erase(found.first, found.second);
+        std::sort(where.rbegin(), where.rend());
+
+        for (size_t pos : where) {
+            size_t last = elements.size() - 1;
+            if (pos != last) {
+                // move the last element into the hole, updating its position
+                auto moved = positions.equal_range(elements[last].get());
+                for (auto iter = moved.first; iter != moved.second; ++iter)
+                    if (iter->second == last) {
+                        iter->second = pos;
+                        break;
+                    }
+                elements[pos] = std::move(elements[last]);
+            }
+            elements.pop_back();
+        }
+        return true;
     };
 
     // INFORMATIONAL
@@ -273,6 +316,7 @@ protected:
     
 private:
     vector<shared_ptr<DataObject>> elements; /** Pointers to the elements stored in the data structure. */
+    std::unordered_multimap<const DataObject *, size_t> positions; /** The index in elements of each element (of each copy, if added more than once). */
 };
 
 
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <list>
 #include <cerrno>
+#include <functional>
 #include <NTL/ZZ_p.h>
 #include <NTL/vec_ZZ_p.h>
 #include <CPISync/Aux/ConstantsAndTypes.h>
@@ -16,6 +17,8 @@
 #include <CPISync/Data/DataPriorityObject.h>
 #include <CPISync/Syncs/IBLT.h>
 #include <CPISync/Syncs/IBLTMultiset.h>
+#include <CPISync/Syncs/IBLTFlat.h>
+#include <CPISync/Syncs/StrataEstimator.h>
 #include <CPISync/Syncs/Cuckoo.h>
 
 // namespace imports
@@ -77,42 +80,56 @@ public:
      * @param eltSize The size of values of the IBLTs to be communicated
      * @param oneWay If true, only the IBLT parameters are sent to the other communicant,
      *  but no response is awaited.
+     * @param scheme The hash family of the IBLTs.  The legacy family is sent exactly as
+     *  versions without seeded hashing sent it, so it still interoperates with them.
      * @require an active connection via commConnect
-     * @return true iff common parameters were verified (i.e. other size and eltSize == our size and eltSize) or oneWay is true
+     * @return true iff common parameters were verified (i.e. other size, eltSize and scheme == ours) or oneWay is true
      */
-    bool establishIBLTSend(size_t size, size_t eltSize, bool oneWay = false);
+    bool establishIBLTSend(size_t size, size_t eltSize, bool oneWay = false,
+                           IBLTHashScheme scheme = IBLTHashScheme::Seeded);
 
     /**
     * Establishes common IBLT parameters with another connected Communicant.
     * @param size The size of the IBLTs to be communicated
     * @param eltSize The size of values of the IBLTs to be communicated
     * @param oneWay If true, verification of common parameters is sent to the other communicant.
+    * @param scheme The hash family of the IBLTs; a mismatch is reported through Logger::error.
     * @require an active connection via commConnect
-    * @return true iff common parameters were verified (i.e. other size and eltSize == our size and eltSize)
+    * @return true iff common parameters were verified (i.e. other size, eltSize and scheme == ours)
     */
-    bool establishIBLTRecv(size_t size, size_t eltSize, bool oneWay = false);
+    bool establishIBLTRecv(size_t size, size_t eltSize, bool oneWay = false,
+                           IBLTHashScheme scheme = IBLTHashScheme::Seeded);
 
     /**
      * Establishes common Cuckoo filter parameter with another
-     * connected Communicant.
+     * connected Communicant. The native Cuckoo hashes are marked too,
+     * so that a peer of an earlier version, which hashes otherwise,
+     * refuses the sync.
      * @param fngprtSize The size of the fingerprint in bits
      * @param bucketSize The size of the bucket in fingerprints
      * @param filterSize The size of the whole filter in buckets
      * @param maxKicks The maximum number of kicks in the Cuckoo filter
+     * @param deltaTransfer Whether filters are sent as deltas from the
+     * last one that the other Communicant received
      */
     bool establishCuckooSend(size_t fngprtSize, size_t bucketSize,
-                             size_t filterSize, size_t maxKicks);
+                             size_t filterSize, size_t maxKicks,
+                             bool deltaTransfer = false);
 
     /**
      * Establishes common Cuckoo filter parameter with another
-     * connected Communicant.
+     * connected Communicant. Refuses a peer that does not mark the
+     * native Cuckoo hashes, and reports it through Logger::error.
      * @param fngprtSize The size of the fingerprint in bits
      * @param bucketSize The size of the bucket in fingerprints
      * @param filterSize The size of the whole filter in buckets
      * @param maxKicks The maximum number of kicks in the Cuckoo filter
+     * @param deltaTransfer Whether filters are sent as deltas from the
+     * last one that the other Communicant received
      */
     bool establishCuckooRecv(size_t fngprtSize, size_t bucketSize,
-                             size_t filterSize, size_t maxKicks);
+                             size_t filterSize, size_t maxKicks,
+                             bool deltaTransfer = false);
 
     /**
     * Primitive for sending data over an existing connection.  All other sending methods
@@ -146,8 +163,9 @@ public:
      * Receive an IBLT together with its hashes
      * @param size the expected # entry for IBLT
      * @param eltSize size for elements stored in IBLT
+     * @param scheme The hash family used by the sender's IBLT
      * */
-    IBLT commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> eltSize);
+    IBLT commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> eltSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
 
     /**
      * Receive a Cuckoo filter.
@@ -242,6 +260,26 @@ public:
      */
     void commSend(const IBLT &iblt, bool sync = false);
 
+    /**
+     * Sends an IBLTMultiset.
+     * @param iblt The IBLTMultiset to send.
+     * @param sync Should be true iff EstablishModSend/Recv called and/or the receiver knows the IBLT's size and eltSize
+     */
+    void commSend(const IBLTMultiset &iblt, bool sync = false);
+
+    /**
+     * Sends an IBLTFlat, in the same format as an IBLT.
+     * @param iblt The IBLTFlat to send.
+     * @param sync Should be true iff EstablishModSend/Recv called and/or the receiver knows the IBLT's size and eltSize
+     */
+    void commSend(const IBLTFlat &iblt, bool sync = false);
+
+    /**
+     * Sends a strata estimator, one stratum IBLT after the other.
+     * @param se The estimator to send.
+     */
+    void commSend(const StrataEstimator &se);
+
     /**
      * Sends Cuckoo filter.
      * @param The Cuckoo filter to send.
@@ -324,8 +362,10 @@ public:
      * @param size The size of the IBLT to be received.  Must be >0 or NOT_SET.
      * @param eltSize The size of values of the IBLTs to be received.  Must be >0 or NOT_SET.
      * If parameters aren't set, the IBLT will be received successfully iff commSend(IBLT, false) was used to send the IBLT
+     * @param scheme The hash family used by the sender's IBLT.  It is not transmitted.
      */
-    IBLT commRecv_IBLT(Nullable<size_t> size=NOT_SET<size_t>(), Nullable<size_t> eltSize=NOT_SET<size_t>());
+    IBLT commRecv_IBLT(Nullable<size_t> size=NOT_SET<size_t>(), Nullable<size_t> eltSize=NOT_SET<size_t>(),
+                       IBLTHashScheme scheme=IBLTHashScheme::Seeded);
 
 
     /**
@@ -333,8 +373,27 @@ public:
      * @param size The size of the IBLT to be received.  Must be >0 or NOT_SET.
      * @param eltSize The size of values of the IBLTs to be received.  Must be >0 or NOT_SET.
      * If parameters aren't set, the IBLT will be received successfully iff commSend(IBLTMultiset, false) was used to send the IBLT
+     * @param scheme The hash family used by the sender's IBLT.  It is not transmitted.
      */
-    IBLTMultiset commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<size_t> eltSize);
+    IBLTMultiset commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<size_t> eltSize,
+                                       IBLTHashScheme scheme=IBLTHashScheme::Seeded);
+
+    /**
+     * Receives an IBLTFlat.  The peer may have sent either an IBLT or an IBLTFlat.
+     * @param size The size of the IBLT to be received.  Must be >0 or NOT_SET.
+     * @param eltSize The size of values of the IBLTs to be received.  Must be >0 or NOT_SET.
+     * If parameters aren't set, the IBLT will be received successfully iff commSend(IBLT[Flat], false) was used to send the IBLT
+     * @param scheme The hash family used by the sender's IBLT.  It is not transmitted.
+     */
+    IBLTFlat commRecv_IBLTFlat(Nullable<size_t> size=NOT_SET<size_t>(), Nullable<size_t> eltSize=NOT_SET<size_t>(),
+                               IBLTHashScheme scheme=IBLTHashScheme::Seeded);
+
+    /**
+     * Receives a strata estimator sent by commSend(StrataEstimator).
+     * @param eltSize The size of the elements in the estimator; must match the sender's
+     * @param scheme The hash family used by the sender's estimator.  It is not transmitted.
+     */
+    StrataEstimator commRecv_StrataEstimator(size_t eltSize, IBLTHashScheme scheme=IBLTHashScheme::Seeded);
 
     // Informational
 
@@ -378,6 +437,28 @@ public:
 protected:
 
     // METHODS
+    /**
+     * Sends the cells of an IBLT (IBLT, IBLTMultiset or IBLTFlat) as a length-prefixed byte sequence,
+     * the same bytes as commSend(ustring(iblt.toByteVector())).  Cells are serialized straight into
+     * a bounded buffer that is handed to the primitive commSend whenever it fills, so the full byte
+     * representation of the IBLT is never held in memory.
+     * @param iblt The IBLT whose cells are sent
+     * @param numCells The number of cells in iblt
+     * @param trailerSize The number of bytes that writeTrailer appends after the cells
+     * @param writeTrailer Writes the bytes that follow the cells, if any
+     */
+    template <class IBLTType>
+    void _commSendIBLTCells(const IBLTType &iblt, size_t numCells,
+                            size_t trailerSize = 0, std::function<byte *(byte *)> writeTrailer = nullptr);
+
+    /**
+     * Receives a length-prefixed byte sequence sent by _commSendIBLTCells, and has an IBLT parse it
+     * in place, without copying it to an intermediate buffer.
+     * @param iblt The IBLT (IBLT, IBLTMultiset or IBLTFlat) that parses the bytes; it must already be sized
+     */
+    template <class IBLTType>
+    void _commRecvIBLTCells(IBLTType &iblt);
+
     /**
      * Adds <numBytes> bytes to the transmitted byte logs
      * @param numBytes the number of bytes to add to the logs
@@ -404,6 +485,7 @@ protected:
     const static int unsigned XMIT_INT = sizeof(int); /** Number of characters with which to transmit an integer. */
     const static int unsigned XMIT_LONG = sizeof(long); /** Number of characters with which to transmit a long integer. */
     const static int unsigned XMIT_DOUBLE = sizeof(float); /** Number of characters with which to transmit a double. */
+    const static size_t IBLT_CHUNK_BYTES = 1 << 16; /** Number of bytes of IBLT cells buffered between primitive sends. */
 };
 
 #endif
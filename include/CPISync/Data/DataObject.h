@@ -85,6 +85,14 @@ public:
      * @return A ZZ encoding of the string
      */
     ZZ to_ZZ() const;
+
+    /**
+     * @param seed Selects a member of the hash family
+     * @return A seeded 64-bit hash of the contents, computed over the bytes of the buffer,
+     *         which are copied out of the ZZ first; without a heap allocation when
+     *         they fit seededHash's stack buffer
+     */
+    std::uint64_t hash64(std::uint64_t seed) const;
     
     /**
      * @return The string version of a copy of the contents this data object.
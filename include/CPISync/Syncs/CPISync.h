@@ -10,11 +10,25 @@
 #include <NTL/ZZ_pXFactoring.h>
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Aux/SyncMethod.h>
+#include <CPISync/Syncs/CharPolyEvals.h>
 
 // namespaces
 
 using namespace NTL;
 
+/*
+ * How CPISync interpolates the rational function whose zeroes and poles are the set differences.
+ *  Gaussian  - solves the linear system of the interpolation by Gaussian elimination,
+ *              in time cubic in the number of sample points (default)
+ *  Euclidean - rational reconstruction by the extended Euclidean algorithm on the polynomial through the samples,
+ *              in time quadratic in the number of sample points
+ * Both recover the same rational function, so peers need not use the same solver.
+ */
+enum class RatFuncSolver : byte {
+    Gaussian,
+    Euclidean
+};
+
 /**
  * Implements a data structure for storing mathematical multi-sets of data
  *    in a manner that is consistent with fast synchronization.
@@ -44,12 +58,14 @@ public:
    * @param redundant The number of redundant points used for verification.  If this is zero,
    *    then this redundancy is computed directly from the allowed probability of error.
    * @param hashes Should data be stored as is, or first reduced via a hash
+   * @param solver The method used to interpolate the rational function of the differences
    * 
    *    Internal parameters are tweaked to guarantee this, subject to an assumption
    *    that an internal hash does not collide, and that there be at least 2 items
    *    in the union of the two sets that are being synchronized int.
    */
-  CPISync(long m_bar, long bits, int epsilon, int redundant = 0, bool hashes = false);
+  CPISync(long m_bar, long bits, int epsilon, int redundant = 0, bool hashes = false,
+          RatFuncSolver solver = RatFuncSolver::Gaussian);
 
   /**
    * General class destructor
@@ -94,11 +110,53 @@ public:
    * @requires A connection to the other Communicant must already be present.
    */
   static void receiveAllElem(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &otherMinusSelf);
+
+  // The steps of a synchronization, for callers that batch the synchronization of many CPISync objects
+  // into fewer round trips (e.g. InterCPISync).
+
+  /**
+   * Sends the set size and characteristic polynomial evaluations with which SyncClient starts, without waiting for a reply.
+   * @param commSync The Communicant to which to send.
+   */
+  void sendEvals(const shared_ptr<Communicant>& commSync);
+
+  /**
+   * Reconciles with a set whose size and evaluations were sent by sendEvals, as SyncServer does, including the
+   * check against the redundant evaluations.
+   * @param otherSetSize The size of the other set
+   * @param otherEvals The evaluations of the other set
+   * @param delta_self Receives the hashes of the elements that only this set has
+   * @param delta_other Receives the hashes of the elements that only the other set has
+   * @param more True iff otherEvals are those of the last call with more evaluations appended, as in the rounds of
+   *    probabilistic CPISync, so that the work on the earlier evaluations is not repeated
+   * @return true iff the reconciliation succeeded
+   */
+  bool reconcileEvals(long otherSetSize, const vec_ZZ_p &otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other,
+                      bool more = false);
+
+  /**
+   * Sends the elements with the given hashes, as needed for the other side to recover them, and adds them to selfMinusOther.
+   * Nothing is sent for trivial hashes (hashQ == false), since the other side recovers the elements from their hashes.
+   * @require the hashes are of elements of this set
+   * @throws SyncFailureException if an element is not found
+   */
+  void sendElems(const shared_ptr<Communicant>& commSync, const vec_ZZ_p &hashes, list<shared_ptr<DataObject>> &selfMinusOther);
+
+  /**
+   * Receives the elements with the given hashes, as sent by sendElems, and adds them to otherMinusSelf.
+   */
+  void recvElems(const shared_ptr<Communicant>& commSync, const vec_ZZ_p &hashes, list<shared_ptr<DataObject>> &otherMinusSelf);
   /*
    ** update metadata when an element is being added
    */
   bool addElem(shared_ptr<DataObject> newDatum) override;
 
+  /**
+   * Adds a batch of elements, updating the characteristic polynomial evaluations for all of them at once.
+   * The result is the same as adding the elements one by one.
+   */
+  bool addElems(const vector<shared_ptr<DataObject>> &data) override;
+
   template <typename T>
   bool addElem(T* newDatum) {
       auto newDO = make_shared<DataObject>(*newDatum);
@@ -121,6 +179,13 @@ public:
 
   
 protected:
+  /**
+   * Constructs an empty CPISync with the parameters of another, sharing its sample points rather than recomputing
+   * them and the field (whose search for a prime dominates the cost of constructing a CPISync).
+   * @param params The CPISync whose parameters to use
+   */
+  explicit CPISync(const CPISync *params);
+
   // internal data
   bool probCPI{}; /** If true, then CPISync actually operates using the probabilistic CPISync protocol, wherein
                       *  the presumed number of differences is doubled until a correct upper bound is found.
@@ -151,6 +216,10 @@ protected:
   long currDiff; /** The number of differences currently being synchronization. (initially set by the constructor) - for iterative methods. */
   int redundant_k; /** the number of redundant samples of the characteristic polynomial to evaluate.
                          *  This relates to the probability of error for the synchronization. */
+  RatFuncSolver ratFuncSolver; /** The method used by ratFuncInterp to interpolate the rational function. */
+  vec_ZZ_p ratFuncEvals; /** The other set's evaluations divided by ours, kept across the rounds of a synchronization
+                          *  so that each round of probabilistic CPISync divides only its new evaluations. */
+  vector<vec_ZZ_p> locPowers; /** locPowers[ii][jj] is sampleLoc[ii]^jj, as far as ratFuncInterp has needed it. */
 
   map< ZZ, shared_ptr<DataObject> > CPI_hash; /** list of pairs, one for each element in the set (to be synchronized).
                                            *  The first item in the pair is a hash (a long integer) 
@@ -158,6 +227,10 @@ protected:
                                            *  All operations are done on the hashes, and this look-up table can be used to retrieve
                                            *  the actual element once the hashes have been synchronized.
                                            */
+  std::unordered_multimap<const DataObject *, ZZ> CPI_hashOf; /** The reverse of CPI_hash:  the hash of each element
+                                           *  (of each copy, if added more than once), so that elements can be deleted
+                                           *  without searching CPI_hash.
+                                           */
 
   // helper functions
 
@@ -190,11 +263,19 @@ protected:
    */
   bool ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec);
 
+  /**
+   * @return sampleLoc[ii]^exp, from locPowers, which it extends as needed.  The Vandermonde matrices of successive
+   *    rounds share their powers, so each power is computed once, with one multiplication.
+   */
+  const ZZ_p &_locPower(long ii, long exp);
+
   /**
    * Simultaneously finds the roots of two polynomials (that correspond to the numerator and denominator, respectively
    * of an interpolated rational function.
    * 
    * @requires P_vec and Q_vec must be monic (not checked) and square-free (checked)
+   * @note Since the polynomials should split into distinct linear factors, their roots are found by equal-degree
+   *    splitting, rather than by factoring them in general.
    * @param P_vec The first polynomial whose roots are to be found.
    * @param Q_vec The second polynomial whose roots are to be found.
    * @param numerator Returns a list of roots of the P_vec polynomial.
@@ -205,6 +286,15 @@ protected:
    */
   static bool find_roots(vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec, vec_ZZ_p& numerator, vec_ZZ_p& denominator);
 
+  /**
+   * Finds the roots of a polynomial that should be a product of distinct linear factors.
+   * @requires poly must be monic and square-free
+   * @param poly The polynomial whose roots are to be found.
+   * @param roots Set to the roots of poly, in no particular order.
+   * @return true iff poly is a product of linear factors, so that roots are all of its roots.
+   */
+  static bool _splitRoots(const ZZ_pX& poly, vec_ZZ_p& roots);
+
 
   /**
    * Reconciles the set represented by this object with the another set of
@@ -220,7 +310,7 @@ protected:
    */
   bool set_reconcile(long otherSetSize, const vec_ZZ_p& otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other);
 
-  vec_ZZ_p CPI_evals; /** The ii-th entry of this vector is the evaluation of this data structure's characteristic
+  unique_ptr<CharPolyEvals> CPI_evals; /** The ii-th entry is the evaluation of this data structure's characteristic
                         * polynomial at the ii-th sample point. */
   ZZ DATA_MAX; /** Set elements must be within the range 0..data_max-1.  Sample locations are taken between data_max and ZZ_p::modulus() */
 
@@ -244,6 +334,18 @@ protected:
   void RecvSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay = false) override ;
 
 private:
+  /**
+   * Interpolates the rational function of ratFuncInterp by rational reconstruction:  with U the polynomial through
+   * the evaluations and V the polynomial vanishing on their sample locations, the numerator P and denominator Q
+   * satisfy P = U*Q mod V, and are found among the remainders and cofactors of the extended Euclidean algorithm on V and U.
+   * The parameters are those of ratFuncInterp, except for:
+   * @param mAbar The degree of the numerator, as bounded by ratFuncInterp
+   * @param mBbar The degree of the denominator, as bounded by ratFuncInterp
+   * @return true iff a rational function with monic numerator and denominator, whose degrees differ by mAbar - mBbar,
+   *    meets the evaluations.  P_vec and Q_vec are then monic, possibly of degrees lower than mAbar and mBbar.
+   */
+  bool _ratFuncInterpEuclid(const vec_ZZ_p& evals, long mAbar, long mBbar, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) const;
+
   /**
    * Computes a hash of the given datum of size bit_num, used internally within CPISync.
    * Initial synchronization actually occurs only on these hashes.
@@ -255,6 +357,14 @@ private:
    */
   ZZ_p _hash(const shared_ptr<DataObject>&datum) const;
 
+  /**
+   * Enters a new element into CPI_hash, under a hash not used by any other element.
+   * @param datum The element to enter
+   * @param hashID Set to the hash of the element, which must then be added to CPI_evals
+   * @return true iff the element could be entered; under the noHash option, duplicates cannot be
+   */
+  bool _insertHash(const shared_ptr<DataObject> &datum, ZZ_p &hashID);
+
   /**
    * Inverts the hash above when the noHash boolean is set
    */
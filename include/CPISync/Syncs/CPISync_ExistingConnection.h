@@ -25,6 +25,12 @@ public:
     	SyncID = SYNC_TYPE::CPISync_ExistingConnection;
     }
     
+    /**
+     * Constructs an empty CPISync_ExistingConnection with the parameters of another, without recomputing them.
+     * @see CPISync::CPISync(const CPISync *)
+     */
+    explicit CPISync_ExistingConnection(const CPISync_ExistingConnection *params) : CPISync(params) {}
+
     string getName() override {return CPISync::getName() + "\n   * assuming an existing connection";}
 };
 
@@ -0,0 +1,203 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   CharPolyEvals.h
+ * Evaluations of a set's characteristic polynomial at fixed sample points, as kept by CPISync.
+ * Every element added or removed multiplies or divides each evaluation by (sample point - element),
+ * so the field arithmetic here is the main cost of filling a CPISync.
+ *
+ * The evaluations are templated on the field arithmetic:
+ *  ZZpField   - NTL's multiprecision ZZ_p, for any modulus
+ *  WordField  - Montgomery arithmetic on single 64-bit words, for odd moduli below 2^WordField::MAX_BITS
+ * CharPolyEvals::make picks WordField whenever the modulus fits.
+ *
+ * Adding many elements at once with addAll converts them into the field once, and splits the sample points
+ * among threads.  Within a thread, the products for different sample points are independent, so they
+ * overlap in the processor's pipeline.
+ */
+
+#ifndef CPISYNC_CHARPOLYEVALS_H
+#define CPISYNC_CHARPOLYEVALS_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <NTL/ZZ_p.h>
+#include <NTL/vec_ZZ_p.h>
+#include <CPISync/Aux/Auxiliary.h>
+
+using namespace NTL;
+using std::vector;
+using std::unique_ptr;
+using std::shared_ptr;
+
+class CharPolyEvals {
+public:
+    virtual ~CharPolyEvals() = default;
+
+    /**
+     * @param sampleLoc The sample points, in the current ZZ_p field
+     * @return evaluations of the characteristic polynomial of the empty set (i.e. all 1) at sampleLoc,
+     *      in the fastest field arithmetic that fits ZZ_p::modulus()
+     */
+    static unique_ptr<CharPolyEvals> make(const vec_ZZ_p &sampleLoc);
+
+    // @return evaluations of the empty set at the same sample points, which the two share rather than copy
+    virtual unique_ptr<CharPolyEvals> emptyCopy() const = 0;
+
+    // Multiplies each evaluation by (sample point - root), i.e. adds root to the set
+    virtual void add(const ZZ_p &root) = 0;
+
+    /**
+     * Multiplies each evaluation by (sample point - root) for every root, i.e. adds all of roots to the set.
+     * The result is the same as adding the roots one by one.
+     * @param roots The elements to add
+     * @param numThreads The number of threads to use, or 0 for one per hardware thread; word-sized
+     *      arithmetic only, since NTL keeps the ZZ_p modulus of each thread separately
+     */
+    virtual void addAll(const vector<ZZ_p> &roots, size_t numThreads = 0) = 0;
+
+    // Divides each evaluation by (sample point - root), i.e. removes root from the set
+    // @require root is not a sample point
+    virtual void remove(const ZZ_p &root) = 0;
+
+    // @return the ii-th evaluation, as a ZZ_p
+    virtual ZZ_p get(long ii) const = 0;
+
+    // @return the number of sample points
+    virtual long length() const = 0;
+
+    // @return true iff the evaluations use single-word arithmetic
+    virtual bool wordSized() const = 0;
+};
+
+/**
+ * The field of ZZ_p::modulus(), in NTL's multiprecision arithmetic.
+ */
+class ZZpField {
+public:
+    typedef ZZ_p Elem;
+    static const bool WORD_SIZED = false;
+
+    Elem from(const ZZ_p &x) const { return x; }
+    ZZ_p to(const Elem &x) const { return x; }
+    Elem one() const { return to_ZZ_p(1); }
+    Elem sub(const Elem &a, const Elem &b) const { return a - b; }
+    Elem mul(const Elem &a, const Elem &b) const { return a * b; }
+    Elem inv(const Elem &a) const { return NTL::inv(a); }
+};
+
+#ifdef __SIZEOF_INT128__
+/**
+ * The field of an odd prime modulus below 2^MAX_BITS, with elements held in Montgomery form (x * 2^64 mod p)
+ * so that a product is two word multiplications and a shift, instead of a multiprecision division.
+ */
+class WordField {
+public:
+    typedef std::uint64_t Elem;
+    static const bool WORD_SIZED = true;
+
+    // The largest modulus, in bits, for which sums in the Montgomery reduction cannot overflow
+    static const long MAX_BITS = 63;
+
+    // @require modulus is an odd prime below 2^MAX_BITS
+    explicit WordField(const ZZ &modulus);
+
+    Elem from(const ZZ_p &x) const { return mul(to_ulong(rep(x)), r2); }
+    ZZ_p to(const Elem &x) const { return to_ZZ_p(to_ZZ((unsigned long) _reduce(x))); }
+    Elem one() const { return r1; }
+    Elem sub(Elem a, Elem b) const { return a >= b ? a - b : a + p - b; }
+    Elem mul(Elem a, Elem b) const { return _reduce((unsigned __int128) a * b); }
+    Elem inv(Elem a) const;
+
+private:
+    // @return x / 2^64 mod p, for x < p * 2^64
+    Elem _reduce(unsigned __int128 x) const {
+        std::uint64_t m = (std::uint64_t) x * pNeg;
+        auto res = (std::uint64_t) ((x + (unsigned __int128) m * p) >> 64);
+        return res >= p ? res - p : res;
+    }
+
+    std::uint64_t p;    /** the modulus */
+    std::uint64_t pNeg; /** -1/p mod 2^64 */
+    std::uint64_t r1;   /** 2^64 mod p, i.e. 1 in Montgomery form */
+    std::uint64_t r2;   /** 2^128 mod p, which takes an element into Montgomery form */
+};
+#endif
+
+/**
+ * Characteristic polynomial evaluations in the arithmetic of Field.
+ */
+template <class Field>
+class FieldCharPolyEvals : public CharPolyEvals {
+public:
+    FieldCharPolyEvals(const Field &field, const vec_ZZ_p &sampleLoc) : field(field) {
+        vector<typename Field::Elem> points;
+        for (const ZZ_p &loc : sampleLoc)
+            points.push_back(field.from(loc));
+        locs = std::make_shared<const vector<typename Field::Elem>>(std::move(points));
+        evals.assign(locs->size(), field.one());
+    }
+
+    unique_ptr<CharPolyEvals> emptyCopy() const override {
+        return unique_ptr<CharPolyEvals>(new FieldCharPolyEvals(field, locs));
+    }
+
+    void add(const ZZ_p &root) override {
+        typename Field::Elem elem = field.from(root);
+        const auto &loc = *locs;
+        for (size_t ii = 0; ii < evals.size(); ii++)
+            evals[ii] = field.mul(evals[ii], field.sub(loc[ii], elem));
+    }
+
+    void addAll(const vector<ZZ_p> &roots, size_t numThreads) override {
+        vector<typename Field::Elem> elems;
+        elems.reserve(roots.size());
+        for (const ZZ_p &root : roots)
+            elems.push_back(field.from(root));
+
+        numThreads = Field::WORD_SIZED ? numWorkers(numThreads, evals.size() * elems.size(), MIN_BULK_PER_THREAD) : 1;
+        const auto &loc = *locs;
+        parallelFor(evals.size(), numThreads, [&](size_t first, size_t last, size_t) {
+            for (const auto &elem : elems)
+                for (size_t ii = first; ii < last; ii++)
+                    evals[ii] = field.mul(evals[ii], field.sub(loc[ii], elem));
+        });
+    }
+
+    void remove(const ZZ_p &root) override {
+        // invert all of the factors with one field inversion:  prefix[ii] is the product of the first ii factors
+        typename Field::Elem elem = field.from(root);
+        const auto &loc = *locs;
+        vector<typename Field::Elem> prefix(evals.size() + 1);
+        prefix[0] = field.one();
+        for (size_t ii = 0; ii < evals.size(); ii++)
+            prefix[ii + 1] = field.mul(prefix[ii], field.sub(loc[ii], elem));
+
+        typename Field::Elem invPrefix = field.inv(prefix[evals.size()]); // the inverse of prefix[ii + 1]
+        for (size_t ii = evals.size(); ii-- > 0;) {
+            typename Field::Elem factor = field.sub(loc[ii], elem);
+            evals[ii] = field.mul(evals[ii], field.mul(invPrefix, prefix[ii]));
+            invPrefix = field.mul(invPrefix, factor);
+        }
+    }
+
+    ZZ_p get(long ii) const override { return field.to(evals[ii]); }
+
+    long length() const override { return (long) evals.size(); }
+
+    bool wordSized() const override { return Field::WORD_SIZED; }
+
+    // The fewest field multiplications for which addAll starts another thread
+    static const size_t MIN_BULK_PER_THREAD = 1 << 16;
+
+private:
+    FieldCharPolyEvals(const Field &field, const shared_ptr<const vector<typename Field::Elem>> &locs) :
+            field(field), locs(locs), evals(locs->size(), field.one()) {}
+
+    Field field;
+    shared_ptr<const vector<typename Field::Elem>> locs; /** the sample points, shared with any empty copies */
+    vector<typename Field::Elem> evals; /** the evaluation at each sample point */
+};
+
+#endif //CPISYNC_CHARPOLYEVALS_H
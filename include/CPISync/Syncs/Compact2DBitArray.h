@@ -12,6 +12,15 @@
  * - bucket can be thought of as a row in the table,
  * - entry can be thought of as a cell in the table,
  * - fingerprint can be thought of as the data that is written to the cell.
+ *
+ * Entries are packed back to back, with no bits between them. For the
+ * common fingerprint sizes of 8, 12 and 16 bits, an array whose bucket
+ * fits in 64 bits instead keeps each bucket in a word of its own, so
+ * that entries are read and written with a shift and a whole bucket is
+ * searched at once. The word is 32 bits wide for buckets that fit in
+ * 32 bits, such as 4 entries of 8 bits, so that the word layout takes
+ * at most twice the packed one. getRaw and the reconstruction
+ * constructor always use the packed layout.
  */
 
 #ifndef COMPACT2DBITARRAY_H
@@ -20,6 +29,7 @@
 #include <cmath>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <CPISync/Aux/Auxiliary.h>
 
@@ -43,10 +53,36 @@ public:
 
     /**
      * Reconstruction constructor
+     * @param f The content in the packed layout, as returned by getRaw
      */
     Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
                       size_t NumOfBuckets, vector<unsigned char> f);
 
+    /**
+     * Constructs an array over storage that it does not own, such as a
+     * memory-mapped file. The array starts with the current content of
+     * the storage, and always uses the packed layout.
+     * @param external storageBytes(fingerprintSize, bucketSize,
+     * NumOfBuckets) bytes that outlive the array
+     */
+    Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
+                      size_t NumOfBuckets, unsigned char *external);
+
+    /**
+     * Copies own their storage, even when the original does not.
+     */
+    Compact2DBitArray(const Compact2DBitArray &other);
+    Compact2DBitArray &operator=(const Compact2DBitArray &other);
+    Compact2DBitArray(Compact2DBitArray &&other) noexcept;
+    Compact2DBitArray &operator=(Compact2DBitArray &&other) noexcept;
+
+    /**
+     * @return The number of bytes of storage of an array with the given
+     * dimensions
+     */
+    static size_t storageBytes(size_t fingerprintSize, size_t bucketSize,
+                               size_t NumOfBuckets);
+
     /**
      * @param bucketIdx The index of a bucket (row)
      * @param entryIdx The index of an entry in the bucket (column)
@@ -61,6 +97,30 @@ public:
      */
     void setEntry(size_t bucketIdx, size_t entryIdx, unsigned f);
 
+    /**
+     * Compares all entries of a bucket with a fingerprint in one pass
+     * over the bits of the bucket.
+     * @param bucketIdx The index of the bucket (row)
+     * @param f The fingerprint to look for. 0 finds an empty entry.
+     * @return The index of the first entry that holds f, or null if
+     * no entry does
+     */
+    Nullable<size_t> findEntry(size_t bucketIdx, unsigned f) const;
+
+    /**
+     * Hints the processor to start loading a bucket into its cache, so
+     * that a later access to it need not wait for memory.
+     * @param bucketIdx The index of the bucket (row)
+     */
+    void prefetch(size_t bucketIdx) const {
+        if (!words.empty())
+            __builtin_prefetch(&words[bucketIdx]);
+        else if (!narrowWords.empty())
+            __builtin_prefetch(&narrowWords[bucketIdx]);
+        else
+            __builtin_prefetch(raw + fSize * bSize * bucketIdx / BYTE);
+    }
+
     /**
      * Get fingerprint size
      */
@@ -77,7 +137,7 @@ public:
     size_t getRows() const;
 
     /**
-     * Get the raw content of the array
+     * Get the raw content of the array, in the packed layout
      */
     vector<unsigned char> getRaw() const;
 
@@ -92,31 +152,88 @@ public:
     ~Compact2DBitArray() = default;
 
     /**
-     * Storage of a Compact2DBitArray
+     * Storage of a Compact2DBitArray, unless it is external
      */
     vector<unsigned char> store;
 
+    /**
+     * The first byte of the storage, whether in store or external, or
+     * null in the word layout
+     */
+    unsigned char *raw = nullptr;
+
+    /**
+     * Storage in the word layout: bucket ii in words[ii], with entry jj
+     * in bits [jj * fSize, (jj + 1) * fSize). Empty in the packed layout,
+     * and for buckets of at most 32 bits.
+     */
+    vector<std::uint64_t> words;
+
+    /**
+     * Storage in the word layout for buckets of at most 32 bits, laid
+     * out as words. Empty otherwise.
+     */
+    vector<std::uint32_t> narrowWords;
+
+    /**
+     * @return Whether an array with the given dimensions that owns its
+     * storage uses the word layout
+     */
+    static bool wordLayout(size_t fingerprintSize, size_t bucketSize) {
+        return (fingerprintSize == 8 || fingerprintSize == 12 || fingerprintSize == 16)
+               && fingerprintSize * bucketSize <= 64;
+    }
+
 private:
 
     /**
      * Fingerprint size in bits
      */
-    size_t fSize;
+    size_t fSize = 0;
 
     /**
      * Fingerprint size in bytes
      */
-    unsigned short fSizeB;
+    unsigned short fSizeB = 0;
 
     /**
      * Bucket size (number of columns)
      */
-    size_t bSize;
+    size_t bSize = 0;
+
+    /**
+     * In the word layout, a bucket with 1 in every entry
+     */
+    std::uint64_t laneOnes = 0;
+
+    /**
+     * @return Whether the array uses the word layout, of either width
+     */
+    bool _inWords() const {
+        return !words.empty() || !narrowWords.empty();
+    }
+
+    /**
+     * @return In the word layout, the bucket bucketIdx
+     */
+    std::uint64_t _word(size_t bucketIdx) const {
+        return words.empty() ? narrowWords[bucketIdx] : words[bucketIdx];
+    }
+
+    /**
+     * Sets, in the word layout, the bucket bucketIdx to w
+     */
+    void _setWord(size_t bucketIdx, std::uint64_t w) {
+        if (words.empty())
+            narrowWords[bucketIdx] = std::uint32_t(w);
+        else
+            words[bucketIdx] = w;
+    }
 
     /**
      * Number of buckets in filter (number of rows)
      */
-    size_t nBuckets;
+    size_t nBuckets = 0;
 
     /**
      * Boundary checks for getEntry and setEntry
@@ -138,6 +255,17 @@ private:
      */
     inline void _constructorGuards() const;
 
+    /**
+     * Switches an array that owns its storage to the word layout, with
+     * all entries 0
+     */
+    void _useWords();
+
+    /**
+     * Copies every entry of an array with the same dimensions
+     */
+    void _copyEntries(const Compact2DBitArray &from);
+
     /**
      * Auxiliary data used by both getEntry and setEntry to describe
      * the position of the certain entry in Compact2DBitArray that is
@@ -7,6 +7,10 @@
  *
  * Implementation of Cuckoo filters based on
  * https://www.cs.cmu.edu/~dga/papers/cuckoo-conext2014.pdf
+ *
+ * A filter can be kept in a memory-mapped snapshot file that is updated
+ * in place, so that a restarted process resumes it instead of inserting
+ * every element again.
  */
 
 #ifndef CUCKOO_H
@@ -16,11 +20,13 @@
 #include <random>
 #include <functional>
 #include <stack>
+#include <memory>
 #include <NTL/ZZ.h>
 #include <CPISync/Data/DataObject.h>
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Syncs/Compact2DBitArray.h>
 #include <CPISync/Aux/Serializable.h>
+#include <CPISync/Aux/MappedFile.h>
 
 using std::vector;
 using std::shared_ptr;
@@ -29,6 +35,7 @@ using std::runtime_error;
 using namespace NTL;
 
 class Cuckoo : public Serializable {
+    friend class CuckooTest;
 public:
 
     /**
@@ -39,7 +46,9 @@ public:
 
     /**
      * Constructs an empty cuckoo filter with certain fingerprint, bucket and
-     * overall size.
+     * overall size. Uses the native hashes, which hash the bytes of an
+     * element into a machine word once and take the fingerprint and both
+     * buckets from it without any ZZ or string conversion.
      * @param fngprntSize The fingerprint size in bits.
      * @param bucketSize The size of bucket in fingerprits.
      * @param size The overall size of the Cuckoo filter in buckets.
@@ -54,7 +63,13 @@ public:
     typedef std::function<ZZ(const ZZ&, size_t)> hash_impl_t;
 
     /**
-     * Constructs an empty cuckoo filter the following parameters:
+     * Constructs an empty cuckoo filter with custom fingerprint and hash
+     * functions, in place of the native ones. The alternative bucket of
+     * a fingerprint f in bucket i is (i xor hash(f)) % size, which is
+     * only suitable for hashes under which that is symmetric.
+     * A filter that is received, or kept in a snapshot file, uses the
+     * native hashes, so a filter with custom functions cannot be sent:
+     * toByteVector and deltaToByteVector throw CuckooFilterError.
      * @param fngprntSize The fingerprint size in bits.
      * @param bucketSize The size of bucket in fingerprits.
      * @param size The overall size of the Cuckoo filter in buckets.
@@ -89,12 +104,51 @@ public:
      */
     Cuckoo(size_t capacity, float err);
 
+    /**
+     * Opens a cuckoo filter, with the default fingerprint and hash
+     * functions, kept in a memory-mapped snapshot file that inserts and
+     * erases update in place. If the file holds a filter of the same
+     * sizes that has not changed since it was last flushed, the filter
+     * is resumed as it is (see resumed()). Otherwise the file is reset
+     * to an empty filter, and the caller should insert its elements
+     * again.
+     * @param fileName The snapshot file. Created if it does not exist.
+     * @param fngprntSize The fingerprint size in bits.
+     * @param bucketSize The size of bucket in fingerprits.
+     * @param size The overall size of the Cuckoo filter in buckets.
+     * @param maxKicks The maximum number of kicks.
+     */
+    Cuckoo(const string& fileName, size_t fngprtSize, size_t bucketSize,
+           size_t size, size_t maxKicks);
+
+    /**
+     * Copies are held in memory, whether or not the original is kept
+     * in a snapshot file.
+     */
+    Cuckoo(const Cuckoo& other);
+    Cuckoo& operator=(const Cuckoo& other);
+    Cuckoo(Cuckoo&& other) noexcept;
+    Cuckoo& operator=(Cuckoo&& other) noexcept;
 
     /**
-     * Default destructor
+     * Destructor. Flushes the snapshot file, if any.
      */
     ~Cuckoo();
 
+    /**
+     * @return Whether this filter was resumed from its snapshot file,
+     * rather than started empty.
+     */
+    bool resumed() const;
+
+    /**
+     * Writes the filter back to its snapshot file and marks the snapshot
+     * as consistent, so that it can be resumed after a restart, even an
+     * unclean one, as long as it is not changed in between. Does nothing
+     * if the filter is held in memory.
+     */
+    void flush();
+
     /**
      * Inserts an element in the Cuckoo filter. Returns false when the
      * filter is considered full.
@@ -108,6 +162,23 @@ public:
      */
     bool lookup(const DataObject& datum) const;
 
+    /**
+     * Queries the cuckoo filter for a batch of elements. Elements are
+     * hashed a block at a time, and the candidate buckets of the whole
+     * block are prefetched before any of them is searched, so that the
+     * cache misses of a large filter overlap. The batch is split among
+     * threads, so the fingerprint and hash functions must be safe to
+     * call concurrently, as the default ones are.
+     * @param first The first element to look up
+     * @param last Just past the last element to look up
+     * @param numThreads The number of threads to use, or 0 for one per
+     * hardware thread
+     * @return found[ii] is nonzero iff lookup(*first[ii])
+     */
+    vector<unsigned char> lookupAll(vector<shared_ptr<DataObject>>::const_iterator first,
+                                    vector<shared_ptr<DataObject>>::const_iterator last,
+                                    size_t numThreads = 0) const;
+
     /**
      * Deletes the element. Returns false when there is no elements
      * that hashes to the same candidate buckets as the element being
@@ -158,18 +229,63 @@ public:
     /**
      * serialize cuckoo filter to a byte vector,
      * which can be deserialized by `fromByteVector`
+     * @require the filter uses the native hashes; throws
+     * CuckooFilterError otherwise
      * @return vector<byte> representation of cuckoo filter
      */
     vector<byte> toByteVector() const;
 
     /**
      * deserialize byte vector and construct cuckoo filter,
-     * complements function `toByteVector`
+     * complements function `toByteVector`. The result is held in memory,
+     * and a snapshot file that held the filter before is flushed and let go.
+     * Changes are no longer tracked.
      * @require buffer size can be at most UNSIGNED_LONG_MAX
      * @param buffer vector<byte> representation of cuckoo filter
      */
     void fromByteVector(vector<byte> buffer);
 
+    /**
+     * Starts or stops recording which buckets change, so that only
+     * those can be sent to a peer that has the rest (see
+     * deltaToByteVector). Either way, the record starts empty.
+     * @param on Whether to record changed buckets
+     */
+    void trackChanges(bool on);
+
+    /**
+     * @return Whether any bucket has changed since changes were last
+     * cleared. Always false when changes are not tracked.
+     */
+    bool hasChanges() const;
+
+    /**
+     * Forgets which buckets have changed, e.g. once they reached the peer.
+     */
+    void clearChanges();
+
+    /**
+     * Serializes the buckets that changed since changes were last
+     * cleared, and the item count, which can be applied with `applyDelta`
+     * to a copy of the filter as it was then. Each bucket index is
+     * written as a varint gap from the previous one, followed by the
+     * bucket's entries in ceil(fngprtSize / 8) little-endian bytes each.
+     * @require changes are tracked, and the filter uses the native
+     * hashes
+     * @return vector<byte> representation of the changes
+     */
+    vector<byte> deltaToByteVector() const;
+
+    /**
+     * Brings the filter up to date with a delta from `deltaToByteVector`.
+     * The delta is checked before any of it is applied, so a malformed
+     * one leaves the filter as it was.
+     * @require The filter has the same sizes, and the content of the
+     * sender's filter when its changes were last cleared.
+     * @param delta vector<byte> representation of the changes
+     */
+    void applyDelta(const vector<byte>& delta);
+
     /**
      * Maximum length of the cuckoo evictions chain
      */
@@ -181,6 +297,17 @@ public:
      */
     static const size_t MAX_FNGPRT_SIZE = Compact2DBitArray::MAX_F_BITS;
 
+    /**
+     * The number of elements that lookupAll hashes and prefetches
+     * before it searches their buckets
+     */
+    static const size_t LOOKUP_BLOCK = 16;
+
+    /**
+     * The fewest lookups for which lookupAll starts another thread
+     */
+    static const size_t MIN_LOOKUPS_PER_THREAD = 1 << 14;
+
 private:
 
     /**
@@ -214,9 +341,83 @@ private:
     ZZ itemsCount;
 
     /**
-     * Function used to calculate fingerprint of an entry. The
-     * provided function must assure that 0 fingerprint is treated as
-     * no fingeprint as described in fingerprint function docstring.
+     * The snapshot file holding the filter, or null if it is held in memory
+     */
+    std::unique_ptr<MappedFile> snapshot;
+
+    /**
+     * Whether the filter was resumed from the snapshot file
+     */
+    bool wasResumed = false;
+
+    /**
+     * Whether changed buckets are recorded
+     */
+    bool tracking = false;
+
+    /**
+     * isChanged[b] is nonzero iff bucket b is in changed
+     */
+    vector<unsigned char> isChanged;
+
+    /**
+     * The buckets changed since changes were last cleared, in the
+     * order of their first change
+     */
+    vector<size_t> changed;
+
+    /**
+     * Sets an entry of the filter, and records its bucket as changed if
+     * changes are tracked. All changes to the filter go through here.
+     * @param bucketIdx The bucket index
+     * @param entryIdx The entry index in the bucket
+     * @param f The fingerprint to put there
+     */
+    inline void _setEntry(size_t bucketIdx, size_t entryIdx, unsigned f);
+
+    /**
+     * Words of the snapshot file header, which precedes the filter.
+     */
+    enum SnapshotWord {
+        SNAP_MAGIC,
+        SNAP_FNGPRT_SIZE,
+        SNAP_BUCKET_SIZE,
+        SNAP_FILTER_SIZE,
+        SNAP_ITEMS,
+        SNAP_CLEAN,        // nonzero iff the filter has not changed since the last flush
+        SNAP_HEADER_WORDS = 8
+    };
+
+    /**
+     * Identifies (and versions) cuckoo filter snapshot files. Version 2
+     * has the native hashes, so version 1 files are not resumed.
+     */
+    static const std::uint64_t SNAPSHOT_MAGIC = 0x435049434b4f4f02ULL;
+
+    /**
+     * @return The header words of the snapshot file
+     */
+    std::uint64_t* _header() const {
+        return reinterpret_cast<std::uint64_t*>(snapshot->data());
+    }
+
+    /**
+     * Marks the snapshot, if any, as changed, and writes the mark back
+     * before the filter can change. Called before any change to the
+     * filter.
+     */
+    inline void _touch();
+
+    /**
+     * Writes the snapshot back, if any, and lets it go
+     */
+    void _close();
+
+    /**
+     * Function used to calculate fingerprint of an entry, or empty for
+     * the native hashes. The provided function must assure that 0
+     * fingerprint is treated as no fingeprint as described in
+     * fingerprint function docstring.
      */
     fingerprint_impl_t fingerprint_impl;
 
@@ -235,16 +436,14 @@ private:
     inline size_t fingerprint(const ZZ& e) const;
 
     /**
-     * Function used to calculate hash of an entry
+     * Function used to calculate hash of an entry, or empty for the
+     * native hashes
      */
     hash_impl_t hash_impl;
 
     /**
      * Delegate for hash_impl.
      * Computes the hash of a set element modulo filterSize.
-     * By default uses std::hash<std::string> specialization which
-     * if linked with libstdc++ uses Murmur hash
-     * https://github.com/gcc-mirror/gcc/blob/master/libstdc%2B%2B-v3/libsupc%2B%2B/hash_bytes.cc#L74
      * @param xx The set element.
      * @return The hash as ZZ.
      */
@@ -271,25 +470,30 @@ private:
      * One bit per fingerprint would incur a >12.5% space overhead.
      * @param bucketIdx The bucket index to be added to
      * @param f The fingerprint to be added
-     * @return The entry index where the fngprt is inserted
-     * @throws overflow_error if bucket is full.
+     * @return The entry index where the fngprt is inserted, or null
+     * if the bucket is full.
      */
-    inline size_t addToBucket(size_t bucketIdx, size_t f);
+    inline Nullable<size_t> addToBucket(size_t bucketIdx, size_t f);
 
     /**
+     * Compares all entries of the bucket with the fingerprint at
+     * once. A miss is the common case of a lookup, so it is not an
+     * exception.
      * @param f The fingerprint to search for.
      * @param bucket The bucket in which to search.
-     * @return Index of the fingerprint in the bucket.
-      * @throws range_error if the fingerprint is not found
+     * @return Index of the fingerprint in the bucket, or null if the
+     * fingerprint is not found.
      */
-    inline size_t findFingerprint(unsigned f, size_t bucket) const;
+    inline Nullable<size_t> findFingerprint(unsigned f, size_t bucket) const;
 
     /**
      * Calculate the alternative bucket for the given bucket and the fingerprint.
+     * With the native hashes, the alternative of the alternative is always
+     * the given bucket, whatever the filter size.
      * @param currentB The current bucket.
      * @param f The fingerprint.
      */
-    inline size_t _alternativeBucket(size_t currentB, size_t f) const;
+    size_t _alternativeBucket(size_t currentB, size_t f) const;
 
     /**
      * Partial hashing return values.
@@ -303,12 +507,13 @@ private:
     /**
      * Calculate the partial hash of the item.
      * @param datum The item to calculate partial hash for.
-     * TODO: for fngprtSize=7 (f=119), fitlerSize=5, bucketSize=4
+     * TODO: with custom functions,
+     * for fngprtSize=7 (f=119), fitlerSize=5, bucketSize=4
      * can end up in 0, 1, and can be kicked to 4 (from 0), instead of 1.
      * _alternativeBucket(1, 119) == 0, _alternativeBucket(0, 119) == 4.
      * This introduces false negatives and Cuckoo Filter should not have any.
      */
-    inline PartialHash _pHash(const DataObject& datum) const;
+    PartialHash _pHash(const DataObject& datum) const;
 
     /**
      * Auxiliary structure to track the previous state of the filter
@@ -18,8 +18,25 @@
 
 class CuckooSync : public SyncMethod {
 public:
+    /**
+     * @param fngprtSize The fingerprint size in bits
+     * @param bucketSize The size of a bucket in fingerprints
+     * @param filterSize The size of the filter in buckets
+     * @param maxKicks The maximum number of kicks when inserting
+     * @param deltaTransfer If true, each peer keeps the other's filter
+     * between syncs, and a filter is sent as the buckets that changed
+     * since the version that the other peer last received, falling back
+     * to the whole filter when the other peer does not have that
+     * version. Suits peers that sync with each other repeatedly; both
+     * must set the same value.
+     * @param snapshotFile If not empty, the filter is kept in this
+     * memory-mapped snapshot file, and resumed from it if it holds a
+     * filter of the same sizes that was flushed (see Cuckoo).
+     */
     CuckooSync(size_t fngprtSize, size_t bucketSize,
-               size_t filterSize, size_t maxKicks);
+               size_t filterSize, size_t maxKicks,
+               bool deltaTransfer = false,
+               const string& snapshotFile = "");
 
     ~CuckooSync() override;
 
@@ -31,14 +48,85 @@ public:
                     list<shared_ptr<DataObject>>& selfMinusOther,
                     list<shared_ptr<DataObject>>& otherMinusSelf) override;
 
+    /**
+     * Adds an element, and inserts it into the filter, unless the
+     * elements are being replayed into a resumed filter (see
+     * endReplay()).
+     */
     bool addElem(shared_ptr<DataObject> datum) override;
 
+    /**
+     * Ends the replay of a resumed filter. After a restart, the elements
+     * that the snapshot was flushed with are added back without being
+     * inserted into the filter, which already holds them, until this is
+     * called or the first sync starts; elements added after that are
+     * inserted. Only those elements may be added during the replay.
+     */
+    void endReplay();
+
+    /**
+     * @return Whether the filter was resumed from its snapshot file,
+     * rather than started empty
+     */
+    bool resumed() const;
+
     string getName() override;
 private:
     /**
      * Cuckoo filter for reconciliation
      */
     Cuckoo myCF;
+
+    /**
+     * Whether elements added now are replayed into a resumed filter, and
+     * so not inserted (see endReplay())
+     */
+    bool replaying = false;
+
+    /**
+     * Whether filters are sent as deltas
+     */
+    bool deltaTransfer;
+
+    /**
+     * The version of myCF that was last sent, or 0 if none was. A new
+     * random version is drawn whenever a changed filter is sent.
+     */
+    long myVersion = 0;
+
+    /**
+     * The other party's filter, as last received, when filters are sent
+     * as deltas
+     */
+    Cuckoo peerCF;
+
+    /**
+     * The version of peerCF, or 0 if there is none
+     */
+    long peerVersion = 0;
+
+    /**
+     * Sends myCF, as a delta from the last version sent if the other
+     * party has it.
+     * @param commSync The communicant to send through
+     */
+    void _sendFilter(const shared_ptr<Communicant>& commSync);
+
+    /**
+     * Receives the other party's filter, as sent by _sendFilter.
+     * @param commSync The communicant to receive through
+     * @return The other party's filter, valid until the next receipt
+     */
+    const Cuckoo& _recvFilter(const shared_ptr<Communicant>& commSync);
+
+    /**
+     * Adds the local elements that are not in the other party's
+     * filter to selfMinusOther, looking them up in one batch.
+     * @param theirsCF The other party's filter
+     * @param selfMinusOther The list to add the elements to
+     */
+    void _missingFrom(const Cuckoo& theirsCF,
+                      list<shared_ptr<DataObject>>& selfMinusOther);
 };
 
 #endif // CPISYNCLIB_CUCKOOSYNC_H
@@ -102,6 +102,14 @@ public:
      */
     void addElem(shared_ptr<DataObject> newDatum);
 
+    /**
+     * Adds a batch of new data into the existing GenSync data structure.
+     * Equivalent to calling addElem on each datum, but lets sync methods build their structures in bulk.
+     * @param newData The data to be added
+     * %M:  If a file is associated with this object, then updates are stored in that file.
+     */
+    void addElems(const vector<shared_ptr<DataObject>> &newData);
+
     /**
      * Adds a new datum into the existing GenSync data structure
      * @param newDatum The datum to be added ... must be of a type compatible with
@@ -323,6 +331,7 @@ public:
         IBLTSetOfSets,
         IBLTSync_Multiset,
         CuckooSync,
+        RatelessIBLTSync,
         END     // one after the end of iterable options
     };
 
@@ -464,6 +473,25 @@ public:
         return *this;
     }
 
+    /**
+     * @param theConns The number of extra connections, on the ports following the sync port, over which
+     * InteractiveCPISync synchronizes the partitions of a failed root in parallel.  Socket-based syncs only;
+     * both peers must set the same value.
+     */
+    Builder& setSubtreeConnections(size_t theConns) {
+        this->subtreeConns = theConns;
+        return *this;
+    }
+
+    /**
+     * @param theBreadthFirst If true, InteractiveCPISync synchronizes its tree breadth-first, with one round trip
+     * per depth of the tree rather than per node.  Both peers must set the same value.
+     */
+    Builder& setBreadthFirst(bool theBreadthFirst) {
+        this->breadthFirst = theBreadthFirst;
+        return *this;
+    }
+
     /**
      * The number of elements expected to be in the sync data structure.  Some sync objects work are targeted toward
      * a specific number of elements.
@@ -500,6 +528,25 @@ public:
         return *this;
     }
 
+    /**
+     * @param theFile A file in which CuckooSync keeps its filter, memory-mapped, so that a restarted process
+     * resumes the filter instead of rebuilding it.  Elements added back after a restart, up to the first sync
+     * or CuckooSync::endReplay(), are taken to be those the filter was flushed with, and are not inserted again.
+     */
+    Builder& setCuckooSnapshot(string theFile) {
+        this->cuckooSnapshot = std::move(theFile);
+        return *this;
+    }
+
+    /**
+     * @param theDelta If true, CuckooSync keeps the other peer's filter between syncs, and sends only the buckets
+     * of its own filter that changed since the other peer last received it.  Both peers must set the same value.
+     */
+    Builder& setDeltaTransfer(bool theDelta) {
+        this->deltaTransfer = theDelta;
+        return *this;
+    }
+
     /**
      * @param theFileName A file name from which data is to be drawn for the initial population of the sync object.
      */
@@ -520,6 +567,69 @@ public:
         return *this;
     }
 
+    /**
+     * @param theLegacy If true, IBLT-based syncs hash with the string-based scheme of earlier versions,
+     * so that they can synchronize with peers that still use it.
+     */
+    Builder& setLegacyIBLTHash(bool theLegacy) {
+        this->legacyIBLTHash = theLegacy;
+        return *this;
+    }
+
+    /**
+     * @param theEstimate If true, IBLTSync peers exchange strata estimators before each sync and size
+     * their IBLTs for the estimated difference; the expected number of elements then only matters until
+     * the first sync.  Both peers must set the same value.
+     * Estimation costs a round trip and an estimator about as large as an IBLT for
+     * StrataEstimator::NUM_STRATA * STRATUM_ENTRIES elements, so it pays off when the expected number of
+     * elements must cover differences much larger than those typically seen; for differences of steady
+     * size, a fixed expected number of elements is cheaper.
+     */
+    Builder& setEstimateIBLTSize(bool theEstimate) {
+        this->estimateIBLTSize = theEstimate;
+        return *this;
+    }
+
+    /**
+     * @param theRetries The number of times an IBLTSync server that cannot decode the difference may ask
+     * the client for an IBLT with twice as many cells.  Both peers must set the same value.
+     */
+    Builder& setIBLTRetries(size_t theRetries) {
+        this->ibltRetries = theRetries;
+        return *this;
+    }
+
+    /**
+     * @param theFlat If true, IBLTSync keeps its IBLT as an IBLTFlat, whose cells are fixed-width words, so that
+     * inserting, subtracting and peeling do not go through multiprecision arithmetic, and the server subtracts
+     * IBLTs and checks that they are empty with AVX2 or SSE4.2 kernels where the CPU has them.  Every element
+     * must then fit into the given number of bits, read as bytes.  Peers may differ.
+     */
+    Builder& setFlatIBLT(bool theFlat) {
+        this->flatIBLT = theFlat;
+        return *this;
+    }
+
+    /**
+     * @param theFile A file in which IBLTSync keeps its IBLT as an IBLTFlat, memory-mapped, so that a restarted
+     * process resumes the IBLT instead of rebuilding it.  Elements added back after a restart, up to the first
+     * sync or IBLTSync::endReplay(), are taken to be those the IBLT was flushed with, and are not inserted again.
+     * Implies setFlatIBLT(true).  Peers may differ.
+     */
+    Builder& setIBLTSnapshot(string theFile) {
+        this->ibltSnapshot = std::move(theFile);
+        return *this;
+    }
+
+    /**
+     * @param theEuclid If true, CPISync and ProbCPISync interpolate the rational function of the differences
+     * with the extended Euclidean algorithm, rather than with Gaussian elimination.  Peers may differ.
+     */
+    Builder& setEuclideanInterp(bool theEuclid) {
+        this->euclideanInterp = theEuclid;
+        return *this;
+    }
+
 
     /**
      * Destructor - clear up any possibly allocated internal variables
@@ -542,14 +652,24 @@ private:
     Nullable<long> mbar; /** an upper estimate on the number of differences between synchronizing data multisets. */
     Nullable<long> bits; /** the number of bits per element of data */
     Nullable<int> numParts; /** the number of partitions into which to divide recursively for interactive methods. */
+    size_t subtreeConns = Builder::DFT_SUBTREE_CONNS; /** the number of extra connections for InterCPISync subtrees */
+    bool breadthFirst = Builder::BREADTH_FIRST; /** whether InterCPISync synchronizes breadth-first */
     Nullable<size_t> numExpElem; /** the number of elements expected to be stored in the data structure (e.g., for IBLT) */
     Nullable<string> fileName;   /** the name of a file from which to draw data for the initialization of the sync object. */
 	bool hashes = Builder::HASHES;
     Nullable<long> numElemChldSet; /** exp # of elements in a child set **/
+    bool legacyIBLTHash = Builder::LEGACY_IBLT_HASH; /** whether IBLTs use IBLTHashScheme::Legacy */
+    bool estimateIBLTSize = Builder::ESTIMATE_IBLT_SIZE; /** whether IBLTSync sizes its IBLT from a difference estimate */
+    size_t ibltRetries = Builder::DFT_IBLT_RETRIES; /** how many times IBLTSync may retry with a larger IBLT */
+    bool flatIBLT = Builder::FLAT_IBLT; /** whether IBLTSync keeps its IBLT as an IBLTFlat */
+    string ibltSnapshot; /** the snapshot file of IBLTSync's IBLT, or empty to keep it in memory */
+    bool euclideanInterp = Builder::EUCLIDEAN_INTERP; /** whether CPISync interpolates with RatFuncSolver::Euclidean */
     Nullable<size_t> fngprtSize; /** Cuckoo filter parameters */
     Nullable<size_t> bucketSize;
     Nullable<size_t> filterSize;
     Nullable<size_t> maxKicks;
+    bool deltaTransfer = Builder::DELTA_TRANSFER; /** whether CuckooSync sends its filter as a delta */
+    string cuckooSnapshot; /** the snapshot file of CuckooSync's filter, or empty to keep it in memory */
 
 
     // ... bookkeeping variables
@@ -559,12 +679,20 @@ private:
     void (*_postProcess)(list<shared_ptr<DataObject>>, list<shared_ptr<DataObject>>, void (GenSync::*add)(shared_ptr<DataObject>), bool (GenSync::*del)(shared_ptr<DataObject>), GenSync *pGenSync);
     // DEFAULT constants
     static const bool HASHES = false;
+    static const bool LEGACY_IBLT_HASH = false;
+    static const bool ESTIMATE_IBLT_SIZE = false;
+    static const size_t DFT_IBLT_RETRIES = 0;
+    static const bool FLAT_IBLT = false;
+    static const bool EUCLIDEAN_INTERP = false;
+    static const bool DELTA_TRANSFER = false;
     static const SyncProtocol DFT_PROTO = SyncProtocol::UNDEFINED;
     static const int DFT_PRT = 8001;
     static const bool DFT_BASE64 = true;
     static const Nullable<long> DFT_MBAR; // this parameter *must* be specified for sync to work
     static const long DFT_BITS = 32;
     static const int DFT_PARTS = 2;
+    static const size_t DFT_SUBTREE_CONNS = 0;
+    static const bool BREADTH_FIRST = false;
     static const size_t DFT_EXPELEMS = 50;
     // ... initialized in .cpp file due to C++ quirks
     static const string DFT_HOST;
@@ -33,6 +33,18 @@ const long N_HASHCHECK = 11;
 // Shorthand for the hash type
 typedef unsigned long int hash_t;
 
+/*
+ * The family of hashes that places keys into cells and computes their hash-checks.
+ * Peers must use the same scheme, or their IBLTs will not decode against each other.
+ *  Seeded - seeded hashes of the key's bytes, computed without allocating (default)
+ *  Legacy - std::hash<string> of the key's decimal string, iterated once per hash;
+ *           for compatibility with peers running earlier versions
+ */
+enum class IBLTHashScheme : byte {
+    Seeded,
+    Legacy
+};
+
 /*
  * IBLT (Invertible Bloom Lookup Table) is a data-structure designed to add
  * probabilistic invertibility to the standard Bloom Filter data-structure.
@@ -46,12 +58,16 @@ public:
     // Communicant needs to access the internal representation of an IBLT to send and receive it
     friend class Communicant;
 
+    // RatelessIBLT codes symbols with the cell semantics and hash functions of an IBLT
+    friend class RatelessIBLT;
+
     /**
      * Constructs an IBLT object with size relative to expectedNumEntries.
      * @param expectedNumEntries The expected amount of entries to be placed into the IBLT
      * @param _valueSize The size of the values being added, in bits
+     * @param scheme The hash family to use; must match the peer's
      */
-    IBLT(size_t expectedNumEntries, size_t _valueSize);
+    IBLT(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
     
     // default destructor
     ~IBLT();
@@ -72,6 +88,18 @@ public:
      * @param value The value to be removed
      */
     virtual void erase(ZZ key, ZZ value);
+
+    /**
+     * Inserts every element of a range as a key-value pair (elt->to_ZZ(), elt->to_ZZ()).
+     * The range is split among worker threads, each filling its own partial table, and the
+     * partial tables are then merged cell by cell.  The result is the same as inserting the elements one by one.
+     * @param begin The first element to insert
+     * @param end Just past the last element to insert
+     * @param numThreads The number of threads to use, or 0 for one per hardware thread
+     * @require The elements must be distinct from each other and from the keys in the IBLT
+     */
+    void bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                    vector<shared_ptr<DataObject>>::const_iterator end, size_t numThreads = 0);
     
     /**
      * Produces the value s.t. (key, value) is in the IBLT.
@@ -155,6 +183,11 @@ public:
      */
     size_t eltSize() const;
 
+    /**
+     * @return the hash family used by the IBLT.
+     */
+    IBLTHashScheme getHashScheme() const;
+
     vector<hash_t> hashes; /* vector for all hashes of sets */
 
 protected:
@@ -163,13 +196,49 @@ protected:
     // default constructor - no internal parameters are initialized
     IBLT();
 
-    // Helper function for insert and erase
-    void _insert(long plusOrMinus, ZZ key, ZZ value);
+    /**
+     * Helper function for insert, erase and peeling
+     * @param cells If not null, receives the indices of the N_HASH cells that were updated
+     */
+    void _insert(long plusOrMinus, ZZ key, ZZ value, long *cells = nullptr);
 
-    // Returns the kk-th unique hash of the zz that produced initial.
-    static hash_t _hashK(const ZZ &item, long kk);
+    // Returns the kk-th unique hash of item under the given scheme.
+    static hash_t _hashK(const ZZ &item, long kk, IBLTHashScheme scheme);
+    // Returns the kk-th unique hash of the zz that produced initial, under the Legacy scheme.
     static hash_t _hash(const hash_t& initial, long kk);
-    static hash_t _setHash(multiset<shared_ptr<DataObject>> &tarSet);
+    hash_t _setHash(multiset<shared_ptr<DataObject>> &tarSet) const;
+
+    /**
+     * Computes all the hashes needed to insert key, sharing work between them.
+     * @param key The key to hash
+     * @param scheme The hash family to use
+     * @param hashes Filled with _hashK(key, ii, scheme) for ii < N_HASH, followed by _hashK(key, N_HASHCHECK, scheme)
+     */
+    static void _hashes(const ZZ &key, IBLTHashScheme scheme, hash_t *hashes);
+
+    // @return the number of bytes that the idx-th cell takes in the byte representation
+    size_t _cellSize(size_t idx) const;
+
+    /**
+     * Writes the byte representation of a single cell, as part of toByteVector.
+     * @param idx The index of the cell
+     * @param out The buffer to write into; must have room for _cellSize(idx) bytes
+     * @return the byte after the written cell
+     */
+    byte *_writeCell(size_t idx, byte *out) const;
+
+    // @return the number of bytes of the set hashes that follow the cells (IBLTSetOfSets only)
+    size_t _trailerSize() const;
+
+    // Writes the set hashes that follow the cells; @return the byte after them
+    byte *_writeTrailer(byte *out) const;
+
+    /**
+     * Parses a byte representation in place; see fromByteVector.
+     * @param buf The bytes to parse
+     * @param len The number of bytes in buf
+     */
+    void _parseBytes(const byte *buf, size_t len);
 
     /* Insert an IBLT together with a value into a bigger IBLT
     * @param chldIBLT the IBLT to be inserted
@@ -199,18 +268,34 @@ protected:
         // The bitwise xor-sum of all values mapped to this cell
         ZZ valueSum;
 
-        // Returns whether the entry contains just one insertion or deletion
-        virtual bool isPure() const;
+        // Returns whether the entry contains just one insertion or deletion, given the IBLT's hash scheme
+        virtual bool isPure(IBLTHashScheme scheme) const;
 
         // Returns whether the entry is empty
         bool empty() const;
     };
 
+    // The fewest elements per thread for which bulkInsert starts another thread
+    static const size_t MIN_BULK_PER_THREAD = 1 << 12;
+
+    // @return the indices of all pure cells, as the initial candidates for peeling
+    vector<long> _pureCells() const;
+
+    /**
+     * Removes the single key-value pair in a pure entry from the IBLT.
+     * @param entry A pure entry of hashTable
+     * @param candidates Receives the indices of updated cells that may have become pure
+     */
+    void _peel(HashTableEntry &entry, vector<long> &candidates);
+
     // vector of all entries
     vector<HashTableEntry> hashTable;
 
     // the value size, in bits
     size_t valueSize;
+
+    // the hash family for placing keys and computing hash-checks
+    IBLTHashScheme hashScheme = IBLTHashScheme::Seeded;
 };
 
 #endif //CPISYNCLIB_IBLT_H
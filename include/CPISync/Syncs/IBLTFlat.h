@@ -0,0 +1,320 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * IBLTFlat is an IBLT storage engine in which every cell is a fixed-width run of 64-bit words
+ * (count, keyCheck, key words, value words) laid out contiguously in one cache-aligned table.
+ * Keys and values are bounded by the value size given at construction, so that insertion,
+ * subtraction and peeling never allocate and never go through multiprecision arithmetic.
+ *
+ * IBLTFlat places and checks entries exactly as IBLT does, and produces the same byte
+ * representation, so an IBLTFlat can be exchanged with a peer holding an IBLT of the same size.
+ *
+ * Since its table is a plain array of words, an IBLTFlat can also be kept in a memory-mapped snapshot
+ * file that is updated in place, so that a restarted process resumes it instead of re-inserting every
+ * element.
+ */
+
+#ifndef CPISYNC_IBLTFLAT_H
+#define CPISYNC_IBLTFLAT_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <NTL/ZZ.h>
+#include <CPISync/Aux/Auxiliary.h>
+#include <CPISync/Aux/Serializable.h>
+#include <CPISync/Aux/MappedFile.h>
+#include <CPISync/Syncs/IBLT.h>
+
+using std::vector;
+using std::pair;
+using namespace NTL;
+
+class IBLTFlat : public Serializable {
+public:
+    // Communicant needs to access the internal representation of an IBLT to send and receive it
+    friend class Communicant;
+
+    // the storage unit of a cell
+    typedef std::uint64_t word_t;
+
+    /**
+     * Constructs an IBLTFlat object with size relative to expectedNumEntries.
+     * The table has the same number of cells as an IBLT with the same parameters.
+     * @param expectedNumEntries The expected amount of entries to be placed into the IBLT
+     * @param _valueSize The maximum size of the keys and values being added, in bytes
+     * @param scheme The hash family to use; must match the peer's
+     */
+    IBLTFlat(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
+
+    /**
+     * Opens an IBLTFlat kept in a memory-mapped snapshot file, which inserts and erases update in place.
+     * If the file holds an IBLTFlat with the same parameters that has not changed since it was last
+     * flushed, it is resumed as it is (see resumed()).  Otherwise the file is reset to an empty IBLT,
+     * and the caller should insert its elements again.
+     * get and listEntries peel the table in place, so they should be called on a copy, which is held in memory.
+     * @param fileName The snapshot file; created if it does not exist
+     * @param expectedNumEntries The expected amount of entries to be placed into the IBLT
+     * @param _valueSize The maximum size of the keys and values being added, in bytes
+     * @param scheme The hash family to use; must match the peer's
+     */
+    IBLTFlat(const string &fileName, size_t expectedNumEntries, size_t _valueSize,
+             IBLTHashScheme scheme = IBLTHashScheme::Seeded);
+
+    // Copies are held in memory, whether or not the original is kept in a snapshot file
+    IBLTFlat(const IBLTFlat &other);
+    IBLTFlat &operator=(const IBLTFlat &other);
+    IBLTFlat(IBLTFlat &&other) noexcept;
+    IBLTFlat &operator=(IBLTFlat &&other) noexcept;
+
+    // destructor; flushes the snapshot file, if any
+    ~IBLTFlat() override;
+
+    // @return true iff this IBLT was resumed from its snapshot file, rather than started empty
+    bool resumed() const;
+
+    /**
+     * Writes the table back to the snapshot file and marks the snapshot as consistent, so that it can be
+     * resumed after a restart, even an unclean one, as long as it is not changed in between.
+     * Does nothing if the IBLT is held in memory.
+     */
+    void flush();
+
+    /**
+     * Inserts a key-value pair to the IBLT.
+     * This operation always succeeds.
+     * @param key The key to be added
+     * @param value The value to be added
+     * @require The key must be distinct in the IBLT
+     * @require key and value are non-negative and fit into eltSize() bytes
+     */
+    void insert(const ZZ &key, const ZZ &value);
+
+    /**
+     * Erases a key-value pair from the IBLT.
+     * This operation always succeeds.
+     * @param key The key to be removed
+     * @param value The value to be removed
+     */
+    void erase(const ZZ &key, const ZZ &value);
+
+    /**
+     * Inserts every element of a range as a key-value pair (elt->to_ZZ(), elt->to_ZZ()), converting each
+     * element to words only once.  The result is the same as inserting the elements one by one.
+     * @param begin The first element to insert
+     * @param end Just past the last element to insert
+     * @require The elements must be distinct from each other and from the keys in the IBLT
+     */
+    void bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                    vector<shared_ptr<DataObject>>::const_iterator end);
+
+    /**
+     * Produces the value s.t. (key, value) is in the IBLT.
+     * Has the same (destructive) semantics as IBLT::get.
+     * @param key The key corresponding to the value returned by this function
+     * @param result The resulting value corresponding with the key, if found.
+     * If not found, result will be set to 0. result is unchanged iff the operation returns false.
+     * @return true iff the presence of the key could be determined
+     */
+    bool get(const ZZ &key, ZZ &result);
+
+    /**
+     * Produces a list of all the key-value pairs in the IBLT.
+     * Has the same (destructive) semantics as IBLT::listEntries.
+     * @param positive All the elements that could be inserted.
+     * @param negative All the elements that were removed without being inserted first.
+     * @return true iff the operation has successfully recovered the entire list
+     */
+    bool listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative);
+
+    /**
+     * Subtracts two IBLTs.
+     * -= is destructive and assigns the resulting iblt to the lvalue, whereas - isn't. -= is more efficient than -
+     * @param other The IBLT that will be subtracted from this IBLT
+     * @require IBLT must have the same number of entries and the values must be of the same size
+     */
+    IBLTFlat operator-(const IBLTFlat &other) const;
+    IBLTFlat &operator-=(const IBLTFlat &other);
+
+    /**
+     * @return the number of cells in the IBLT. Not necessarily equal to the expected number of entries
+     */
+    size_t size() const;
+
+    /**
+     * @return the size of a value stored in the IBLT.
+     */
+    size_t eltSize() const;
+
+    /**
+     * @return the hash family used by the IBLT.
+     */
+    IBLTHashScheme getHashScheme() const;
+
+    /**
+     * Serializes the IBLT in the same format as IBLT::toByteVector
+     * @return vector<byte> to send over socket
+     */
+    vector<byte> toByteVector() const override;
+
+    /**
+     * Parses the output of IBLT::toByteVector or IBLTFlat::toByteVector.
+     * @require the table is already sized (see _init)
+     * @require every key and value in data fits into eltSize() bytes
+     * @param data vector<byte>
+     */
+    void fromByteVector(vector<byte> data) override;
+
+protected:
+    // default constructor - no internal parameters are initialized
+    IBLTFlat();
+
+    /**
+     * Sizes an empty table.
+     * @param numCells The number of cells in the table; must be divisible by N_HASH
+     * @param _valueSize The maximum size of the keys and values, in bytes
+     * @param scheme The hash family to use
+     */
+    void _init(size_t numCells, size_t _valueSize, IBLTHashScheme scheme);
+
+    // Sets the parameters and cell layout of an empty table, without allocating it
+    void _layout(size_t numCells, size_t _valueSize, IBLTHashScheme scheme);
+
+    // @return the number of cells in a table for expectedNumEntries entries
+    static size_t _numCells(size_t expectedNumEntries);
+
+    // Writes the snapshot back, if any, and returns to an empty, unallocated table
+    void _close();
+
+    // Marks the snapshot, if any, as changed; called before any change to the cells
+    void _touch() {
+        if (snapshot && _header()[SNAP_CLEAN] != 0)
+            _markChanged();
+    }
+
+    // Marks the snapshot as changed, and writes the mark back before the cells can change
+    void _markChanged();
+
+    // @return the header words of the snapshot file
+    word_t *_header() { return reinterpret_cast<word_t *>(snapshot->data()); }
+
+    /**
+     * Helper function for insert, erase and peeling.
+     * @param plusOrMinus The amount by which to change the count of each touched cell
+     * @param key keyWords words holding the key
+     * @param value keyWords words holding the value
+     * @param cells If not null, receives the indices of the N_HASH cells that were updated
+     */
+    void _insert(long plusOrMinus, const word_t *key, const word_t *value, size_t *cells = nullptr);
+
+    // Replaces candidates with the indices of all pure cells
+    void _findPureCells();
+
+    /**
+     * Removes the single key-value pair in a pure cell from the IBLT.
+     * Adds the updated cells that may have become pure to candidates.
+     * @param cell The first word of a pure cell
+     */
+    void _peel(const word_t *cell);
+
+    /**
+     * Computes the cell hashes and the hash-check of a key, in the same way as IBLT::_hashes.
+     * @param key keyWords words holding the key
+     * @param hashes Filled with the N_HASH cell hashes of key, followed by its hash-check
+     */
+    void _hashes(const word_t *key, hash_t *hashes) const;
+
+    // @return true iff the cell starting at cell holds exactly one insertion or deletion
+    bool _isPure(const word_t *cell) const;
+
+    // @return true iff the cell starting at cell is empty
+    bool _isEmpty(const word_t *cell) const;
+
+    // @return a pointer to the first word of the idx-th cell
+    word_t *_cell(size_t idx) { return cells + idx * cellWords; }
+    const word_t *_cell(size_t idx) const { return cells + idx * cellWords; }
+
+    // @return the number of bytes that the idx-th cell takes in the byte representation
+    size_t _cellSize(size_t idx) const;
+
+    /**
+     * Writes the byte representation of a single cell, as part of toByteVector.
+     * @param idx The index of the cell
+     * @param out The buffer to write into; must have room for _cellSize(idx) bytes
+     * @return the byte after the written cell
+     */
+    byte *_writeCell(size_t idx, byte *out) const;
+
+    /**
+     * Parses a byte representation in place; see fromByteVector.
+     * @param buf The bytes to parse
+     * @param len The number of bytes in buf
+     */
+    void _parseBytes(const byte *buf, size_t len);
+
+    // Copies num into keyWords little-endian words; quits if num does not fit
+    void _toWords(const ZZ &num, word_t *words) const;
+
+    // @return the number represented by keyWords little-endian words
+    ZZ _toZZ(const word_t *words) const;
+
+    // Word offsets of the fields within a cell
+    static const size_t COUNT = 0;
+    static const size_t CHECK = 1;
+    static const size_t KEY = 2;
+
+    // Cells are padded so that none straddles a cache line when they are smaller than one
+    static const size_t CACHE_LINE = 64;
+
+    // Words of the snapshot file header, which takes up a cache line before the cells
+    static const size_t SNAP_MAGIC = 0;
+    static const size_t SNAP_CELLS = 1;
+    static const size_t SNAP_VALUE_SIZE = 2;
+    static const size_t SNAP_CELL_WORDS = 3;
+    static const size_t SNAP_SCHEME = 4;
+    static const size_t SNAP_CLEAN = 5; // nonzero iff the cells have not changed since the last flush
+    static const size_t SNAP_HEADER_WORDS = CACHE_LINE / sizeof(word_t);
+
+    // Identifies (and versions) IBLTFlat snapshot files
+    static const word_t SNAPSHOT_MAGIC = 0x4350494942465401ULL;
+
+    // the table of cells of an IBLT held in memory, cellWords words per cell
+    vector<word_t, AlignedAllocator<word_t, CACHE_LINE>> table;
+
+    // the snapshot file holding the table, or null if it is held in memory
+    std::unique_ptr<MappedFile> snapshot;
+
+    // the first word of the table, wherever it is held
+    word_t *cells = nullptr;
+
+    // whether the table was resumed from the snapshot file
+    bool wasResumed = false;
+
+    // scratch space for the key and value of a cell that is being peeled
+    vector<word_t> peelBuf;
+
+    // scratch space for the key and value being inserted, erased or looked up
+    vector<word_t> keyBuf, valueBuf;
+
+    // indices of cells that may be pure, awaiting peeling
+    vector<size_t> candidates;
+
+    // the number of cells
+    size_t numCells = 0;
+
+    // the value size, in bytes
+    size_t valueSize = 0;
+
+    // the number of words in a key (and in a value)
+    size_t keyWords = 0;
+
+    // the number of words in a cell, including padding
+    size_t cellWords = 0;
+
+    // the hash family for placing keys and computing hash-checks
+    IBLTHashScheme hashScheme = IBLTHashScheme::Seeded;
+};
+
+#endif //CPISYNC_IBLTFLAT_H
@@ -20,8 +20,9 @@ public:
      * Constructs an IBLT object with size relative to expectedNumEntries.
      * @param expectedNumEntries The expected amount of entries to be placed into the IBLT
      * @param _valueSize The size of the values being added, in bits
+     * @param scheme The hash family to use; must match the peer's
      */
-    IBLTMultiset(size_t expectedNumEntries, size_t _valueSize);
+    IBLTMultiset(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
 
     IBLTMultiset();
 
@@ -42,6 +43,16 @@ public:
      */
     void erase(ZZ key, ZZ value) override;
 
+    /**
+     * Inserts every element of a range as a key-value pair (elt->to_ZZ(), elt->to_ZZ()), using worker threads.
+     * See IBLT::bulkInsert.  Elements may repeat.
+     * @param begin The first element to insert
+     * @param end Just past the last element to insert
+     * @param numThreads The number of threads to use, or 0 for one per hardware thread
+     */
+    void bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                    vector<shared_ptr<DataObject>>::const_iterator end, size_t numThreads = 0);
+
     /**
      * Produces the value s.t. (key, value) is in the IBLT.
      * This operation doesn't always succeed.
@@ -105,14 +116,30 @@ private:
      * @param plusOrMinus The indicator of whether it is insert (1) or delete (-1)
      * @param key The key to insert or delete
      * @param value The value to insert or delete
+     * @param cells If not null, receives the indices of the N_HASH cells that were updated
      */
-    void _insertModular(long plusOrMinus, const ZZ &key, const ZZ &value);
+    void _insertModular(long plusOrMinus, const ZZ &key, const ZZ &value, long *cells = nullptr);
 
     class HashTableEntry : public IBLT::HashTableEntry {
     public:
-        bool isPure() const override;
+        bool isPure(IBLTHashScheme scheme) const override;
     };
 
+    // @return the indices of all pure cells, as the initial candidates for peeling
+    vector<long> _pureCells() const;
+
+    /**
+     * Removes one copy of the key-value pair in a pure entry from the IBLT.
+     * @param entry A pure entry of hashTable
+     * @param candidates Receives the indices of updated cells that may be pure
+     */
+    void _peel(HashTableEntry &entry, vector<long> &candidates);
+
+    // Serialization helpers, in the same format as IBLT's; see IBLT::_writeCell
+    size_t _cellSize(size_t idx) const;
+    byte *_writeCell(size_t idx, byte *out) const;
+    void _parseBytes(const byte *buf, size_t len);
+
     // vector of all entries
     vector<HashTableEntry> hashTable;
 
@@ -29,8 +29,9 @@ public:
      * @param expected The expected number of elements being stored
      * @param numElemChld upper bound of # elements in the child set
      * @param elemSize size of the single element in the child set
+     * @param scheme The hash family of the outer and child IBLTs
      */
-  IBLTSetOfSets(size_t expected, size_t numElemChld, size_t elemSize);
+  IBLTSetOfSets(size_t expected, size_t numElemChld, size_t elemSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
   ~IBLTSetOfSets() override;
 
   // Implemented parent class methods
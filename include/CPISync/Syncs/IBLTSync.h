@@ -9,6 +9,17 @@
  * There is a small probability that most, but not all, of the differences will be uncovered as a result
  * of this sync.
  *
+ * Optionally, the peers first exchange strata estimators of their sets, and both size the IBLT for the
+ * estimated symmetric difference rather than for the expected number of elements given at construction.
+ * Also optionally, a server that cannot decode the difference asks the client for an IBLT with twice as
+ * many cells, up to a given number of times.  Differences decoded in earlier rounds are taken out of the
+ * larger IBLT before it is decoded, so that each round only has to peel what is left.
+ *
+ * The IBLT may also be kept as an IBLTFlat, whose cells are fixed-width words rather than multiprecision
+ * numbers, so that the server's subtractions and emptiness checks run through its vector kernels.  It goes
+ * over the wire in the same format, so peers need not agree on this.  An IBLTFlat can further be kept in a
+ * memory-mapped snapshot file, so that a restarted process resumes it rather than rebuilding it.
+ *
  * Created by Eliezer Pearl on 8/3/2018.
  */
 #ifndef CPISYNCLIB_IBLTSYNC_H
@@ -17,6 +28,8 @@
 #include <CPISync/Aux/SyncMethod.h>
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Syncs/IBLT.h>
+#include <CPISync/Syncs/IBLTFlat.h>
+#include <CPISync/Syncs/StrataEstimator.h>
 
 class IBLTSync : public SyncMethod {
 public:
@@ -24,26 +37,108 @@ public:
      * Constructor.
      * @param expected The expected number of elements being stored
      * @param eltSize The size of elements being stored
+     * @param scheme The IBLT hash family; IBLTHashScheme::Legacy syncs with peers running earlier versions
+     * @param estimate If true, the IBLT is sized for a difference estimated at the start of each sync,
+     * and expected only sizes the IBLT until then.  Both peers must agree on this setting.
+     * @param retries The number of times a two-way sync may retry with a larger IBLT when the difference
+     * does not decode.  Both peers must agree on this setting.
+     * @param flat If true, the IBLT is kept as an IBLTFlat, which then requires every element to fit into
+     * eltSize bytes.  Peers may differ on this setting.
+     * @param snapshotFile If not empty, the IBLT is kept as an IBLTFlat in this memory-mapped snapshot file,
+     * and resumed from it if it holds a flushed IBLT of the same size (see IBLTFlat); implies flat.
      */
-    IBLTSync(size_t expected, size_t eltSize);
+    IBLTSync(size_t expected, size_t eltSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded,
+             bool estimate = false, size_t retries = 0, bool flat = false, const string &snapshotFile = "");
     ~IBLTSync() override;
 
     // Implemented parent class methods
     bool SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
     bool SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
     bool addElem(shared_ptr<DataObject> datum) override;
+    bool addElems(const vector<shared_ptr<DataObject>> &data) override;
     bool delElem(shared_ptr<DataObject> datum) override;
 
+    // @return true iff the IBLT was resumed from its snapshot file, rather than started empty
+    bool resumed() const;
+
+    /**
+     * Ends the replay of a resumed IBLT.  After a restart, the elements that the snapshot was flushed with are
+     * added back without being inserted into the IBLT, which already holds them, until this is called or the
+     * first sync starts; elements added after that are inserted.  Only those elements may be added during
+     * the replay.
+     */
+    void endReplay();
+
     string getName() override;
 protected:
     // one way flag
     bool oneWay;
 private:
-    // IBLT instance variable for storing data
+    /**
+     * Sizes myIBLT for a symmetric difference of diff elements, rounded up to a power of two or one and a
+     * half times a power of two, rebuilding it from the current elements only if it does not have that size
+     * already.  No slack is added: the cells that IBLT allocates beyond the expected number of elements cover
+     * the estimator's error as well as the chance that peeling stalls.  A snapshot file is reopened
+     * at the new size.
+     * @param diff The estimated size of the symmetric difference
+     */
+    void _sizeFor(size_t diff);
+
+    /**
+     * @param expected The number of elements to size the IBLT for
+     * @return an IBLT (IBLT or IBLTFlat) of the current elements, sized for expected elements
+     */
+    template <class Table>
+    Table _buildIBLT(size_t expected);
+
+    /**
+     * The client's part of a sync after the estimate: sends mine, and larger IBLTs as long as the server
+     * asks for them.
+     * @param mine myIBLT or *myFlat
+     * @return false iff the IBLT parameters of the peers do not match
+     */
+    template <class Table>
+    bool _sendIBLTs(const shared_ptr<Communicant>& commSync, const Table &mine);
+
+    /**
+     * The server's part of a sync after the estimate: receives the client's IBLT, subtracts mine from it
+     * and decodes the difference, asking for larger IBLTs as long as it does not decode.
+     * @param mine myIBLT or *myFlat
+     * @param positive Receives the elements that the client has and the server does not
+     * @param negative Receives the elements that the server has and the client does not
+     * @param decoded Set to whether the whole difference was decoded
+     * @return false iff the IBLT parameters of the peers do not match
+     */
+    template <class Table>
+    bool _decodeIBLTs(const shared_ptr<Communicant>& commSync, const Table &mine,
+                      vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative, bool &decoded);
+
+    // @return the expected number of elements for the IBLT of the round after one sized for expected
+    static size_t _retrySize(size_t expected);
+
+    // IBLT instance variable for storing data; holds no cells if myFlat is used instead
     IBLT myIBLT;
 
+    // The IBLT of the data as an IBLTFlat; null unless the IBLT is kept flat
+    shared_ptr<IBLTFlat> myFlat;
+
+    // The snapshot file of myFlat, or empty if it is held in memory
+    string snapshotFile;
+
+    // Whether elements added now are replayed into a resumed IBLT, and so not inserted (see endReplay())
+    bool replaying = false;
+
+    // Summary of the elements for estimating the difference with a peer; null unless estimating
+    shared_ptr<StrataEstimator> myEstimator;
+
+    // The IBLT is never sized for fewer than MIN_ESTIMATED_ELEMS elements, a power of two
+    static const size_t MIN_ESTIMATED_ELEMS = 16;
+
     // Instance variable to sore the expected number of elements
     size_t expNumElems;
+
+    // The number of times to retry with a larger IBLT when decoding fails
+    size_t maxRetries;
 };
 
 
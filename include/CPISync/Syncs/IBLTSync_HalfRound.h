@@ -17,7 +17,8 @@
 class IBLTSync_HalfRound : public IBLTSync {
 public:
     // Duplicate the IBLTSync constructor, but set oneWay to true
-    IBLTSync_HalfRound(size_t expected, size_t eltSize) : IBLTSync(expected, eltSize) {
+    IBLTSync_HalfRound(size_t expected, size_t eltSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded)
+    : IBLTSync(expected, eltSize, scheme) {
         oneWay = true;
         SyncID = SYNC_TYPE::IBLTSync_HalfRound;
     }
@@ -11,12 +11,13 @@
 class IBLTSync_Multiset : public SyncMethod {
 public:
     // Duplicate the IBLTSync constructor, but set multiset to true
-    IBLTSync_Multiset(size_t expected, size_t eltSize);
+    IBLTSync_Multiset(size_t expected, size_t eltSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
 
     // Implemented parent class methods
     bool SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
     bool SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
     bool addElem(shared_ptr<DataObject> datum) override;
+    bool addElems(const vector<shared_ptr<DataObject>> &data) override;
     bool delElem(shared_ptr<DataObject> datum) override;
 
     string getName() override;
@@ -5,12 +5,17 @@
 #define INCRE_CPI_H
 
 #include <list>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Communicants/Communicant.h>
 #include <CPISync/Data/DataObject.h>
 #include <CPISync/Syncs/CPISync_ExistingConnection.h>
 
 using std::list;
+using std::vector;
 
 /**
  * Implements a data structure for interactively synchronizing sets of
@@ -82,10 +87,17 @@ public:
 
     /*
      ** update metadata when an element is being added.
+     * The element is added to the root of the tree only; children are made when a synchronization recurses into them.
      * The maximum number of elements that the data structure can store is 1<<bitNum
      */
     bool addElem(shared_ptr<DataObject> newDatum) override;
 
+    /**
+     * Adds a batch of elements to the root of the tree, updating its evaluations for all of them at once.
+     * The result is the same as adding the elements one by one.
+     */
+    bool addElems(const vector<shared_ptr<DataObject>> &data) override;
+
     template <typename T>
     bool addElem(T* newDatum) {
         Logger::gLog(Logger::METHOD, "Entering GenSync::addElem");
@@ -96,6 +108,31 @@ public:
     // update metadata when an element is being deleted (the element is supplied by index)
     bool delElem(shared_ptr<DataObject> newDatum) override;
 
+    /**
+     * Sets connections, beyond the one passed to SyncClient or SyncServer, over which the children of the root
+     * are synchronized in parallel if the root fails to synchronize.  The children are split among the
+     * connections in contiguous runs, each run synchronized in order by its own thread, and the differences found
+     * are merged at the end.  The connections are opened and closed by the synchronization that uses them.
+     * @param comms The extra connections, in the same order at both peers; none (the default) synchronizes
+     *      all of the tree in order over a single connection.  Both peers must set the same number.
+     */
+    void setSubtreeComms(const vector<shared_ptr<Communicant>> &comms) { subtreeComms = comms; }
+
+    /**
+     * Sets whether to synchronize the tree breadth-first:  the nodes of each depth that remain to be synchronized are
+     * all synchronized in one round trip, with their evaluations batched into one message and the server's verdicts
+     * on them into one reply.  The number of round trips is then about the depth of the tree, rather than the number
+     * of nodes synchronized.  The whole tree is synchronized over one connection; subtree connections are not used.
+     * Both peers must set the same value.
+     */
+    void setBreadthFirst(bool bf) { breadthFirst = bf; }
+
+    /**
+     * @return The number of request-reply exchanges of the last synchronization:  one for each node synchronized,
+     * or, breadth-first, one for each depth of the tree
+     */
+    long getExchanges() const { return exchanges; }
+
 		/**
 		 * Displays some internal information about this object.
 		 */
@@ -110,6 +147,10 @@ protected:
     pTree *treeNode; /** A tree of CPISync'ed data.  Each tree node is responsible for a specific range of the
                         * space of set data.
                         */
+    std::deque<pTree> nodeArena; /** Holds every node of the tree, and the nodes made while synchronizing, so that
+                                  * nodes are allocated in blocks and the tree is deleted with the arena. */
+    std::mutex nodeLock; /** Guards nodeArena while subtrees are synchronized in parallel. */
+    unique_ptr<CPISync_ExistingConnection> nodeParams; /** An empty node whose parameters and sample points new nodes share. */
     long bitNum; /** Number of bits used to represent an element of the set that is being synchronized. */
     long maxDiff; /** Maximum number of differences to synchronize (for regular CPIsync) */
     int probEps; /** Negative log of the upper bound on the probability of error for the synchronization. */
@@ -117,10 +158,13 @@ protected:
 
     ZZ DATA_MAX; /** Set elements must be within the range 0..data_max-1.  Sample locations are taken between data_max and ZZ_p::modulus() */
     int redundant_k; /** the number of redundant bits needed per CPISync call to get an overall probability of error at most 2^-probEps. */
-    ZZ addElemHashID; /** A hash ID shared between the non-recursive and recursive addElem methods.  It is used to place
-                       * the new element into the appropriate path of the hash tree. */
+    ZZ addElemHashID; /** The hash of the element being deleted, shared between the recursive calls of _delElem.  It is used to
+                       * find the path of the element in the hash tree. */
     bool useExisting; /** Use Exiting connection for Communication */
     bool hashes; /**Sets whether or not hashing should be used (Must be true for multisets)*/
+    vector<shared_ptr<Communicant>> subtreeComms; /** Extra connections for synchronizing the root's children in parallel */
+    bool breadthFirst; /** Whether to synchronize the tree breadth-first, one round trip per depth */
+    std::atomic<long> exchanges{0}; /** The number of request-reply exchanges of the last synchronization */
     /**
      * Encode and transmit synchronization parameters (e.g. synchronization scheme, probability of error ...)
      * to another communicant for the purposes of ensuring that both are using the same scheme.
@@ -141,10 +185,10 @@ private:
     // METHODS
 
     /**
-     * Deletes all memory associate with the given tree.
-     * @param treeNode A pointer to the root of a tree.
+     * @return a new tree node in the node arena, holding an empty CPISync with the parameters of nodeParams.
+     * The node lives as long as the arena; nodes made during a synchronization are released at its end.
      */
-    void _deleteTree(pTree *treeNode);
+    pTree *_newNode();
 
     /* Computes a hash of the given datum of size bit_num, used internally within IntreCPI.
      * @param datum The datum to hash
@@ -167,8 +211,16 @@ private:
     bool _SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *&treeNode);
 
+    /**
+     * Version of the above for a node covering the hash range [begRange, endRange), which splits a failing node
+     * into children on the fly.
+     * @param stats The stats to which to add those of the node and its descendants
+     * @param childComms Connections over which to synchronize the children in parallel if the node fails;
+     *      if none, the children are synchronized in order over commSync
+     */
     bool _SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
-					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,const ZZ &endRange);
+					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,const ZZ &endRange,
+					 SyncStats &stats, const vector<shared_ptr<Communicant>> &childComms = {});
     /**
      * Recursive version of the public method of the same name.  Parameters are the same except those listed.
      * @see Sync_Server(shared_ptr<Communicant> commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf)
@@ -180,24 +232,52 @@ private:
     bool _SyncServer(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *&treeNode);
 
+    // @see _SyncClient(const shared_ptr<Communicant>&, list<shared_ptr<DataObject>>&, list<shared_ptr<DataObject>>&, pTree*, const ZZ&, const ZZ&, SyncStats&, const vector<shared_ptr<Communicant>>&)
     bool _SyncServer(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode,
 					 const ZZ &begRange,
-					 const ZZ &endRange);
+					 const ZZ &endRange,
+					 SyncStats &stats, const vector<shared_ptr<Communicant>> &childComms = {});
+
+    // A node of the tree to be synchronized breadth-first, with its hash range [begRange, endRange)
+    struct LevelNode {
+        pTree *node;
+        ZZ begRange;
+        ZZ endRange;
+    };
+
+    /**
+     * Breadth-first versions of the recursive _SyncClient and _SyncServer, starting from the root.
+     * @see setBreadthFirst
+     * @param stats The stats to which to add those of the synchronization
+     * @return true iff all constituent sync's succeeded
+     */
+    bool _SyncClientBreadthFirst(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                                 list<shared_ptr<DataObject>> &otherMinusSelf, SyncStats &stats);
+    bool _SyncServerBreadthFirst(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                                 list<shared_ptr<DataObject>> &otherMinusSelf, SyncStats &stats);
 
-    
     /**
-     * Recursive helper function to addElem
-     * @param newDatum The datum to add
-     * @param treeNode The tree in which to add the element.  The method recursively
-     * adds the element to the appropriate children of the node until a node with < m_bar elements is found.
-     * @param parent The parent node of this node.
-     * @param begRange The beginning item of the current node's range
-     * @param endRange The end item of the current node's range
-     * @return true iff the addition is successful
+     * Splits a node that failed to synchronize into its children, which are added to the next level.
+     * @param parent The node to split
+     * @param next The level to which to add the children
      */
-    bool _addElem(shared_ptr<DataObject>newDatum, pTree *&treeNode, pTree *parent, const ZZ &begRange, const ZZ &endRange);
+    void _splitNode(const LevelNode &parent, vector<LevelNode> &next);
 
+    /**
+     * Synchronizes the children of a node that failed to synchronize, as the client or as the server.
+     * @param parent The node whose children to synchronize, as built by createChildren
+     * @param begRange The beginning of the parent's hash range
+     * @param endRange The end of the parent's hash range
+     * @param childComms Connections over which to synchronize the children in parallel; if none, the children are
+     *      synchronized in order over commSync
+     * @see _SyncClient for the other parameters
+     */
+    void _syncChildren(bool asClient, const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                       list<shared_ptr<DataObject>> &otherMinusSelf, pTree *parent, const ZZ &begRange, const ZZ &endRange,
+                       SyncStats &stats, const vector<shared_ptr<Communicant>> &childComms);
+
+    
     /**
 	 * Recursive helper function to delElem
 	 * @param newDatum The datum to remove
@@ -210,11 +290,6 @@ private:
 	bool _delElem(shared_ptr<DataObject> newDatum, pTree * &treeNode, const ZZ &begRange, const ZZ &endRange);
 
 
-		/**
-		 * Helper for addElem that creates a new pTree node and populates it with the appropriate elements of
-		 * the parent in the supplied range.
-		 */
-    bool _createTreeNode(pTree *&treeNode, pTree *parent, const ZZ &begRange, const ZZ &endRange);
     // ... FIELDS
     
     
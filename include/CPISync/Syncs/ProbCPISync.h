@@ -42,12 +42,14 @@ public:
      * @param epsilon An upper bound on the probability of error of the synchronization,
      *    expressed in its negative log.  In other words, the actually probability of error
      *    is upper bounded by 2^-epsilon.
+     * @param hashes Should data be stored as is, or first reduced via a hash
+     * @param solver The method used to interpolate the rational function of the differences
      * 
      *    Internal parameters are tweaked to guarantee this, subject to an assumption
      *    that an internal hash does not collide, and that there be at least 2 items
      *    in the union of the two sets that are being synchronized.
      */
-    ProbCPISync(long m_bar, long bits, int epsilon,bool hashes = false);
+    ProbCPISync(long m_bar, long bits, int epsilon,bool hashes = false, RatFuncSolver solver = RatFuncSolver::Gaussian);
 
     ~ProbCPISync() override = default;;
 };
@@ -0,0 +1,145 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * A rateless IBLT encodes a set into an unbounded sequence of coded symbols.  Each symbol is an IBLT
+ * cell (count, key xor-sum and hash-check xor-sum), and every element is mapped to symbol 0 and to
+ * a sparse, pseudorandom sequence of later symbols that thins out as the index grows.  A receiver
+ * subtracts the symbols of its own set from those of a sender's, peels pure symbols as in an IBLT,
+ * and can stop as soon as the whole difference is decoded; about 1.35 symbols per difference are
+ * needed on average, whatever the size of the difference.
+ *
+ * The scheme is described in:
+ * Yang, Lei, et al. "Practical Rateless Set Reconciliation." ACM SIGCOMM 2024.
+ */
+
+#ifndef CPISYNC_RATELESSIBLT_H
+#define CPISYNC_RATELESSIBLT_H
+
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <functional>
+#include <NTL/ZZ.h>
+#include <CPISync/Syncs/IBLT.h>
+
+using std::vector;
+using namespace NTL;
+
+class RatelessIBLT {
+    friend class RatelessIBLTTest;
+public:
+    /**
+     * Constructs an empty rateless IBLT.
+     * @param scheme The hash family used to map elements and compute hash-checks; must match the peer's
+     */
+    explicit RatelessIBLT(IBLTHashScheme scheme = IBLTHashScheme::Seeded);
+
+    /**
+     * Adds an element of the local set.
+     * @param key The element to add; a non-negative number
+     * @require no symbols have been encoded or decoded yet
+     */
+    void insert(const ZZ &key);
+
+    /**
+     * Encodes the next coded symbols of the local set.
+     * @param num The number of symbols to encode
+     * @return the byte representation of symbols numSymbols() to numSymbols()+num-1
+     */
+    vector<byte> encode(size_t num);
+
+    /**
+     * Adds the next coded symbols of the peer's set, as produced by its encode, subtracts the symbols
+     * of the local set, and peels as much of the difference as possible.
+     * @param data The byte representation of the symbols
+     * @param len The number of bytes in data
+     * @return true iff the difference is completely decoded.  If data is malformed, returns false
+     * and adds none of its symbols, so numSymbols() does not change.
+     */
+    bool decode(const byte *data, size_t len);
+
+    // @return true iff the difference between the peer's set and the local set is completely decoded
+    bool decoded() const;
+
+    // @return the number of symbols encoded or decoded so far
+    size_t numSymbols() const;
+
+    // @return the decoded elements in the peer's set but not in the local set
+    const vector<ZZ> &remoteOnly() const { return remote; }
+
+    // @return the decoded elements in the local set but not in the peer's set
+    const vector<ZZ> &localOnly() const { return local; }
+
+protected:
+    // A coded symbol, with the semantics of an IBLT cell; valueSum is unused
+    typedef IBLT::HashTableEntry Symbol;
+
+    // An element together with the state of its mapping to symbols
+    struct Source {
+        ZZ key;
+        hash_t check;       // the hash-check of key
+        long sign;          // the amount by which the element changes the count of its symbols
+        std::uint64_t prng; // the state of the pseudorandom generator for the gaps between symbols
+        std::uint64_t next; // the index of the next symbol that the element maps to, or UINT64_MAX if none
+    };
+
+    /**
+     * Sources ordered by the index of the next symbol that they map to, so that a run of symbols can be
+     * encoded by visiting only the elements mapped to them.
+     */
+    class SourceQueue {
+    public:
+        // Adds a source, which maps to src.next and later symbols
+        void push(const Source &src);
+
+        /**
+         * Adds every source into the symbols it maps to among first, ..., first+symbols.size()-1,
+         * and advances the sources past them.
+         * @param symbols The symbols to update, symbols[0] having index first
+         * @param first The index of symbols[0]; no source may map to an earlier, unvisited symbol
+         * @param sign Multiplies the sign of each source
+         */
+        void apply(vector<Symbol> &symbols, std::uint64_t first, long sign);
+
+    private:
+        vector<Source> sources;
+        std::priority_queue<std::pair<std::uint64_t, size_t>, vector<std::pair<std::uint64_t, size_t>>,
+                std::greater<std::pair<std::uint64_t, size_t>>> queue;
+    };
+
+    /**
+     * @param key An element
+     * @param sign The amount by which the element changes the count of its symbols
+     * @return a source for key that maps to symbol 0 next
+     */
+    Source _source(const ZZ &key, long sign) const;
+
+    // Moves src to the next symbol that it maps to; a source past the last index stays at UINT64_MAX
+    static void _advance(Source &src);
+
+    // Peels pure symbols from candidates until none are left
+    void _peel();
+
+    // the hash family
+    IBLTHashScheme hashScheme;
+
+    // the elements of the local set
+    SourceQueue localSources;
+
+    // the decoded elements, so that they can be taken out of symbols that are yet to be received
+    SourceQueue decodedSources;
+
+    // the difference symbols received so far, with local and decoded elements taken out
+    vector<Symbol> symbols;
+
+    // the number of symbols encoded or decoded so far
+    size_t numSyms;
+
+    // indices of symbols that may be pure, awaiting peeling
+    vector<size_t> candidates;
+
+    // decoded elements of the peer's set only, and of the local set only
+    vector<ZZ> remote, local;
+};
+
+#endif //CPISYNC_RATELESSIBLT_H
@@ -0,0 +1,49 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * The RatelessIBLTSync sync method syncs with another RatelessIBLTSync without knowing the size of the
+ * difference in advance.  The client streams coded symbols of a rateless IBLT of its set in growing
+ * batches, and after each batch the server, which peels the symbols against its own set as they arrive,
+ * tells the client whether to keep sending.  Once the server has decoded the whole difference, it sends
+ * the differences back to the client as IBLTSync does.
+ *
+ * The server gives up, and returns a partial list of differences, after SYMBOL_LIMIT_FACTOR symbols per
+ * element of both sets, which is far more than decoding needs except with negligible probability.
+ */
+#ifndef CPISYNC_RATELESSIBLTSYNC_H
+#define CPISYNC_RATELESSIBLTSYNC_H
+
+#include <CPISync/Aux/SyncMethod.h>
+#include <CPISync/Aux/Auxiliary.h>
+#include <CPISync/Syncs/RatelessIBLT.h>
+
+class RatelessIBLTSync : public SyncMethod {
+public:
+    /*
+     * Constructor.
+     * @param scheme The hash family of the coded symbols; must match the peer's, or the server refuses the sync
+     */
+    explicit RatelessIBLTSync(IBLTHashScheme scheme = IBLTHashScheme::Seeded);
+    ~RatelessIBLTSync() override;
+
+    // Implemented parent class methods
+    bool SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
+    bool SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) override;
+
+    string getName() override;
+
+    // The number of symbols in the first batch; later batches grow with the number of symbols sent so far
+    static const size_t INITIAL_BATCH = 16;
+
+    // The server gives up after SYMBOL_LIMIT_FACTOR symbols per element of both sets, plus INITIAL_BATCH
+    static const size_t SYMBOL_LIMIT_FACTOR = 3;
+
+private:
+    // @return a rateless IBLT of the current elements
+    RatelessIBLT _encoder();
+
+    // the hash family of the coded symbols
+    IBLTHashScheme hashScheme;
+};
+
+#endif //CPISYNC_RATELESSIBLTSYNC_H
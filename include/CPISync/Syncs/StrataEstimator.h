@@ -0,0 +1,73 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * A strata estimator estimates the size of the symmetric difference between two sets from a small,
+ * fixed-size summary of each.  Elements are split into strata by the number of trailing zeros of
+ * a hash of the element, so that stratum ii holds about 1/2^(ii+1) of the set, and each stratum is
+ * stored in a small IBLT.  Subtracting two estimators and decoding the strata from the sparsest one
+ * downwards recovers the differences in every stratum until one fails to decode; the differences
+ * found so far, scaled up by the fraction of elements in the strata that were decoded, estimate
+ * the whole difference.
+ *
+ * The estimator is described in:
+ * Eppstein, David, et al. "What's the difference?: efficient set reconciliation without prior context."
+ * ACM SIGCOMM Computer Communication Review 41.4 (2011).
+ */
+
+#ifndef CPISYNC_STRATAESTIMATOR_H
+#define CPISYNC_STRATAESTIMATOR_H
+
+#include <vector>
+#include <NTL/ZZ.h>
+#include <CPISync/Syncs/IBLT.h>
+
+using std::vector;
+using namespace NTL;
+
+class StrataEstimator {
+public:
+    // Communicant needs to access the strata to send and receive them
+    friend class Communicant;
+
+    /**
+     * Constructs an empty estimator.
+     * @param eltSize The size of the elements being added, as for IBLT
+     * @param scheme The hash family of the strata IBLTs; must match the peer's
+     */
+    StrataEstimator(size_t eltSize, IBLTHashScheme scheme = IBLTHashScheme::Seeded);
+
+    /**
+     * Adds an element to the estimator.
+     * @param key The element to add
+     */
+    void insert(const ZZ &key);
+
+    /**
+     * Removes an element from the estimator.
+     * @param key The element to remove; it should have been inserted before
+     */
+    void erase(const ZZ &key);
+
+    /**
+     * Estimates the number of elements in the symmetric difference of the sets summarized by this
+     * estimator and other.  Differences of up to about STRATUM_ENTRIES elements are counted exactly.
+     * @param other An estimator with the same element size and hash scheme
+     * @return the estimated size of the symmetric difference
+     */
+    size_t estimate(const StrataEstimator &other) const;
+
+    // The number of strata; elements whose hash has at least NUM_STRATA-1 trailing zeros share the last stratum
+    static const int NUM_STRATA = 32;
+
+    // The number of entries each stratum IBLT is sized for
+    static const size_t STRATUM_ENTRIES = 50;
+
+protected:
+    // @return the stratum into which key falls
+    static int _stratum(const ZZ &key);
+
+    // one IBLT per stratum
+    vector<IBLT> strata;
+};
+
+#endif //CPISYNC_STRATAESTIMATOR_H
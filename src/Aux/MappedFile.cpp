@@ -0,0 +1,54 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   MappedFile.cpp
+ * See MappedFile.h.
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <CPISync/Aux/MappedFile.h>
+#include <CPISync/Aux/Logger.h>
+
+MappedFile::MappedFile(const string &fileName, size_t size) : fileName(fileName), mem(nullptr), len(size), isFresh(false) {
+    if (size == 0)
+        Logger::error_and_quit("Cannot map an empty file: " + fileName);
+
+    int fd = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        Logger::error_and_quit("Could not open " + fileName + ": " + strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        Logger::error_and_quit("Could not stat " + fileName + ": " + strerror(errno));
+    }
+    if ((size_t) st.st_size != size) {
+        // start over from zeros, since the contents cannot be for this size
+        isFresh = true;
+        if (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t) size) < 0) {
+            close(fd);
+            Logger::error_and_quit("Could not resize " + fileName + ": " + strerror(errno));
+        }
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (addr == MAP_FAILED)
+        Logger::error_and_quit("Could not map " + fileName + ": " + strerror(errno));
+    mem = static_cast<byte *>(addr);
+}
+
+MappedFile::~MappedFile() {
+    flush();
+    munmap(mem, len);
+}
+
+void MappedFile::flush(size_t prefix) {
+    if (msync(mem, prefix < len ? prefix : len, MS_SYNC) < 0)
+        Logger::error_and_quit("Could not write back " + fileName + ": " + strerror(errno));
+}
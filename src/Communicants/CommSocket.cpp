@@ -181,11 +181,11 @@ void CommSocket::commSend(const char* toSend, size_t len) {
             Logger::error_and_quit(toStr(state) + " encountered error in send"
                     + " numBytes is: " + toStr(numBytes));
         }
-        if (numSent != numBytes) {
+        if (static_cast<unsigned long>(numSent) != numBytes) {
             Logger::gLog(Logger::COMM_DETAILS,
                     "!!! Send packet fragmentation. numSent: " + toStr(numSent) + " of numBytes " + toStr(numBytes));
             doAgain = true;
-            if (numBytes > numSent) {
+            if (numBytes > static_cast<unsigned long>(numSent)) {
                 numBytes -= numSent;
                 toSend += numSent;
             } else {
@@ -203,21 +203,18 @@ string CommSocket::commRecv(unsigned long numBytes) {
         Logger::error_and_quit("Not connected to a socket!");
 
     ssize_t numRecv;  // number of bytes received in this call
-    auto tmpBuf = new char[numBytes];  // buffer into which received bytes are placed
+    string result(numBytes, '\0');  // receive straight into the result, rather than copying from a temporary buffer
 
     // wait until the buffer has been filled
-    if ((numRecv = recv(my_fd, tmpBuf, numBytes * sizeof (char), MSG_WAITALL)) < 0)
+    if ((numRecv = recv(my_fd, &result[0], numBytes * sizeof (char), MSG_WAITALL)) < 0)
         Logger::error_and_quit("Error receiving data on the socket!");
-    if (numRecv != numBytes)
+    if (static_cast<unsigned long>(numRecv) != numBytes)
         Logger::error_and_quit("Received less or more than the prescribed number of characters in commRecv.");
 
     addRecvBytes(static_cast<unsigned long>(numRecv));  // update the received byte counter
 
-    // clean up
     Logger::gLog(Logger::COMM_DETAILS, "<RAW RECV> " + toStr(numRecv) + string(" bytes received (base64): ")
-            + base64_encode(tmpBuf, static_cast<size_t>(numRecv)));
-    string result(tmpBuf, static_cast<unsigned long>(numRecv));
-    delete[] tmpBuf;
+            + base64_encode(result.data(), static_cast<size_t>(numRecv)));
 
     return result;
 }
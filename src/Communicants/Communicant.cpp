@@ -3,6 +3,27 @@
 #include <NTL/RR.h>
 #include <CPISync/Communicants/Communicant.h>
 
+namespace {
+    // added to the fingerprint size in the Cuckoo handshake to mark
+    // delta transfer; far beyond any fingerprint size, so that a peer
+    // that does not know delta transfer sees a mismatch
+    const size_t CUCKOO_DELTA_MARK = (size_t) 1 << 30;
+
+    // added to the bucket size in the Cuckoo handshake to mark the native
+    // hashes, so that a peer still on the ZZ and string hashes, whose
+    // filters would answer lookups wrongly, sees a mismatch
+    const size_t CUCKOO_NATIVE_MARK = (size_t) 1 << 30;
+
+    // added to the element size in the IBLT handshake to mark the seeded
+    // hash family; the legacy family sends the bare element size, exactly
+    // as versions without seeded hashing did
+    const size_t IBLT_SEEDED_MARK = (size_t) 1 << 30;
+
+    string schemeName(IBLTHashScheme scheme) {
+        return scheme == IBLTHashScheme::Seeded ? "seeded" : "legacy";
+    }
+}
+
 Communicant::Communicant() {
     resetCommCounters();
     xferBytesTot = xferBytes = recvBytesTot = recvBytes = 0;
@@ -74,27 +95,39 @@ bool Communicant::establishModSend(bool oneWay /* = false */) {
         return (commRecv_byte() != SYNC_FAIL_FLAG);
 }
 
-bool Communicant::establishIBLTSend(const size_t size, const size_t eltSize, bool oneWay /* = false */) {
+bool Communicant::establishIBLTSend(const size_t size, const size_t eltSize, bool oneWay /* = false */,
+                                    IBLTHashScheme scheme /* = IBLTHashScheme::Seeded */) {
     commSend((long) size);
-    commSend((long) eltSize);
+    commSend((long) (eltSize + (scheme == IBLTHashScheme::Seeded ? IBLT_SEEDED_MARK : 0)));
     if (oneWay)
         return true;  // i.e. don't wait for a response
     else
         return (commRecv_byte() != SYNC_FAIL_FLAG);
 }
 
-bool Communicant::establishIBLTRecv(const size_t size, const size_t eltSize, bool oneWay /* = false */) {
+bool Communicant::establishIBLTRecv(const size_t size, const size_t eltSize, bool oneWay /* = false */,
+                                    IBLTHashScheme scheme /* = IBLTHashScheme::Seeded */) {
     // receive other size and eltSize. both must be read, even if the first parameter is wrong
-    long otherSize = commRecv_long();
-    long otherEltSize = commRecv_long();
+    auto otherSize = narrow_cast<size_t>(commRecv_long());
+    auto otherEltSize = narrow_cast<size_t>(commRecv_long());
+    IBLTHashScheme otherScheme = IBLTHashScheme::Legacy;
+    if (otherEltSize >= IBLT_SEEDED_MARK) {
+        otherScheme = IBLTHashScheme::Seeded;
+        otherEltSize -= IBLT_SEEDED_MARK;
+    }
 
-    if(otherSize == size && otherEltSize == eltSize) {
+    if(otherSize == size && otherEltSize == eltSize && otherScheme == scheme) {
         if(!oneWay)
             commSend(SYNC_OK_FLAG);
         return true;
     } else {
+        if (otherScheme != scheme)
+            // the tables would both decode, but to garbage, so say so whatever the log level
+            Logger::error("IBLT hash schemes do not match: mine=" + schemeName(scheme)
+            + " vs other=" + schemeName(otherScheme) + "; both peers must set the same legacyIBLTHash.");
         Logger::gLog(Logger::COMM, "IBLT params do not match: mine(size=" + toStr(size) + ", eltSize="
-        + toStr(eltSize) + ") vs other(size=" + toStr(otherSize) + ", eltSize=" + toStr(otherEltSize) + ").");
+        + toStr(eltSize) + ", hash=" + schemeName(scheme) + ") vs other(size=" + toStr(otherSize) + ", eltSize="
+        + toStr(otherEltSize) + ", hash=" + schemeName(otherScheme) + ").");
         if(!oneWay)
             commSend(SYNC_FAIL_FLAG);
         return false;
@@ -102,9 +135,11 @@ bool Communicant::establishIBLTRecv(const size_t size, const size_t eltSize, boo
 }
 
 bool Communicant::establishCuckooSend(const size_t fngprtSize, const size_t bucketSize,
-                                      const size_t filterSize, const size_t maxKicks) {
-    commSend((long) fngprtSize);
-    commSend((long) bucketSize);
+                                      const size_t filterSize, const size_t maxKicks,
+                                      bool deltaTransfer /* = false */) {
+    // the mark keeps the handshake of the default mode as it was
+    commSend((long) (fngprtSize + (deltaTransfer ? CUCKOO_DELTA_MARK : 0)));
+    commSend((long) (bucketSize + CUCKOO_NATIVE_MARK));
     commSend((long) filterSize);
     commSend((long) maxKicks);
 
@@ -112,25 +147,40 @@ bool Communicant::establishCuckooSend(const size_t fngprtSize, const size_t buck
 }
 
 bool Communicant::establishCuckooRecv(size_t fngprtSize, size_t bucketSize,
-                                      size_t filterSize, size_t maxKicks) {
-    long otherFngprtSize = commRecv_long();
-    long otherBucketSize = commRecv_long();
-    long otherFilterSize = commRecv_long();
-    long otherMaxKicks = commRecv_long();
+                                      size_t filterSize, size_t maxKicks,
+                                      bool deltaTransfer /* = false */) {
+    auto otherFngprtSize = narrow_cast<size_t>(commRecv_long());
+    auto otherBucketSize = narrow_cast<size_t>(commRecv_long());
+    auto otherFilterSize = narrow_cast<size_t>(commRecv_long());
+    auto otherMaxKicks = narrow_cast<size_t>(commRecv_long());
+    bool otherDeltaTransfer = otherFngprtSize >= CUCKOO_DELTA_MARK;
+    if (otherDeltaTransfer)
+        otherFngprtSize -= CUCKOO_DELTA_MARK;
+    bool otherNative = otherBucketSize >= CUCKOO_NATIVE_MARK;
+    if (otherNative)
+        otherBucketSize -= CUCKOO_NATIVE_MARK;
+    else
+        // the filters would both load, but answer lookups wrongly, so say so whatever the log level
+        Logger::error("Cuckoo hashes do not match: the other peer uses the ZZ and string hashes of earlier "
+                      "versions; both peers must run a version with the native hashes.");
 
-    if (otherFngprtSize == fngprtSize
+    if (otherNative
+        && otherFngprtSize == fngprtSize
         && otherBucketSize == bucketSize
         && otherFilterSize == filterSize
-        && otherMaxKicks == maxKicks) {
+        && otherMaxKicks == maxKicks
+        && otherDeltaTransfer == deltaTransfer) {
         commSend(SYNC_OK_FLAG);
         return true;
     } else {
         Logger::gLog(Logger::COMM, "Cuckoo params do not match: mine(f="     +
                      toStr(fngprtSize) + ", b=" + toStr(bucketSize) + ", m=" +
                      toStr(filterSize) + ", kicks=" + toStr(maxKicks)        +
+                     ", delta=" + toStr(deltaTransfer)                       +
                      ") vs other(f=" + toStr(otherFngprtSize) + ", b="       +
                      toStr(otherBucketSize) + "m= " + toStr(otherFilterSize) +
-                     ", kicks=" + toStr(otherMaxKicks) + ").");
+                     ", kicks=" + toStr(otherMaxKicks)                       +
+                     ", delta=" + toStr(otherDeltaTransfer) + ").");
         commSend(SYNC_FAIL_FLAG);
         return false;
     }
@@ -285,6 +335,51 @@ void Communicant::commSend(const ZZ& num, Nullable<size_t> size) {
 
 }
 
+template <class IBLTType>
+void Communicant::_commSendIBLTCells(const IBLTType &iblt, size_t numCells,
+                                     size_t trailerSize, std::function<byte *(byte *)> writeTrailer) {
+    size_t total = trailerSize;
+    for (size_t idx = 0; idx < numCells; idx++)
+        total += iblt._cellSize(idx);
+    Logger::gLog(Logger::COMM, "... attempting to send: IBLT of " + toStr(numCells) + " cells in "
+                               + toStr(total) + " bytes");
+    commSend((long) total);
+
+    // fill the chunk cell by cell, sending it whenever the next cell does not fit
+    vector<byte> chunk(total < IBLT_CHUNK_BYTES ? total : IBLT_CHUNK_BYTES);
+    size_t used = 0;
+    auto makeRoom = [&](size_t len) {
+        if (used + len > chunk.size()) {
+            if (used > 0)
+                commSend(reinterpret_cast<const char *>(chunk.data()), used);
+            used = 0;
+            if (len > chunk.size())
+                chunk.resize(len);
+        }
+    };
+    for (size_t idx = 0; idx < numCells; idx++) {
+        size_t len = iblt._cellSize(idx);
+        makeRoom(len);
+        iblt._writeCell(idx, chunk.data() + used);
+        used += len;
+    }
+    if (trailerSize > 0) {
+        makeRoom(trailerSize);
+        writeTrailer(chunk.data() + used);
+        used += trailerSize;
+    }
+    if (used > 0)
+        commSend(reinterpret_cast<const char *>(chunk.data()), used);
+}
+
+template <class IBLTType>
+void Communicant::_commRecvIBLTCells(IBLTType &iblt) {
+    auto sz = narrow_cast<size_t>(commRecv_long());
+    string received = commRecv(sz);
+    Logger::gLog(Logger::COMM, "... received: IBLT in " + toStr(sz) + " bytes");
+    iblt._parseBytes(reinterpret_cast<const byte *>(received.data()), received.size());
+}
+
 void Communicant::commSendIBLTNHash(const IBLT &iblt, bool sync)
 {
     if (!sync)
@@ -293,11 +388,11 @@ void Communicant::commSendIBLTNHash(const IBLT &iblt, bool sync)
         commSend(toStr<size_t>(iblt.eltSize()));
     }
 
-    vector<byte> res = iblt.toByteVector();
-    commSend(ustring(res.data(), res.size()));
+    _commSendIBLTCells(iblt, iblt.hashTable.size(), iblt._trailerSize(),
+                       [&iblt](byte *out) { return iblt._writeTrailer(out); });
 }
 
-IBLT Communicant::commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> eltSize)
+IBLT Communicant::commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> eltSize, IBLTHashScheme scheme)
 {
     size_t numSize;
     size_t numEltSize;
@@ -315,12 +410,10 @@ IBLT Communicant::commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> elt
 
     IBLT theirs;
     theirs.valueSize = numEltSize;
+    theirs.hashScheme = scheme;
     theirs.hashTable.resize(numSize);
 
-    ustring serialIBLT = commRecv_ustring();
-    vector<byte> rep;
-    rep.insert(rep.begin(), serialIBLT.begin(), serialIBLT.end());
-    theirs.fromByteVector(rep);
+    _commRecvIBLTCells(theirs);
     return theirs;
 }
 
@@ -464,11 +557,20 @@ void Communicant::commSend(const IBLT& iblt, bool sync) {
         commSend((long) iblt.eltSize());
     }
 
-    vector<unsigned char> myIBLTBytes = iblt.toByteVector();
-    commSend(ustring(myIBLTBytes.data(), myIBLTBytes.size()));
+    _commSendIBLTCells(iblt, iblt.hashTable.size(), iblt._trailerSize(),
+                       [&iblt](byte *out) { return iblt._writeTrailer(out); });
 }
 
-IBLT Communicant::commRecv_IBLT(Nullable<size_t> size, Nullable<size_t> eltSize) {
+void Communicant::commSend(const IBLTMultiset& iblt, bool sync) {
+    if (!sync) {
+        commSend((long) iblt.size());
+        commSend((long) iblt.eltSize());
+    }
+
+    _commSendIBLTCells(iblt, iblt.size());
+}
+
+IBLT Communicant::commRecv_IBLT(Nullable<size_t> size, Nullable<size_t> eltSize, IBLTHashScheme scheme) {
     size_t numSize;
     size_t numEltSize;
 
@@ -482,17 +584,14 @@ IBLT Communicant::commRecv_IBLT(Nullable<size_t> size, Nullable<size_t> eltSize)
 
     IBLT theirs;
     theirs.valueSize = numEltSize;
+    theirs.hashScheme = scheme;
     theirs.hashTable.resize(numSize);
 
-    ustring serialIBLT = commRecv_ustring();
-    vector<byte> rep;
-    rep.insert(rep.begin(), serialIBLT.begin(), serialIBLT.end());
-
-    theirs.fromByteVector(rep);
+    _commRecvIBLTCells(theirs);
     return theirs;
 }
 
-IBLTMultiset Communicant::commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<size_t> eltSize) {
+IBLTMultiset Communicant::commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<size_t> eltSize, IBLTHashScheme scheme) {
     size_t numSize;
     size_t numEltSize;
 
@@ -506,17 +605,57 @@ IBLTMultiset Communicant::commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<
 
     IBLTMultiset theirs;
     theirs.valueSize = numEltSize;
+    theirs.hashScheme = scheme;
     theirs.hashTable.resize(numSize);
 
-    ustring serialIBLT = commRecv_ustring();
-    vector<byte> rep;
-    rep.insert(rep.begin(), serialIBLT.begin(), serialIBLT.end());
+    _commRecvIBLTCells(theirs);
+    return theirs;
+}
+
+
+void Communicant::commSend(const IBLTFlat& iblt, bool sync) {
+    if (!sync) {
+        commSend((long) iblt.size());
+        commSend((long) iblt.eltSize());
+    }
+
+    _commSendIBLTCells(iblt, iblt.size());
+}
 
-    theirs.fromByteVector(rep);
+IBLTFlat Communicant::commRecv_IBLTFlat(Nullable<size_t> size, Nullable<size_t> eltSize, IBLTHashScheme scheme) {
+    size_t numSize;
+    size_t numEltSize;
+
+    if(size.isNullQ() || eltSize.isNullQ()) {
+        numSize = (size_t) commRecv_long();
+        numEltSize = (size_t) commRecv_long();
+    } else {
+        numSize = *size;
+        numEltSize = *eltSize;
+    }
+
+    IBLTFlat theirs;
+    theirs._init(numSize, numEltSize, scheme);
+
+    _commRecvIBLTCells(theirs);
     return theirs;
 }
 
 
+void Communicant::commSend(const StrataEstimator &se) {
+    Logger::gLog(Logger::COMM, "... attempting to send: strata estimator");
+    for (const IBLT &stratum : se.strata)
+        commSend(stratum, true);
+}
+
+StrataEstimator Communicant::commRecv_StrataEstimator(size_t eltSize, IBLTHashScheme scheme) {
+    // the strata have a fixed size, so only their cells are sent
+    StrataEstimator theirs(eltSize, scheme);
+    for (IBLT &stratum : theirs.strata)
+        _commRecvIBLTCells(stratum);
+    return theirs;
+}
+
 void Communicant::commSend(const Cuckoo& cf) {
     vector<byte> rep = cf.toByteVector();
     commSend(ustring(rep.data(), rep.size()));
@@ -60,6 +60,10 @@ ZZ DataObject::to_ZZ() const {
     return myBuffer;
 }
 
+std::uint64_t DataObject::hash64(std::uint64_t seed) const {
+    return seededHash(myBuffer, seed);
+}
+
 string DataObject::to_string() const {
     return RepIsInt?toStr(myBuffer):unpack(myBuffer);
 }
@@ -15,6 +15,7 @@
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Aux/SyncMethod.h>
 #include <CPISync/Syncs/CPISync.h>
+#include <CPISync/Syncs/CharPolyEvals.h>
 #include <CPISync/Aux/Exceptions.h>
 
 // namespaces
@@ -26,20 +27,19 @@ void CPISync::initData(long num) {
     Logger::gLog(Logger::METHOD,"Entering CPISync::initData");
     // set the lengths
     sampleLoc.SetLength(num);
-    CPI_evals.SetLength(num);
 
     // populate the arrays
-    for (int ii = 0; ii < num; ii++) {
+    for (int ii = 0; ii < num; ii++)
         sampleLoc[ii] = to_ZZ_p(DATA_MAX) + ii + 1; // i.e. from the region outside where valid data might lie
-        CPI_evals[ii] = 1;
-    }
+    CPI_evals = CharPolyEvals::make(sampleLoc); // all 1, in word-sized arithmetic if the field allows
 
     probCPI = oneWay = keepAlive = false; // assume not OneWay or Probabilistic synchronization unless otherwise stated, and manage our own communicant connections
     SyncID = SYNC_TYPE::CPISync;
 }
 
-CPISync::CPISync(long m_bar, long bits, int epsilon, int redundant, bool hashes /* = false */) :
-maxDiff(m_bar), probEps(epsilon), hashQ(hashes) {
+CPISync::CPISync(long m_bar, long bits, int epsilon, int redundant, bool hashes /* = false */,
+                 RatFuncSolver solver /* = RatFuncSolver::Gaussian */) :
+maxDiff(m_bar), probEps(epsilon), hashQ(hashes), ratFuncSolver(solver) {
 Logger::gLog(Logger::METHOD,"Entering CPISync::CPISync");
 
     // set default parameters
@@ -85,10 +85,18 @@ Logger::gLog(Logger::METHOD,"Entering CPISync::CPISync");
     initData(maxDiff + redundant_k); // initialize sample locations and metadata
 }
 
+CPISync::CPISync(const CPISync *params) :
+probCPI(params->probCPI), oneWay(params->oneWay), hashQ(params->hashQ), keepAlive(params->keepAlive),
+bitNum(params->bitNum), maxDiff(params->maxDiff), probEps(params->probEps), fieldSize(params->fieldSize),
+sampleLoc(params->sampleLoc), currDiff(params->currDiff), redundant_k(params->redundant_k),
+ratFuncSolver(params->ratFuncSolver), CPI_evals(params->CPI_evals->emptyCopy()), DATA_MAX(params->DATA_MAX) {
+    SyncID = params->SyncID;
+}
+
 CPISync::~CPISync() {
     sampleLoc.kill();
     CPI_hash.clear();
-    CPI_evals.kill();
+    CPI_hashOf.clear();
 }
 
 string CPISync::getName() {
@@ -133,6 +141,9 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
         return false;
     }
 
+    if (ratFuncSolver == RatFuncSolver::Euclidean && mbar > 0)
+        return _ratFuncInterpEuclid(evals, mAbar, mBbar, P_vec, Q_vec);
+
     // 1. Construct and solve a linear equations that produces the interpolation
     // van_matrix is, in terms of the article referenced above:
     //    k_i ^{d1-1} ... 1 | - f_i k_i^{d2-1} ... -f_i || f_i k_i^d2 - k_i^d1
@@ -144,10 +155,10 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
     for (ii = 0; ii < mbar; ii++) {
         // might be possible to streamline for large mAbar/mBbar
         for (jj = 0; jj < mAbar; jj++)
-            van_matrix[ii][jj] = power(sampleLoc[ii], mAbar - jj - 1);
+            van_matrix[ii][jj] = _locPower(ii, mAbar - jj - 1);
         for (jj = 0; jj < mBbar; jj++)
-            van_matrix[ii][jj + mAbar] = -evals[ii] * power(sampleLoc[ii], mBbar - jj - 1);
-        van_matrix[ii][mAbar + mBbar] = evals[ii] * power(sampleLoc[ii], mBbar) - power(sampleLoc[ii], mAbar);
+            van_matrix[ii][jj + mAbar] = -evals[ii] * _locPower(ii, mBbar - jj - 1);
+        van_matrix[ii][mAbar + mBbar] = evals[ii] * _locPower(ii, mBbar) - _locPower(ii, mAbar);
     }
 
     mat_ZZ_p copyv_matrix(van_matrix); // unadulterated copy of van_matrix
@@ -175,7 +186,7 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
                 van_matrix[ii][jj] = copyv_matrix[ii][jj + mDiff];
             for (jj = 0; jj < mBbar; jj++)
                 van_matrix[ii][jj + mAbar] = copyv_matrix[ii][jj + mAbar + mDiff + mDiff];
-            van_matrix[ii][mAbar + mBbar] = evals[ii] * power(sampleLoc[ii], mBbar) - power(sampleLoc[ii], mAbar);
+            van_matrix[ii][mAbar + mBbar] = evals[ii] * _locPower(ii, mBbar) - _locPower(ii, mAbar);
         }
 
         // row-reduce the resulting matrix
@@ -212,6 +223,102 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
     return true;
 }
 
+const ZZ_p &CPISync::_locPower(long ii, long exp) {
+    if (locPowers.size() <= (size_t) ii)
+        locPowers.resize(sampleLoc.length());
+
+    // extend the row of powers by multiplication, as far as needed
+    vec_ZZ_p &row = locPowers[ii];
+    if (row.length() == 0)
+        append(row, to_ZZ_p(1));
+    while (row.length() <= exp)
+        append(row, row[row.length() - 1] * sampleLoc[ii]);
+    return row[exp];
+}
+
+bool CPISync::_ratFuncInterpEuclid(const vec_ZZ_p& evals, long mAbar, long mBbar, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) const {
+    Logger::gLog(Logger::METHOD,"Entering CPISync::_ratFuncInterpEuclid");
+    long ii, mbar = evals.length();
+
+    // 1. U interpolates the evaluations, and V vanishes on their sample locations
+    vec_ZZ_p locs;
+    locs.SetLength(mbar);
+    for (ii = 0; ii < mbar; ii++)
+        locs[ii] = sampleLoc[ii];
+    ZZ_pX U, V;
+    interpolate(U, locs, evals);
+    BuildFromRoots(V, locs);
+
+    // 2. Run the extended Euclidean algorithm on V and U, keeping two consecutive remainders (rr, rrNext)
+    // ... and their cofactors (tt, ttNext) with rr = tt*U mod V, until the first remainder of degree at most mAbar
+    ZZ_pX rr = V, tt, rrNext = U, ttNext, quot, rem;
+    NTL::set(ttNext);
+    while (deg(rr) > mAbar) {
+        if (IsZero(rrNext)) {
+            Logger::gLog(Logger::METHOD, "Euclidean function interpolation failed, no remainder of the numerator's degree.\n");
+            return false;
+        }
+        DivRem(quot, rem, rr, rrNext);
+        rr = rrNext;
+        rrNext = rem;
+        rem = tt - quot * ttNext;
+        tt = ttNext;
+        ttNext = rem;
+    }
+
+    // 3. Recover monic P and Q from the remainders
+    ZZ_pX P_poly, Q_poly;
+    if (mAbar + mBbar == mbar && deg(rr) == mAbar) {
+        // ... as many unknowns as samples: the numerator and denominator of full degree combine two consecutive rows,
+        // ... rr supplying the leading term of P and ttNext (of degree mBbar) that of Q
+        ZZ_p rrScale = inv(LeadCoeff(rr)), nextScale = inv(LeadCoeff(ttNext));
+        P_poly = rr * rrScale + rrNext * nextScale;
+        Q_poly = tt * rrScale + ttNext * nextScale;
+    } else {
+        // ... otherwise the rational function in lowest terms is rr/tt, up to a constant factor
+        if (IsZero(rr) || deg(rr) - deg(tt) != mAbar - mBbar) {
+            Logger::gLog(Logger::METHOD, "Euclidean function interpolation failed, the degrees do not match.\n");
+            return false;
+        }
+        ZZ_p scale = inv(LeadCoeff(tt));
+        P_poly = rr * scale;
+        Q_poly = tt * scale;
+        if (!IsOne(LeadCoeff(P_poly))) {
+            Logger::gLog(Logger::METHOD, "Euclidean function interpolation failed, no monic numerator.\n");
+            return false;
+        }
+    }
+
+    // 4. Store the result of the interpolation in P_vec and Q_vec
+    P_vec.SetLength(deg(P_poly) + 1);
+    for (ii = 0; ii <= deg(P_poly); ii++)
+        P_vec[ii] = coeff(P_poly, ii);
+    Q_vec.SetLength(deg(Q_poly) + 1);
+    for (ii = 0; ii <= deg(Q_poly); ii++)
+        Q_vec[ii] = coeff(Q_poly, ii);
+
+    return true;
+}
+
+bool CPISync::_splitRoots(const ZZ_pX& poly, vec_ZZ_p& roots) {
+    roots.SetLength(0);
+    if (deg(poly) <= 0)
+        return true;
+
+    // poly splits into linear factors iff it divides x^p - x, i.e. x^p = x mod poly
+    ZZ_pX xModPoly, xPowModPoly;
+    SetX(xModPoly);
+    xModPoly %= poly;
+    PowerXMod(xPowModPoly, ZZ_p::modulus(), poly);
+    if (xPowModPoly != xModPoly)
+        return false;
+
+    // Cantor-Zassenhaus equal-degree splitting [NTL's FindRoots], which needs neither the linear algebra
+    // of Berlekamp's method nor the distinct-degree factorization of a general factoring routine
+    FindRoots(roots, poly);
+    return true;
+}
+
 bool CPISync::find_roots(vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec, vec_ZZ_p& numerator, vec_ZZ_p& denominator) {
 Logger::gLog(Logger::METHOD,"Entering CPISync::find_roots");
     // 0. initialization
@@ -236,41 +343,20 @@ Logger::gLog(Logger::METHOD,"Entering CPISync::find_roots");
         return false;
     }
 
-    // 2. Factor the two polynomials
-    // SFBerlekamp function defined in ZZ_pXFactoring module - "Berlekamp" factoring approach [Shoup, J. Symbolic Comp. 20:363-397, 1995].
-    vec_ZZ_pX nn, dd;
-    nn = SFBerlekamp(P_poly);
-    if (nn.length() > 0)
-        for (const ZZ_pX& fact : nn)
-            if (deg(fact) > 1) { // ended with a non-linear factor
-                Logger::gLog(Logger::METHOD, "Cannot reduce P_poly to linear factors..\n");
-                return false;
-            }
-
-    dd = SFBerlekamp(Q_poly);
-    if (dd.length() > 0)
-        for (const ZZ_pX& fact : dd)
-            if (deg(fact) > 1) { // ended with a non-linear factor
-                Logger::gLog(Logger::METHOD, "Cannot reduce Q_poly to linear factors.\n");
-                return false;
-            }
-
-    // 3. Put the results into the numerator and denominator vectors and return
-    numerator.SetLength(deg(P_poly));
-    denominator.SetLength(deg(Q_poly));
-
-    for (int ii = 0; ii < nn.length(); ii++)
-        numerator[ii] = -ConstTerm(nn[ii]);
-    for (int ii = 0; ii < dd.length(); ii++)
-        denominator[ii] = -ConstTerm(dd[ii]);
+    // 2. Find the roots of the two polynomials directly, into the numerator and denominator vectors
+    if (!_splitRoots(P_poly, numerator)) {
+        Logger::gLog(Logger::METHOD, "Cannot reduce P_poly to linear factors..\n");
+        return false;
+    }
+    if (!_splitRoots(Q_poly, denominator)) {
+        Logger::gLog(Logger::METHOD, "Cannot reduce Q_poly to linear factors.\n");
+        return false;
+    }
 
     // free up memory
     P_poly.kill();
     Q_poly.kill();
 
-    nn.kill();
-    dd.kill();
-
     return true;
 }
 
@@ -288,11 +374,12 @@ Logger::gLog(Logger::METHOD,"Entering CPISync::set_reconcile");
     } else { // we both have something new
         vec_ZZ_p coefficient_P, coefficient_Q;
 
-        // compute rational function evals
-        vec_ZZ_p ratFuncEvals;
+        // compute rational function evals, beyond those kept from an earlier round
         long metalength = min(otherEvals.length(), currDiff);
-        for (long ii = 0; ii < metalength; ii++)
-          append(ratFuncEvals, otherEvals[ii] / CPI_evals[ii]);
+        if (ratFuncEvals.length() > metalength)
+            ratFuncEvals.SetLength(metalength);
+        for (long ii = ratFuncEvals.length(); ii < metalength; ii++)
+          append(ratFuncEvals, otherEvals[ii] / CPI_evals->get(ii));
 
         // attempt to interpolate based on these evals
         if (!ratFuncInterp(ratFuncEvals, otherSetSize, CPI_hash.size(), coefficient_P, coefficient_Q))
@@ -311,6 +398,44 @@ Logger::gLog(Logger::METHOD,"Entering CPISync::set_reconcile");
     return true;
 }
 
+void CPISync::sendEvals(const shared_ptr<Communicant> &commSync) {
+    commSync->commSend((long) CPI_hash.size()); // ... first outputs how many set elements the client has
+
+    // ... then the values in a list:  [x1 x2 x3 ... ]
+    vec_ZZ_p valList;
+    for (int ii = 0; ii < currDiff; ii++)
+        append(valList, CPI_evals->get(ii));
+    for (int ii = 0; ii < redundant_k; ii++)
+        append(valList, CPI_evals->get(currDiff + ii));
+    commSync->commSend(valList);
+}
+
+bool CPISync::reconcileEvals(long otherSetSize, const vec_ZZ_p &otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other,
+                             bool more /* = false */) {
+    if (!more)
+        ratFuncEvals.kill(); // these evaluations are not those of the last call
+    vec_ZZ_p value_other, value_self;
+    for (long ii = 0; ii < redundant_k; ii++) {
+        append(value_other, otherEvals[currDiff + ii]);
+        append(value_self, CPI_evals->get(currDiff + ii));
+    }
+
+    // attempt to reconcile with the presumed number of differences
+    if (!set_reconcile(otherSetSize, otherEvals, delta_self, delta_other))
+        return false;
+
+    // perform a check with the redundant data
+    for (long jj = 0; jj < redundant_k; jj++) {
+        for (const auto &ii : delta_other)
+            value_self[jj] *= (sampleLoc[currDiff + jj] - ii);
+        for (const auto &ii : delta_self)
+            value_other[jj] *= (sampleLoc[currDiff + jj] - ii);
+        if (value_self[jj] != value_other[jj])
+            return false;
+    }
+    return true;
+}
+
 void CPISync::_sendSetElem(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 						   const ZZ_p &element) {
     Logger::gLog(Logger::METHOD,"Entering CPISync::sendSetElem");
@@ -345,16 +470,20 @@ void CPISync::_makeStructures(const shared_ptr<Communicant> &commSync, list<shar
 							  list<shared_ptr<DataObject>> &otherMinusSelf, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other) {
     Logger::gLog(Logger::METHOD,"Entering CPISync::makeStructures");
     // Send self minus other
-    try {
-        for (const ZZ_p& dop : delta_self)
-			_sendSetElem(commSync, selfMinusOther, dop);
-    } catch (const SyncFailureException& s) {
-        throw (s); // rethrow the exception onward
-    }
+    sendElems(commSync, delta_self, selfMinusOther);
 
     // Receive other minus self
-    for (const auto &ii : delta_other)
-		_recvSetElem(commSync, otherMinusSelf, ii);
+    recvElems(commSync, delta_other, otherMinusSelf);
+}
+
+void CPISync::sendElems(const shared_ptr<Communicant> &commSync, const vec_ZZ_p &hashes, list<shared_ptr<DataObject>> &selfMinusOther) {
+    for (const ZZ_p& dop : hashes)
+        _sendSetElem(commSync, selfMinusOther, dop);
+}
+
+void CPISync::recvElems(const shared_ptr<Communicant> &commSync, const vec_ZZ_p &hashes, list<shared_ptr<DataObject>> &otherMinusSelf) {
+    for (const auto &ii : hashes)
+        _recvSetElem(commSync, otherMinusSelf, ii);
 }
 
 void CPISync::SendSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay /* = false */) {
@@ -430,22 +559,9 @@ bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_pt
 
         // 1. Transmit characteristic polynomial values
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        commSync->commSend((long) CPI_hash.size()); // ... first outputs how many set elements the client has
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
-
-        // ... produce the values in a list:  [x1 x2 x3 ... ]
-        vec_ZZ_p valList;
-        for (int ii = 0; ii < currDiff; ii++)
-            append(valList, CPI_evals[ii]);
-        for (int ii = 0; ii < redundant_k; ii++)
-            append(valList, CPI_evals[currDiff + ii]);
-
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
-        commSync->commSend(valList);
+        sendEvals(commSync);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
-        valList.kill();
-
         // 2. Get more characteristic polynomial values if needed
         // TODO: Why is idle time counted here? That is the reason why
         // we see huge idle time for CPISyncs in Novak's presentation.
@@ -472,7 +588,7 @@ bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_pt
                 // Send more samples and try again
                 vec_ZZ_p tmp_vec;
                 for (long ii = 0; ii < min(currDiff, maxDiff - currDiff); ii++)
-                    append(tmp_vec, CPI_evals[currDiff +redundant_k + ii]);
+                    append(tmp_vec, CPI_evals->get(currDiff +redundant_k + ii));
 
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
                 commSync->commSend(tmp_vec);
@@ -566,73 +682,38 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
     mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
     bool result = true; // continues looping while result is true
+    bool more = false; // true once recv_meta extends the evaluations of an earlier round
     do {
         delta_other.kill();
         delta_self.kill();
 
-        vec_ZZ_p meta_other, meta_self;
-        for (long ii = 0; ii < redundant_k; ii++) {
-                append(meta_other, recv_meta[currDiff + ii]);
-                append(meta_self, CPI_evals[currDiff + ii]);
-        }
-        
         // attempt to reconcile with the presumed number of differences
-        bool succeed = set_reconcile(otherSetSize, recv_meta, delta_self, delta_other);
-        if (succeed) { // the node reconciliation might have been successful
-            
-            // PERFORM some added checks
-            vec_ZZ_p value_self = meta_self;
-            vec_ZZ_p value_other = meta_other;
-            // perform a check with the redundant data
-            for (long jj = 0; jj < redundant_k; jj++) {
-                for (const auto &ii : delta_other) {
-                    //value_self[jj] *= (sampleLoc[maxDiff + jj] - delta_other[ii]);
-                     value_self[jj] *= (sampleLoc[currDiff + jj] - ii);
-                }
-            }
-
-            for (long jj = 0; jj < redundant_k; jj++) {
-                for (const auto &ii : delta_self) {
-                    //value_other[jj] *= (sampleLoc[maxDiff + jj] - delta_self[ii]);
-                    value_other[jj] *= (sampleLoc[currDiff + jj] - ii);
-                }
-            }
+        bool succeed = reconcileEvals(otherSetSize, recv_meta, delta_self, delta_other, more);
+        if (succeed) { // only do this if reconciliation has succeeded
+            Logger::gLog(Logger::METHOD, "CPISync succeeded.\n");
 
-            for (long jj = 0; jj < redundant_k; jj++) {
-                if (value_self[jj] != value_other[jj]) {
-                    succeed = false;
-                    break; // no need to keep going
-                }
+            if (!oneWay) {
+                mySyncStats.timerStart(SyncStats::COMM_TIME);
+                commSync->commSend(SYNC_OK_FLAG); // sync succeeded
+                commSync->commSend(delta_self);
+                commSync->commSend(delta_other);
+                mySyncStats.timerEnd(SyncStats::COMM_TIME);
             }
-            value_other.kill();
-            value_self.kill();
-
-            if (succeed) { // only do this if reconciliation has succeeded
-                Logger::gLog(Logger::METHOD, "CPISync succeeded.\n");
-
-                if (!oneWay) {
-                    mySyncStats.timerStart(SyncStats::COMM_TIME);
-                    commSync->commSend(SYNC_OK_FLAG); // sync succeeded
-					commSync->commSend(delta_self);
-                    commSync->commSend(delta_other);
-                    mySyncStats.timerEnd(SyncStats::COMM_TIME);
-                }
-
-                Logger::gLog(Logger::METHOD, string("... results:\n")
-                        + "   self - other =  " + toStr<vec_ZZ_p > (delta_self) + "\n"
-                        + "   other - self =  " + toStr<vec_ZZ_p > (delta_other) + "\n"
-                        + "\n");
 
-                // create selfMinusOther and otherMinusSelf structures to report the result of reconciliation
-                try {
-					_makeStructures(commSync, selfMinusOther, otherMinusSelf, delta_self, delta_other);
-                } catch (SyncFailureException& s) {
-                    Logger::gLog(Logger::METHOD_DETAILS, s.what());
-                    throw (s);
-                }
+            Logger::gLog(Logger::METHOD, string("... results:\n")
+                    + "   self - other =  " + toStr<vec_ZZ_p > (delta_self) + "\n"
+                    + "   other - self =  " + toStr<vec_ZZ_p > (delta_other) + "\n"
+                    + "\n");
 
-                break; // break out of the while loop - this has been settled
+            // create selfMinusOther and otherMinusSelf structures to report the result of reconciliation
+            try {
+                _makeStructures(commSync, selfMinusOther, otherMinusSelf, delta_self, delta_other);
+            } catch (SyncFailureException& s) {
+                Logger::gLog(Logger::METHOD_DETAILS, s.what());
+                throw (s);
             }
+
+            break; // break out of the while loop - this has been settled
         }
 
         if (!succeed) { // if synchronization has failed for some reason
@@ -653,10 +734,9 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
 
                 append(recv_meta, recv_new);
                 currDiff = min(currDiff * 2, maxDiff);
+                more = true;
             }
         }
-        meta_self.kill();
-        meta_other.kill();
     } while (result); //end of while	
 
 
@@ -733,13 +813,48 @@ ZZ_p CPISync::_hash2(const long num) const {
 
 bool CPISync::addElem(shared_ptr<DataObject> datum) {
     Logger::gLog(Logger::METHOD,"Entering CPISync::addElem");
-    int ii;
     
     // call the parent class to take care of bookkeeping
     bool result = SyncMethod::addElem(datum);
 
     // put real data into the hash table
     ZZ_p hashID;
+    if (!_insertHash(datum, hashID))
+        return false;
+
+    CPI_evals->add(hashID);
+
+    Logger::gLog(Logger::METHOD_DETAILS, "... (CPISync) added item " + datum->to_string() + " with hash = " + toStr(hashID));
+
+    return result;
+}
+
+bool CPISync::addElems(const vector<shared_ptr<DataObject>> &data) {
+    Logger::gLog(Logger::METHOD,"Entering CPISync::addElems");
+
+    // hash the elements one by one, as addElem does ...
+    bool result = true;
+    vector<ZZ_p> hashIDs;
+    hashIDs.reserve(data.size());
+    for (const auto &datum : data) {
+        result = SyncMethod::addElem(datum) && result;
+        ZZ_p hashID;
+        if (!_insertHash(datum, hashID)) {
+            result = false;
+            continue;
+        }
+        hashIDs.push_back(hashID);
+    }
+
+    // ... and update the evaluations for all of them at once
+    CPI_evals->addAll(hashIDs);
+
+    Logger::gLog(Logger::METHOD_DETAILS, "... (CPISync) added " + toStr(hashIDs.size()) + " items");
+
+    return result;
+}
+
+bool CPISync::_insertHash(const shared_ptr<DataObject> &datum, ZZ_p &hashID) {
     ZZ hashNum;
     int count = 0;
     do {
@@ -763,13 +878,8 @@ bool CPISync::addElem(shared_ptr<DataObject> datum) {
     }
 
     CPI_hash[hashNum] = datum;
-
-    for (ii = 0; ii < sampleLoc.length(); ii++)
-        CPI_evals[ii] *= (sampleLoc[ii] - hashID);
-
-    Logger::gLog(Logger::METHOD_DETAILS, "... (CPISync) added item " + datum->to_string() + " with hash = " + toStr(hashNum));
-
-    return result;
+    CPI_hashOf.emplace(datum.get(), hashNum);
+    return true;
 }
 
 // update metadata when delete an element by index
@@ -782,22 +892,13 @@ bool CPISync::delElem(shared_ptr<DataObject> newDatum) {
 	return false;
     }
 
-    ZZ_p hashID;
-    // remove data from the hash table. to find the value, a linear search is required
-	auto itr = CPI_hash.begin();
-	while (itr != CPI_hash.end()) {
-		if (itr->second == newDatum) {
-			hashID = to_ZZ_p(itr->first);
-			CPI_hash.erase(itr++);
-		} else {
-			++itr;
-		}
-	}
-
-		// update cpi evals
-    for(int ii = 0; ii < sampleLoc.length(); ii++) {
-        CPI_evals[ii] /= (sampleLoc[ii] - hashID);
+    // remove data from the hash table, looking up its hashes in the reverse index, and update cpi evals
+    auto found = CPI_hashOf.equal_range(newDatum.get());
+    for (auto itr = found.first; itr != found.second; ++itr) {
+        CPI_hash.erase(itr->second);
+        CPI_evals->remove(to_ZZ_p(itr->second));
     }
+    CPI_hashOf.erase(found.first, found.second);
 
     Logger::gLog(Logger::METHOD_DETAILS, "... (CPISync) removed item " + newDatum->print() + ".");
     return true;
@@ -0,0 +1,44 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   CharPolyEvals.cpp
+ * See CharPolyEvals.h.
+ */
+
+#include <CPISync/Syncs/CharPolyEvals.h>
+#include <CPISync/Aux/Logger.h>
+
+#ifdef __SIZEOF_INT128__
+WordField::WordField(const ZZ &modulus) : p(to_ulong(modulus)) {
+    if (!IsOdd(modulus) || NumBits(modulus) > MAX_BITS)
+        Logger::error_and_quit("WordField needs an odd modulus below 2^" + std::to_string(MAX_BITS));
+
+    // Newton's iteration doubles the correct low bits of 1/p mod 2^64 at each step, from the 3 bits of p itself (p*p = 1 mod 8)
+    std::uint64_t pInv = p;
+    for (int ii = 0; ii < 5; ii++)
+        pInv *= 2 - p * pInv;
+    pNeg = 0 - pInv;
+
+    r1 = (std::uint64_t) (((unsigned __int128) 1 << 64) % p);
+    r2 = (std::uint64_t) ((unsigned __int128) r1 * r1 % p);
+}
+
+WordField::Elem WordField::inv(Elem a) const {
+    // Fermat's little theorem:  a^(p-2) = 1/a for a prime p
+    Elem res = r1;
+    for (std::uint64_t exp = p - 2; exp > 0; exp >>= 1) {
+        if (exp & 1)
+            res = mul(res, a);
+        a = mul(a, a);
+    }
+    return res;
+}
+#endif
+
+unique_ptr<CharPolyEvals> CharPolyEvals::make(const vec_ZZ_p &sampleLoc) {
+#ifdef __SIZEOF_INT128__
+    if (NumBits(ZZ_p::modulus()) <= WordField::MAX_BITS && IsOdd(ZZ_p::modulus()))
+        return unique_ptr<CharPolyEvals>(new FieldCharPolyEvals<WordField>(WordField(ZZ_p::modulus()), sampleLoc));
+#endif
+    return unique_ptr<CharPolyEvals>(new FieldCharPolyEvals<ZZpField>(ZZpField(), sampleLoc));
+}
@@ -34,6 +34,27 @@ void Compact2DBitArray::_constructorGuards() const {
                                      "has to be at least 1!");
 }
 
+void Compact2DBitArray::_useWords() {
+    store = vector<unsigned char>();
+    raw = nullptr;
+    if (fSize * bSize <= 32) {
+        words = vector<std::uint64_t>();
+        narrowWords.assign(nBuckets, 0);
+    } else {
+        narrowWords = vector<std::uint32_t>();
+        words.assign(nBuckets, 0);
+    }
+    laneOnes = 0;
+    for (size_t ii=0; ii<bSize; ii++)
+        laneOnes |= std::uint64_t(1) << (ii * fSize);
+}
+
+void Compact2DBitArray::_copyEntries(const Compact2DBitArray &from) {
+    for (size_t ii=0; ii<nBuckets; ii++)
+        for (size_t jj=0; jj<bSize; jj++)
+            setEntry(ii, jj, narrow_cast<unsigned>(from.getEntry(ii, jj)));
+}
+
 Compact2DBitArray::Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
                                      size_t NumOfBuckets) :
     fSize (fingerprintSize),
@@ -43,7 +64,12 @@ Compact2DBitArray::Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
 {
     _constructorGuards();
     std::call_once(onceEndiannessFlag, _discern_endianness);
-    store.resize(narrow_cast<unsigned long>(ceil((fSize * bSize * nBuckets) / float(BYTE))));
+    if (wordLayout(fSize, bSize))
+        _useWords();
+    else {
+        store.resize(storageBytes(fSize, bSize, nBuckets));
+        raw = store.data();
+    }
 }
 
 Compact2DBitArray::Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
@@ -56,6 +82,78 @@ Compact2DBitArray::Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
 {
     _constructorGuards();
     std::call_once(onceEndiannessFlag, _discern_endianness);
+    if (store.size() != storageBytes(fSize, bSize, nBuckets))
+        throw Compact2DBitArrayError("Content of " + to_string(store.size())
+                                     + " bytes does not fit the dimensions.");
+    raw = store.data();
+
+    if (wordLayout(fSize, bSize)) {
+        vector<unsigned char> packed = std::move(store);
+        _useWords();
+        _copyEntries(Compact2DBitArray(fSize, bSize, nBuckets, packed.data()));
+    }
+}
+
+Compact2DBitArray::Compact2DBitArray(size_t fingerprintSize, size_t bucketSize,
+                                     size_t NumOfBuckets, unsigned char *external) :
+    raw (external),
+    fSize (fingerprintSize),
+    fSizeB (narrow_cast<unsigned short>(ceil(fSize / float(BYTE)))),
+    bSize (bucketSize),
+    nBuckets (NumOfBuckets)
+{
+    _constructorGuards();
+    std::call_once(onceEndiannessFlag, _discern_endianness);
+}
+
+Compact2DBitArray::Compact2DBitArray(const Compact2DBitArray &other) {
+    *this = other;
+}
+
+Compact2DBitArray &Compact2DBitArray::operator=(const Compact2DBitArray &other) {
+    if (this == &other)
+        return *this;
+    fSize = other.fSize;
+    fSizeB = other.fSizeB;
+    bSize = other.bSize;
+    nBuckets = other.nBuckets;
+    laneOnes = other.laneOnes;
+    words = other.words;
+    narrowWords = other.narrowWords;
+    if (!_inWords()) {
+        store.assign(other.raw, other.raw + storageBytes(fSize, bSize, nBuckets));
+        raw = store.data();
+    } else {
+        store = vector<unsigned char>();
+        raw = nullptr;
+    }
+    return *this;
+}
+
+Compact2DBitArray::Compact2DBitArray(Compact2DBitArray &&other) noexcept {
+    *this = std::move(other);
+}
+
+Compact2DBitArray &Compact2DBitArray::operator=(Compact2DBitArray &&other) noexcept {
+    if (this == &other)
+        return *this;
+    fSize = other.fSize;
+    fSizeB = other.fSizeB;
+    bSize = other.bSize;
+    nBuckets = other.nBuckets;
+    laneOnes = other.laneOnes;
+    // a moved vector keeps its buffer, so raw stays valid whether or not the storage is external
+    store = std::move(other.store);
+    words = std::move(other.words);
+    narrowWords = std::move(other.narrowWords);
+    raw = other.raw;
+    other.raw = nullptr;
+    return *this;
+}
+
+size_t Compact2DBitArray::storageBytes(size_t fingerprintSize, size_t bucketSize,
+                                       size_t NumOfBuckets) {
+    return (fingerprintSize * bucketSize * NumOfBuckets + BYTE - 1) / BYTE;
 }
 
 size_t Compact2DBitArray::getF() const {
@@ -97,19 +195,22 @@ void Compact2DBitArray::_assertIdx(size_t bucketIdx, size_t entryIdx) const {
 
 size_t Compact2DBitArray::getEntry(size_t bucketIdx, size_t entryIdx) const {
     _assertIdx(bucketIdx, entryIdx);
+    if (_inWords())
+        return (_word(bucketIdx) >> (entryIdx * fSize)) & ((1 << fSize) - 1);
+
     GetSetPrelim p = _getSetPrelim(bucketIdx, entryIdx);
 
     if (p.lstByte > p.fstByte) { // Entry in multiple bytes
-        unsigned char fstP = static_cast<unsigned char>(store[p.fstByte] & ((1 << (BYTE - p.onsetBits))
+        unsigned char fstP = static_cast<unsigned char>(raw[p.fstByte] & ((1 << (BYTE - p.onsetBits))
                                                                             - 1));
         // % BYTE to accommodate for lstP being nicely aligned to the
         // end of its byte
-        unsigned char lstP = store[p.lstByte] >> ((BYTE - p.offsetBits) % BYTE);
+        unsigned char lstP = raw[p.lstByte] >> ((BYTE - p.offsetBits) % BYTE);
 
         unsigned entry = fstP;
         for (size_t ii=1; ii<(p.lstByte - p.fstByte); ii++) {
             entry <<= BYTE;
-            entry |= store[p.fstByte + ii];
+            entry |= raw[p.fstByte + ii];
         }
         // In case of lstByte > fstByte, when offsetBits is 0 then
         // lstP is nicely alligned to the end of its byte. Then, we
@@ -121,12 +222,19 @@ size_t Compact2DBitArray::getEntry(size_t bucketIdx, size_t entryIdx) const {
     }
 
     // Entry spreads only single byte
-    return static_cast<unsigned int>((store[p.fstByte] >> (BYTE - p.onsetBits - fSize))
+    return static_cast<unsigned int>((raw[p.fstByte] >> (BYTE - p.onsetBits - fSize))
                                      & ((1 << fSize) - 1));
 }
 
 void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f) {
     _assertIdx(bucketIdx, entryIdx);
+    if (_inWords()) {
+        const std::uint64_t mask = (std::uint64_t(1) << fSize) - 1;
+        const size_t shift = entryIdx * fSize;
+        _setWord(bucketIdx, (_word(bucketIdx) & ~(mask << shift)) | ((f & mask) << shift));
+        return;
+    }
+
     GetSetPrelim p = _getSetPrelim(bucketIdx, entryIdx);
 
     auto* fngprtC = (unsigned char*)&f;
@@ -146,10 +254,10 @@ void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f)
     case 0: // Entry starts and ends in the same byte
         // extract the MS bits of the byte that are not the part of
         // current entry and bring it to LS end.
-        fstP = store[p.fstByte] >> (BYTE - p.onsetBits);
+        fstP = raw[p.fstByte] >> (BYTE - p.onsetBits);
         // extract the LS bits of the byte that are not the part of
         // current entry. Keep them in LS positions.
-        lstP = static_cast<unsigned char>(store[p.fstByte] & ((1 << (BYTE - p.onsetBits - fSize)) - 1));
+        lstP = static_cast<unsigned char>(raw[p.fstByte] & ((1 << (BYTE - p.onsetBits - fSize)) - 1));
 
         // bring fstP back to MS bits
         toWrite = fstP << (BYTE - p.onsetBits);
@@ -159,7 +267,7 @@ void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f)
         toWrite |= *fngprtC << (BYTE - p.onsetBits - fSize);
         // append the last part
         toWrite |= lstP;
-        store[p.fstByte] = toWrite;
+        raw[p.fstByte] = toWrite;
         break;
 
     case 1: // Entry spreads two consequent bytes
@@ -172,19 +280,19 @@ void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f)
         // take BYTE - onsetBits MS bits, put them as LS bits of new byte
         toWrite >>= p.onsetBits;
         // construct the onset part from what's already there
-        onsetP = store[p.fstByte] >> (BYTE - p.onsetBits);
+        onsetP = raw[p.fstByte] >> (BYTE - p.onsetBits);
         // ... put that as MS bits of new byte
         onsetP <<= (BYTE - p.onsetBits);
         // join the two parts
         toWrite |= onsetP;
-        store[p.fstByte] = toWrite;
+        raw[p.fstByte] = toWrite;
         // we just consumed (wrote to filter) this much bits of the
         // fingerprint that we are writing
         cBits += BYTE - p.onsetBits;
 
         /* Write middle complete bytes */
         for (ii=1; ii<diff; ii++) {
-            store[p.fstByte + ii] = _getNextFByte(fBytes, cBits);
+            raw[p.fstByte + ii] = _getNextFByte(fBytes, cBits);
             // we just consumed a complete byte of the fingerprint
             // that we are writing
             cBits += BYTE;
@@ -197,9 +305,9 @@ void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f)
             // Otherwise lstByte is nicely aligned with its byte. The
             // new lstByte is exactly what we built as of now. No old
             // lstByte part needed to be restored.
-            toWrite |= store[p.lstByte] & ((1 << (BYTE - p.offsetBits)) - 1);
+            toWrite |= raw[p.lstByte] & ((1 << (BYTE - p.offsetBits)) - 1);
 
-        store[p.lstByte] = toWrite;
+        raw[p.lstByte] = toWrite;
         break;
 
     default:
@@ -207,8 +315,51 @@ void Compact2DBitArray::setEntry(size_t bucketIdx, size_t entryIdx, unsigned f)
     }
 }
 
+Nullable<size_t> Compact2DBitArray::findEntry(size_t bucketIdx, unsigned f) const {
+    _assertIdx(bucketIdx, 0);
+    if (_inWords()) {
+        if (f >> fSize)
+            return {}; // no entry is that wide
+
+        // SWAR: the entries equal to f are the zero entries of x. The
+        // lowest entry whose top bit survives below is the first zero
+        // one; a borrow out of it may mark higher entries as well.
+        std::uint64_t x = _word(bucketIdx) ^ (laneOnes * f);
+        std::uint64_t zeros = (x - laneOnes) & ~x & (laneOnes << (fSize - 1));
+        if (!zeros)
+            return {};
+        return size_t(__builtin_ctzll(zeros)) / fSize;
+    }
+
+    size_t bit = fSize * bSize * bucketIdx;
+    const unsigned char* next = raw + bit / BYTE;
+    const std::uint64_t mask = (std::uint64_t(1) << fSize) - 1;
+
+    // acc holds the accBits bits of the bucket that are read but not
+    // yet compared, MS bit first as the entries are laid out. Bytes
+    // are read only as entries need them, so never past the bucket.
+    std::uint64_t acc = *next++ & ((1 << (BYTE - bit % BYTE)) - 1);
+    size_t accBits = BYTE - bit % BYTE;
+    for (size_t ii=0; ii<bSize; ii++) {
+        while (accBits < fSize) {
+            acc = (acc << BYTE) | *next++;
+            accBits += BYTE;
+        }
+        accBits -= fSize;
+        if (((acc >> accBits) & mask) == f)
+            return ii;
+        acc &= (std::uint64_t(1) << accBits) - 1;
+    }
+    return {};
+}
+
 vector<unsigned char> Compact2DBitArray::getRaw() const {
-    return store;
+    if (!_inWords())
+        return vector<unsigned char>(raw, raw + storageBytes(fSize, bSize, nBuckets));
+
+    vector<unsigned char> res(storageBytes(fSize, bSize, nBuckets));
+    Compact2DBitArray(fSize, bSize, nBuckets, res.data())._copyEntries(*this);
+    return res;
 }
 
 unsigned char Compact2DBitArray::_getNextFByte(const vector<unsigned char>& f,
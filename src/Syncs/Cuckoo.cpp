@@ -9,21 +9,45 @@
  * https://www.cs.cmu.edu/~dga/papers/cuckoo-conext2014.pdf
  */
 
+#include <exception>
+#include <algorithm>
 #include <CPISync/Syncs/Cuckoo.h>
 
 std::random_device Cuckoo::rd;
 
 std::mt19937 Cuckoo::prng(Cuckoo::rd());
 
-Cuckoo::~Cuckoo() = default;
-
-int _default_fingerprint(const ZZ& xx, size_t fngprtSize) {
-    return to_int(xx) & ((1 << fngprtSize) - 1);
+Cuckoo::~Cuckoo() {
+    flush();
 }
 
-ZZ _default_hash(const ZZ& xx, size_t filterSize) {
-    std::hash<string> shash;
-    return ZZ(shash(toStr(to_long(xx))) % filterSize);
+namespace {
+    // seeds of the native hashes, for the element and for a fingerprint
+    const std::uint64_t ELEM_SEED = 0xA0761D6478BD642FULL;
+    const std::uint64_t FNGPRT_SEED = 0xE7037ED1A0B428DBULL;
+
+    // Appends num to buf as a varint: 7 bits per byte, least
+    // significant first, with the high bit set on all but the last
+    inline void appendVarint(vector<byte>& buf, size_t num) {
+        while (num >= 0x80) {
+            buf.push_back(byte(num & 0x7F) | 0x80);
+            num >>= 7;
+        }
+        buf.push_back(byte(num));
+    }
+
+    // Reads a varint written by appendVarint from [ptr, end) into num.
+    // @return the byte after the varint, or nullptr if it is cut short
+    inline const byte* readVarint(const byte* ptr, const byte* end, size_t& num) {
+        num = 0;
+        for (unsigned shift=0; ptr < end && shift < 64; shift+=7) {
+            byte bt = *ptr++;
+            num |= size_t(bt & 0x7F) << shift;
+            if (!(bt & 0x80))
+                return ptr;
+        }
+        return nullptr;
+    }
 }
 
 Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
@@ -33,9 +57,7 @@ Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
     bucketSize (bucketSize),
     fngprtSize (fngprtSize),
     maxKicks (maxKicks),
-    itemsCount (0),
-    fingerprint_impl (_default_fingerprint),
-    hash_impl (_default_hash) {}
+    itemsCount (0) {}
 
 Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
                size_t maxKicks, fingerprint_impl_t fingerprintFunction,
@@ -56,9 +78,7 @@ Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
     bucketSize (bucketSize),
     fngprtSize (fngprtSize),
     maxKicks (maxKicks),
-    itemsCount (itemsCount),
-    fingerprint_impl (_default_fingerprint),
-    hash_impl (_default_hash) {}
+    itemsCount (itemsCount) {}
 
 Cuckoo::Cuckoo(size_t capacity, float err) {
     // TODO: if ready to move to C++14 we can let the compiler
@@ -93,6 +113,122 @@ Cuckoo::Cuckoo(size_t capacity, float err) {
     filter = Compact2DBitArray(fngprtSize, bucketSize, filterSize);
 }
 
+Cuckoo::Cuckoo(const string& fileName, size_t fngprtSize, size_t bucketSize,
+               size_t filterSize, size_t maxKicks) :
+    filterSize (filterSize),
+    bucketSize (bucketSize),
+    fngprtSize (fngprtSize),
+    maxKicks (maxKicks),
+    itemsCount (0) {
+    size_t bytes = Compact2DBitArray::storageBytes(fngprtSize, bucketSize, filterSize);
+    snapshot.reset(new MappedFile(fileName, SNAP_HEADER_WORDS * sizeof(std::uint64_t) + bytes));
+    unsigned char* table = snapshot->data() + SNAP_HEADER_WORDS * sizeof(std::uint64_t);
+    filter = Compact2DBitArray(fngprtSize, bucketSize, filterSize, table);
+
+    std::uint64_t* header = _header();
+    wasResumed = !snapshot->fresh() && header[SNAP_MAGIC] == SNAPSHOT_MAGIC
+        && header[SNAP_FNGPRT_SIZE] == fngprtSize
+        && header[SNAP_BUCKET_SIZE] == bucketSize
+        && header[SNAP_FILTER_SIZE] == filterSize
+        && header[SNAP_CLEAN] != 0;
+    if (wasResumed) {
+        itemsCount = conv<ZZ>(header[SNAP_ITEMS]);
+        Logger::gLog(Logger::METHOD_DETAILS, "Cuckoo filter resumed from " + fileName);
+        return;
+    }
+
+    // a new file, another filter's, or one that changed after it was
+    // last flushed: start over
+    Logger::gLog(Logger::METHOD_DETAILS, "Cuckoo filter snapshot " + fileName
+                 + " cannot be resumed; starting empty");
+    std::fill(table, table + bytes, 0);
+    header[SNAP_FNGPRT_SIZE] = fngprtSize;
+    header[SNAP_BUCKET_SIZE] = bucketSize;
+    header[SNAP_FILTER_SIZE] = filterSize;
+    header[SNAP_CLEAN] = 0;
+    header[SNAP_MAGIC] = SNAPSHOT_MAGIC;
+    flush();
+}
+
+Cuckoo::Cuckoo(const Cuckoo& other) {
+    *this = other;
+}
+
+Cuckoo& Cuckoo::operator=(const Cuckoo& other) {
+    if (this == &other)
+        return *this;
+    _close();
+    filter = other.filter; // copies its storage
+    filterSize = other.filterSize;
+    bucketSize = other.bucketSize;
+    fngprtSize = other.fngprtSize;
+    maxKicks = other.maxKicks;
+    itemsCount = other.itemsCount;
+    fingerprint_impl = other.fingerprint_impl;
+    hash_impl = other.hash_impl;
+    tracking = other.tracking;
+    isChanged = other.isChanged;
+    changed = other.changed;
+    return *this;
+}
+
+Cuckoo::Cuckoo(Cuckoo&& other) noexcept {
+    *this = std::move(other);
+}
+
+Cuckoo& Cuckoo::operator=(Cuckoo&& other) noexcept {
+    if (this == &other)
+        return *this;
+    _close();
+    filter = std::move(other.filter);
+    filterSize = other.filterSize;
+    bucketSize = other.bucketSize;
+    fngprtSize = other.fngprtSize;
+    maxKicks = other.maxKicks;
+    itemsCount = other.itemsCount;
+    fingerprint_impl = std::move(other.fingerprint_impl);
+    hash_impl = std::move(other.hash_impl);
+    tracking = other.tracking;
+    isChanged = std::move(other.isChanged);
+    changed = std::move(other.changed);
+    snapshot = std::move(other.snapshot);
+    wasResumed = other.wasResumed;
+    return *this;
+}
+
+bool Cuckoo::resumed() const {
+    return wasResumed;
+}
+
+void Cuckoo::flush() {
+    if (!snapshot)
+        return;
+    // the filter must be on disk before the header claims that it is
+    // consistent
+    _header()[SNAP_ITEMS] = conv<long>(itemsCount);
+    snapshot->flush();
+    _header()[SNAP_CLEAN] = 1;
+    snapshot->flush(SNAP_HEADER_WORDS * sizeof(std::uint64_t));
+}
+
+void Cuckoo::_touch() {
+    if (snapshot && _header()[SNAP_CLEAN] != 0) {
+        // a clean mark must never reach the disk after a changed filter does
+        _header()[SNAP_CLEAN] = 0;
+        snapshot->flush(SNAP_HEADER_WORDS * sizeof(std::uint64_t));
+    }
+}
+
+void Cuckoo::_close() {
+    if (!snapshot)
+        return;
+    flush();
+    // keep the filter in memory, as it will no longer be mapped
+    filter = Compact2DBitArray(filter);
+    snapshot.reset();
+    wasResumed = false;
+}
+
 size_t Cuckoo::getFilterSize() const {
     return filterSize;
 }
@@ -121,24 +257,18 @@ void Cuckoo::_restore_filter(stack<Slot>& originalSlots) {
     while (!originalSlots.empty()) {
         Slot s = originalSlots.top();
         originalSlots.pop();
-        filter.setEntry(s.b, s.c, s.f);
+        _setEntry(s.b, s.c, s.f);
     }
 }
 
 bool Cuckoo::insert(const DataObject& datum) {
     PartialHash p = _pHash(datum);
+    _touch();
 
-    try {
-        addToBucket(p.i1, p.f);
+    if (!addToBucket(p.i1, p.f).isNullQ() || !addToBucket(p.i2, p.f).isNullQ()) {
         itemsCount++;
         return true;
-    } catch (overflow_error ignored) {}
-
-    try {
-        addToBucket(p.i2, p.f);
-        itemsCount++;
-        return true;
-    } catch (overflow_error ignored) {}
+    }
 
     // Choose bucket to kick from
     size_t chosenBucket = _rand(0, 1) ? p.i2 : p.i1;
@@ -154,13 +284,12 @@ bool Cuckoo::insert(const DataObject& datum) {
 
         // Overwrite victim with the fingerprint being inserted. Later
         // on, if insert fails, we will restore the filter.
-        filter.setEntry(chosenBucket, victimIdx, f);
+        _setEntry(chosenBucket, victimIdx, f);
 
-        try {
-            addToBucket(altBucket, victim);
+        if (!addToBucket(altBucket, victim).isNullQ()) {
             itemsCount++;
             return true;
-        } catch (overflow_error ignored) {}
+        }
 
         Slot s;
         s.b = chosenBucket;
@@ -180,18 +309,48 @@ bool Cuckoo::insert(const DataObject& datum) {
 bool Cuckoo::lookup(const DataObject& datum) const {
     PartialHash p = _pHash(datum);
 
-    try {
-        findFingerprint(p.f, p.i1);
-        return true;
-    } catch (range_error ignored) {}
+    return !findFingerprint(p.f, p.i1).isNullQ()
+        || !findFingerprint(p.f, p.i2).isNullQ();
+}
 
-    try {
-        findFingerprint(p.f, p.i2);
-        return true;
-    } catch (range_error ignored) {}
+vector<unsigned char> Cuckoo::lookupAll(vector<shared_ptr<DataObject>>::const_iterator first,
+                                        vector<shared_ptr<DataObject>>::const_iterator last,
+                                        size_t numThreads) const {
+    auto count = size_t(last - first);
+    vector<unsigned char> found(count);
+    numThreads = numWorkers(numThreads, count, MIN_LOOKUPS_PER_THREAD);
+    vector<std::exception_ptr> failures(numThreads);
 
-    return false;
+    parallelFor(count, numThreads, [&](size_t begin, size_t end, size_t slice) {
+        try {
+            PartialHash block[LOOKUP_BLOCK];
+            for (size_t start=begin; start<end; start+=LOOKUP_BLOCK) {
+                size_t len = end - start < LOOKUP_BLOCK ? end - start : LOOKUP_BLOCK;
+
+                // hash the block, and start loading both candidate
+                // buckets of each of its elements ...
+                for (size_t ii=0; ii<len; ii++) {
+                    block[ii] = _pHash(*first[start + ii]);
+                    filter.prefetch(block[ii].i1);
+                    filter.prefetch(block[ii].i2);
+                }
+
+                // ... which have mostly arrived once they are searched
+                for (size_t ii=0; ii<len; ii++) {
+                    const PartialHash& p = block[ii];
+                    found[start + ii] = !findFingerprint(p.f, p.i1).isNullQ()
+                        || !findFingerprint(p.f, p.i2).isNullQ();
+                }
+            }
+        } catch (...) {
+            failures[slice] = std::current_exception();
+        }
+    });
 
+    for (const auto& failure : failures)
+        if (failure)
+            std::rethrow_exception(failure);
+    return found;
 }
 
 bool Cuckoo::erase(const DataObject& datum) {
@@ -199,20 +358,16 @@ bool Cuckoo::erase(const DataObject& datum) {
         throw CuckooFilterError("You cannot erase from an empty filter!");
 
     PartialHash p = _pHash(datum);
+    _touch();
 
-    try {
-        size_t idx = findFingerprint(p.f, p.i1);
-        filter.setEntry(p.i1, idx, 0);
-        itemsCount--;
-        return true;
-    } catch (range_error ignored) {}
-
-    try {
-        size_t idx = findFingerprint(p.f, p.i2);
-        filter.setEntry(p.i2, idx, 0);
-        itemsCount--;
-        return true;
-    } catch (range_error ignored) {}
+    for (size_t bucket : {p.i1, p.i2}) {
+        Nullable<size_t> idx = findFingerprint(p.f, bucket);
+        if (!idx.isNullQ()) {
+            _setEntry(bucket, *idx, 0);
+            itemsCount--;
+            return true;
+        }
+    }
 
     return false;
 }
@@ -224,6 +379,8 @@ long Cuckoo::_rand(size_t min, size_t max) {
 }
 
 bool Cuckoo::isZeroF(const DataObject& d) const {
+    if (!fingerprint_impl)
+        return false; // native fingerprints are never 0
     return !fingerprint(d.to_ZZ());
 }
 
@@ -232,6 +389,9 @@ void Cuckoo::seedPRNG(unsigned int seed) {
 }
 
 vector<byte> Cuckoo::toByteVector() const {
+    if (fingerprint_impl)
+        // the receiver would look up with the native hashes
+        throw CuckooFilterError("A filter with custom hash functions cannot be serialized.");
     vector<byte> res;
 
     vector<byte> byteRep = toBytes(fngprtSize);
@@ -253,6 +413,7 @@ vector<byte> Cuckoo::toByteVector() const {
 }
 
 void Cuckoo::fromByteVector(vector<byte> buffer) {
+    _close();
     const byte *ptr = buffer.data();
 
     fngprtSize = fromBytes<size_t>(ptr); ptr += sizeof(fngprtSize);
@@ -270,8 +431,96 @@ void Cuckoo::fromByteVector(vector<byte> buffer) {
     }
 
     filter = Compact2DBitArray(fngprtSize, bucketSize, filterSize, table);
-    fingerprint_impl = _default_fingerprint;
-    hash_impl = _default_hash;
+    fingerprint_impl = nullptr;
+    hash_impl = nullptr;
+    trackChanges(false);
+}
+
+void Cuckoo::trackChanges(bool on) {
+    tracking = on;
+    changed.clear();
+    isChanged.assign(on ? filterSize : 0, 0);
+}
+
+bool Cuckoo::hasChanges() const {
+    return !changed.empty();
+}
+
+void Cuckoo::clearChanges() {
+    for (size_t bucket : changed)
+        isChanged[bucket] = 0;
+    changed.clear();
+}
+
+vector<byte> Cuckoo::deltaToByteVector() const {
+    if (!tracking)
+        throw CuckooFilterError("A delta needs the changes to be tracked.");
+    if (fingerprint_impl)
+        throw CuckooFilterError("A filter with custom hash functions cannot be serialized.");
+
+    vector<byte> res = toBytes(itemsCount);
+    size_t countAt = res.size();
+    res.resize(countAt + sizeof(std::uint64_t));
+    writeWordLE(changed.size(), res.data() + countAt);
+
+    vector<size_t> buckets(changed);
+    std::sort(buckets.begin(), buckets.end());
+    const size_t entryBytes = (fngprtSize + 7) / 8;
+    size_t prev = 0;
+    for (size_t bucket : buckets) {
+        appendVarint(res, bucket - prev);
+        prev = bucket;
+        for (size_t ii=0; ii<bucketSize; ii++) {
+            size_t entry = filter.getEntry(bucket, ii);
+            for (size_t jj=0; jj<entryBytes; jj++)
+                res.push_back(byte(entry >> (8 * jj)));
+        }
+    }
+    return res;
+}
+
+void Cuckoo::applyDelta(const vector<byte>& delta) {
+    const byte* ptr = delta.data();
+    const byte* end = ptr + delta.size();
+    const size_t entryBytes = (fngprtSize + 7) / 8;
+
+    // check the whole delta, and find each bucket's entries in it,
+    // before changing anything
+    if (delta.size() < sizeof(std::uint64_t)
+        || delta.size() - sizeof(std::uint64_t) < readWordLE(ptr))
+        throw CuckooFilterError("Malformed Cuckoo filter delta.");
+    long bytesRead;
+    ZZ newCount = fromBytesZZ(ptr, bytesRead); ptr += bytesRead;
+    if (end - ptr < long(sizeof(std::uint64_t)))
+        throw CuckooFilterError("Malformed Cuckoo filter delta.");
+    std::uint64_t numBuckets = readWordLE(ptr); ptr += sizeof(std::uint64_t);
+
+    vector<std::pair<size_t, const byte*>> buckets;
+    size_t bucket = 0;
+    for (std::uint64_t ii=0; ii<numBuckets; ii++) {
+        size_t gap;
+        ptr = readVarint(ptr, end, gap);
+        if (ptr == nullptr || (ii > 0 && gap == 0) || gap >= filterSize - bucket
+            || size_t(end - ptr) < bucketSize * entryBytes)
+            throw CuckooFilterError("Malformed Cuckoo filter delta.");
+        bucket += gap;
+        buckets.emplace_back(bucket, ptr);
+        ptr += bucketSize * entryBytes;
+    }
+    if (ptr != end)
+        throw CuckooFilterError("Malformed Cuckoo filter delta.");
+
+    _touch();
+    for (const auto& entries : buckets) {
+        const byte* entry = entries.second;
+        for (size_t ii=0; ii<bucketSize; ii++) {
+            unsigned f = 0;
+            for (size_t jj=0; jj<entryBytes; jj++)
+                f |= unsigned(*entry++) << (8 * jj);
+            _setEntry(entries.first, ii, f);
+        }
+    }
+    itemsCount = newCount;
 }
 
 
@@ -294,36 +543,58 @@ ZZ Cuckoo::hash(const ZZ& e) const {
     return hash_impl(e, filterSize);
 }
 
-size_t Cuckoo::addToBucket(size_t bucketIdx, size_t f) {
-    for (size_t ii=0; ii<bucketSize; ii++)
-        // Put the fingerprint in the first available entry
-        if (filter.getEntry(bucketIdx, ii) == 0) {
-            filter.setEntry(bucketIdx, ii, f);
-            return ii;
-        }
-
-    throw overflow_error("Bucket "+toStr(bucketIdx)+" is full.");
+void Cuckoo::_setEntry(size_t bucketIdx, size_t entryIdx, unsigned f) {
+    filter.setEntry(bucketIdx, entryIdx, f);
+    if (tracking && !isChanged[bucketIdx]) {
+        isChanged[bucketIdx] = 1;
+        changed.push_back(bucketIdx);
+    }
 }
 
-size_t Cuckoo::findFingerprint(unsigned f, size_t bucket) const {
-    for (size_t ii=0; ii < bucketSize; ii++)
-        if (filter.getEntry(bucket, ii) == f)
-            return ii;
+Nullable<size_t> Cuckoo::addToBucket(size_t bucketIdx, size_t f) {
+    // Put the fingerprint in the first available entry
+    Nullable<size_t> idx = filter.findEntry(bucketIdx, 0);
+    if (!idx.isNullQ())
+        _setEntry(bucketIdx, *idx, f);
+    return idx;
+}
 
-    throw range_error("Could not find fingerprint "+toStr(f)+" in bucket "+toStr(bucket));
+Nullable<size_t> Cuckoo::findFingerprint(unsigned f, size_t bucket) const {
+    return filter.findEntry(bucket, f);
 }
 
 size_t Cuckoo::_alternativeBucket(size_t currentB, size_t f) const {
+    if (!fingerprint_impl) {
+        // the two buckets of a fingerprint sum to its hash, modulo
+        // filterSize, so that each is the alternative of the other
+        // for any filterSize
+        size_t fHash = seededHashK(FNGPRT_SEED, narrow_cast<long>(f)) % filterSize;
+        return (fHash + filterSize - currentB) % filterSize;
+    }
+
     // i1 xor hash(f) can wrap around fitlerSize the same way hash can
     // do it on its own.
-    return narrow_cast<size_t>(to_int((currentB ^ hash(to_ZZ(f))) % filterSize));
+    return (currentB ^ to_ulong(hash(to_ZZ(f)))) % filterSize;
 }
 
 Cuckoo::PartialHash Cuckoo::_pHash(const DataObject& datum) const {
     PartialHash p;
 
-    p.f = fingerprint(datum.to_ZZ());
-    p.i1 = narrow_cast<unsigned int>(to_int(hash(datum.to_ZZ())));
+    if (!fingerprint_impl) {
+        // one hash of the element's bytes, whose high bits give the
+        // fingerprint, and whose remix gives the first bucket
+        std::uint64_t h = datum.hash64(ELEM_SEED);
+        p.f = narrow_cast<size_t>((h >> 32) & ((std::uint64_t(1) << fngprtSize) - 1));
+        if (p.f == 0)
+            p.f = 1; // 0 is an empty entry
+        p.i1 = narrow_cast<size_t>(seededHashK(h, 0) % filterSize);
+        p.i2 = _alternativeBucket(p.i1, p.f);
+        return p;
+    }
+
+    const ZZ e = datum.to_ZZ();
+    p.f = fingerprint(e);
+    p.i1 = narrow_cast<unsigned int>(to_int(hash(e)));
     p.i2 = _alternativeBucket(p.i1, p.f);
 
     if (p.i1 != _alternativeBucket(p.i2, p.f))
@@ -9,16 +9,52 @@
  * https://www.cs.cmu.edu/~dga/papers/cuckoo-conext2014.pdf
  */
 
+#include <climits>
+#include <random>
+#include <mutex>
 #include <CPISync/Aux/Exceptions.h>
 #include <CPISync/Syncs/CuckooSync.h>
 
+namespace {
+    // the receiver's reply to a delta
+    const byte HAVE_BASE = SYNC_OK_FLAG;    // the delta was applied
+    const byte NEED_FULL = SYNC_FAIL_FLAG;  // the delta's base is unknown; send the whole filter
+
+    // @return a new filter version, drawn apart from Cuckoo's PRNG, which
+    // peers may seed alike.  Never 0, which stands for no version.
+    long newVersion() {
+        static std::random_device rd;
+        static std::mutex rdLock; // peers may sync on threads of one process
+        std::lock_guard<std::mutex> lock(rdLock);
+        std::uint64_t version = (std::uint64_t(rd()) << 32) ^ rd();
+        version &= LONG_MAX;
+        return version == 0 ? 1 : long(version);
+    }
+}
+
 CuckooSync::CuckooSync(size_t fngprtSize, size_t bucketSize,
-                       size_t filterSize, size_t maxKicks) {
-    myCF = Cuckoo(fngprtSize, bucketSize, filterSize, maxKicks);
+                       size_t filterSize, size_t maxKicks,
+                       bool deltaTransfer, const string& snapshotFile)
+    : deltaTransfer(deltaTransfer) {
+    if (snapshotFile.empty())
+        myCF = Cuckoo(fngprtSize, bucketSize, filterSize, maxKicks);
+    else
+        myCF = Cuckoo(snapshotFile, fngprtSize, bucketSize, filterSize, maxKicks);
+    replaying = myCF.resumed();
+    if (deltaTransfer)
+        myCF.trackChanges(true);
 }
 
 CuckooSync::~CuckooSync() = default;
 
+bool CuckooSync::resumed() const {
+    return myCF.resumed();
+}
+
+void CuckooSync::endReplay() {
+    replaying = false;
+}
+
 string CuckooSync::getName() {return "CuckooSync";}
 
 bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
@@ -30,6 +66,7 @@ bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
 
         // Call parent method for bookkeeping
         SyncMethod::SyncClient(commSync, selfMinusOther, otherMinusSelf);
+        endReplay(); // whatever was added before the first sync was the replay
 
         // Connect to server
         mySyncStats.timerStart(SyncStats::IDLE_TIME);
@@ -41,7 +78,8 @@ bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
         if (!commSync->establishCuckooSend(myCF.getFngprtSize(),
                                            myCF.getBucketSize(),
                                            myCF.getFilterSize(),
-                                           myCF.getMaxKicks())) {
+                                           myCF.getMaxKicks(),
+                                           deltaTransfer)) {
             Logger::gLog(Logger::METHOD_DETAILS, "Cuckoo parameters do not"
                          "match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
@@ -52,19 +90,17 @@ bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
         }
 
         // Send my CF
-        commSync->commSend(myCF);
+        _sendFilter(commSync);
 
         // Receive theirs CF
-        Cuckoo theirsCF = commSync->commRecv_Cuckoo();
+        const Cuckoo& theirsCF = _recvFilter(commSync);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
         mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
         mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
 
         // Query their CF to obtain my local elements
         mySyncStats.timerStart(SyncStats::COMP_TIME);
-        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++)
-            if (!theirsCF.lookup(**e))
-                selfMinusOther.push_back(*e);
+        _missingFrom(theirsCF, selfMinusOther);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
         mySyncStats.timerStart(SyncStats::COMM_TIME);
@@ -102,6 +138,7 @@ bool CuckooSync::SyncServer(const shared_ptr<Communicant>& commSync,
 
         // call parent method for bookkeeping
         SyncMethod::SyncServer(commSync, selfMinusOther, otherMinusSelf);
+        endReplay(); // whatever was added before the first sync was the replay
 
         // listen for client
         mySyncStats.timerStart(SyncStats::IDLE_TIME);
@@ -112,7 +149,8 @@ bool CuckooSync::SyncServer(const shared_ptr<Communicant>& commSync,
         if (!commSync->establishCuckooRecv(myCF.getFngprtSize(),
                                            myCF.getBucketSize(),
                                            myCF.getFilterSize(),
-                                           myCF.getMaxKicks())) {
+                                           myCF.getMaxKicks(),
+                                           deltaTransfer)) {
             Logger::gLog(Logger::METHOD_DETAILS, "Cuckoo parameters do not"
                          "match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
@@ -123,21 +161,19 @@ bool CuckooSync::SyncServer(const shared_ptr<Communicant>& commSync,
         }
 
         // Receive their CF
-        Cuckoo theirsCF = commSync->commRecv_Cuckoo();
+        const Cuckoo& theirsCF = _recvFilter(commSync);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
         mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
         mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
 
         // Query their CF to obtain my local elements
         mySyncStats.timerStart(SyncStats::COMP_TIME);
-        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++)
-            if (!theirsCF.lookup(**e))
-                selfMinusOther.push_back(*e);
+        _missingFrom(theirsCF, selfMinusOther);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
         // Send my CF
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        commSync->commSend(myCF);
+        _sendFilter(commSync);
 
         // Receive their local elements
         list<shared_ptr<DataObject>> rcvd = commSync->commRecv_DataObject_List();
@@ -165,8 +201,75 @@ bool CuckooSync::SyncServer(const shared_ptr<Communicant>& commSync,
     }
 }
 
+void CuckooSync::_sendFilter(const shared_ptr<Communicant>& commSync) {
+    if (!deltaTransfer) {
+        commSync->commSend(myCF);
+        return;
+    }
+
+    // the other party can only apply a delta to the version last sent
+    long base = myVersion;
+    if (myVersion == 0 || myCF.hasChanges())
+        myVersion = newVersion();
+    vector<byte> delta;
+    if (base != 0) {
+        delta = myCF.deltaToByteVector();
+        if (delta.size() >= Compact2DBitArray::storageBytes(myCF.getFngprtSize(),
+                                                           myCF.getBucketSize(),
+                                                           myCF.getFilterSize()))
+            base = 0; // so much has changed that the whole filter is smaller
+    }
+    myCF.clearChanges();
+
+    commSync->commSend(base);
+    commSync->commSend(myVersion);
+    if (base != 0) {
+        commSync->commSend(ustring(delta.begin(), delta.end()));
+        if (commSync->commRecv_byte() == HAVE_BASE) {
+            Logger::gLog(Logger::METHOD_DETAILS, "CuckooSync: sent a delta of "
+                         + toStr(delta.size()) + " bytes");
+            return;
+        }
+    }
+    commSync->commSend(myCF);
+}
+
+const Cuckoo& CuckooSync::_recvFilter(const shared_ptr<Communicant>& commSync) {
+    if (!deltaTransfer) {
+        peerCF = commSync->commRecv_Cuckoo();
+        return peerCF;
+    }
+
+    long base = commSync->commRecv_long();
+    long version = commSync->commRecv_long();
+    if (base != 0) {
+        ustring delta = commSync->commRecv_ustring();
+        if (base == peerVersion) {
+            peerCF.applyDelta(vector<byte>(delta.begin(), delta.end()));
+            peerVersion = version;
+            commSync->commSend(HAVE_BASE);
+            return peerCF;
+        }
+        commSync->commSend(NEED_FULL);
+    }
+    peerCF = commSync->commRecv_Cuckoo();
+    peerVersion = version;
+    return peerCF;
+}
+
+void CuckooSync::_missingFrom(const Cuckoo& theirsCF,
+                              list<shared_ptr<DataObject>>& selfMinusOther) {
+    auto e = SyncMethod::beginElements();
+    vector<unsigned char> found = theirsCF.lookupAll(e, SyncMethod::endElements());
+    for (size_t ii=0; ii<found.size(); ii++)
+        if (!found[ii])
+            selfMinusOther.push_back(e[ii]);
+}
+
 bool CuckooSync::addElem(shared_ptr<DataObject> datum) {
     SyncMethod::addElem(datum);
+    if (replaying)
+        return true; // restored with the filter
     if (!myCF.insert(*datum))
         Logger::gLog(Logger::METHOD_DETAILS, "Cuckoo insert has failed.");
 
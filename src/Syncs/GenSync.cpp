@@ -14,6 +14,7 @@
 #include <CPISync/Syncs/IBLTSync.h>
 #include <CPISync/Syncs/IBLTSync_HalfRound.h>
 #include <CPISync/Syncs/IBLTSync_Multiset.h>
+#include <CPISync/Syncs/RatelessIBLTSync.h>
 #include <CPISync/Syncs/CPISync_HalfRound.h>
 #include <CPISync/Syncs/IBLTSetOfSets.h>
 #include <CPISync/Syncs/CuckooSync.h>
@@ -39,10 +40,8 @@ GenSync::GenSync(
     outFile = nullptr; // no output file is being used
     _PostProcessing = postProcessing;
 
-    // add each datum one by one
-    auto itData = data.begin();
-    for (; itData != data.end(); itData++)
-        addElem(*itData);
+    // add the data in one batch
+    addElems(vector<shared_ptr<DataObject>>(data.begin(), data.end()));
 }
 
 GenSync::GenSync(const vector<shared_ptr<Communicant>> &cVec, const vector<shared_ptr<SyncMethod>> &mVec, const string& fileName) {
@@ -54,11 +53,13 @@ GenSync::GenSync(const vector<shared_ptr<Communicant>> &cVec, const vector<share
     Logger::gLog(Logger::METHOD, "Utilizing file: " + fileName);
     ifstream inFile(fileName.c_str());
     string str;
+    vector<shared_ptr<DataObject>> fileData;
     for (getline(inFile, str); inFile.good(); getline(inFile, str)) {
-        addElem(make_shared<DataObject>(str)); // add this datum to our list
-        Logger::gLog(Logger::METHOD_DETAILS, "... added set element " + str);
+        fileData.push_back(make_shared<DataObject>(str));
+        Logger::gLog(Logger::METHOD_DETAILS, "... read set element " + str);
     }
     inFile.close();
+    addElems(fileData); // add the data to our list in one batch
 
     // register the file to which new data should be appended
     outFile = std::make_shared<ofstream>(fileName.c_str(), ios::app);
@@ -111,6 +112,24 @@ void GenSync::addElem(shared_ptr<DataObject> newDatum) {
 		(*outFile) << newDatum->to_string() << endl;
 }
 
+// add a batch of elements
+void GenSync::addElems(const vector<shared_ptr<DataObject>> &newData) {
+	Logger::gLog(Logger::METHOD, "Entering GenSync::addElems");
+	// store locally
+	myData.insert(myData.end(), newData.begin(), newData.end());
+
+	// update sync methods' metadata
+	for (const auto &agt : mySyncVec) {
+		if (!agt->addElems(newData))
+			Logger::error_and_quit("Could not add a batch of " + toStr(newData.size()) + " items.  Please considering increasing the number of bits per set element.");
+	}
+
+	// update file
+	if (outFile != nullptr)
+		for (const auto &datum : newData)
+			(*outFile) << datum->to_string() << endl;
+}
+
 // delete element
 bool GenSync::delElem(shared_ptr<DataObject> delPtr) {
 	Logger::gLog(Logger::METHOD, "Entering GenSync::delElem");
@@ -198,10 +217,8 @@ int GenSync::numComm() {
 void GenSync::addSyncAgt(const shared_ptr<SyncMethod>& newAgt, int index) {
 	Logger::gLog(Logger::METHOD, "Entering GenSync::addSyncAgt");
 	// create and populate the new agent
-	list<shared_ptr<DataObject>>::iterator itData;
-	for (itData = myData.begin(); itData != myData.end(); itData++)
-		if (!newAgt->addElem(*itData))
-			Logger::error_and_quit("Was not able to add an item to the next syncagent.");
+	if (!newAgt->addElems(vector<shared_ptr<DataObject>>(myData.begin(), myData.end())))
+		Logger::error_and_quit("Was not able to add an item to the next syncagent.");
 
 	// add the agent to the sync agents vector
 	auto idxIter = mySyncVec.begin();
@@ -371,6 +388,8 @@ GenSync GenSync::Builder::build() {
     theComms.push_back(myComm);
 
     const invalid_argument noMbar("Must define <mbar> explicitly for this sync.");
+    const IBLTHashScheme ibltHash = legacyIBLTHash ? IBLTHashScheme::Legacy : IBLTHashScheme::Seeded;
+    const RatFuncSolver ratFuncSolver = euclideanInterp ? RatFuncSolver::Euclidean : RatFuncSolver::Gaussian;
 
     // set default post process function pointer
     _postProcess = SyncMethod::postProcessing_SET;
@@ -380,18 +399,29 @@ GenSync GenSync::Builder::build() {
         case SyncProtocol::CPISync:
             if (mbar.isNullQ())
                 throw noMbar;
-            myMeth = make_shared<CPISync>(mbar, bits, errorProb, 0, hashes);
+            myMeth = make_shared<CPISync>(mbar, bits, errorProb, 0, hashes, ratFuncSolver);
             break;
         case SyncProtocol::ProbCPISync:
             if (mbar.isNullQ())
                 throw noMbar;
-            myMeth = make_shared<ProbCPISync>(mbar, bits, errorProb, hashes);
+            myMeth = make_shared<ProbCPISync>(mbar, bits, errorProb, hashes, ratFuncSolver);
             break;
-        case SyncProtocol::InteractiveCPISync:
+        case SyncProtocol::InteractiveCPISync: {
             if (mbar.isNullQ())
                 throw noMbar;
-            myMeth = make_shared<InterCPISync>(mbar, bits, errorProb, numParts, hashes);
+            auto interSync = make_shared<InterCPISync>(mbar, bits, errorProb, numParts, hashes);
+            if (subtreeConns > 0) {
+                if (comm != SyncComm::socket)
+                    throw invalid_argument("Subtree connections are only available for socket-based syncs.");
+                vector<shared_ptr<Communicant>> subtreeComms;
+                for (size_t ii = 1; ii <= subtreeConns; ii++)
+                    subtreeComms.push_back(make_shared<CommSocket>(port + (int) ii, host));
+                interSync->setSubtreeComms(subtreeComms);
+            }
+            interSync->setBreadthFirst(breadthFirst);
+            myMeth = interSync;
             break;
+        }
         case SyncProtocol::OneWayCPISync:
             if (mbar.isNullQ())
                 throw noMbar;
@@ -401,20 +431,25 @@ GenSync GenSync::Builder::build() {
             myMeth = make_shared<FullSync>();
             break;
         case SyncProtocol::IBLTSync:
-            myMeth = make_shared<IBLTSync>(numExpElem, bits);
+            myMeth = make_shared<IBLTSync>(numExpElem, bits, ibltHash, estimateIBLTSize, ibltRetries, flatIBLT,
+                                           ibltSnapshot);
             break;
         case SyncProtocol::OneWayIBLTSync:
-            myMeth = make_shared<IBLTSync_HalfRound>(numExpElem, bits);
+            myMeth = make_shared<IBLTSync_HalfRound>(numExpElem, bits, ibltHash);
             break;
         case SyncProtocol::IBLTSetOfSets:
-            myMeth = make_shared<IBLTSetOfSets>(numExpElem, numElemChldSet, bits);
+            myMeth = make_shared<IBLTSetOfSets>(numExpElem, numElemChldSet, bits, ibltHash);
             _postProcess = IBLTSetOfSets::postProcessing_IBLTSetOfSets;
             break;
         case SyncProtocol::CuckooSync:
-            myMeth = make_shared<CuckooSync>(fngprtSize, bucketSize, filterSize, maxKicks);
+            myMeth = make_shared<CuckooSync>(fngprtSize, bucketSize, filterSize, maxKicks, deltaTransfer,
+                                          cuckooSnapshot);
             break;
         case SyncProtocol::IBLTSync_Multiset:
-            myMeth = make_shared<IBLTSync_Multiset>(numExpElem, bits);
+            myMeth = make_shared<IBLTSync_Multiset>(numExpElem, bits, ibltHash);
+            break;
+        case SyncProtocol::RatelessIBLTSync:
+            myMeth = make_shared<RatelessIBLTSync>(ibltHash);
             break;
         default:
             throw invalid_argument("I don't know how to synchronize with this protocol.");
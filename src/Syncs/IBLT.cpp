@@ -12,8 +12,8 @@
 IBLT::IBLT() = default;
 IBLT::~IBLT() = default;
 
-IBLT::IBLT(size_t expectedNumEntries, size_t _valueSize)
-: valueSize(_valueSize)
+IBLT::IBLT(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme)
+: valueSize(_valueSize), hashScheme(scheme)
 {
     // 1.5x expectedNumEntries gives very low probability of decoding failure
     size_t nEntries = expectedNumEntries + expectedNumEntries/2;
@@ -28,22 +28,42 @@ hash_t IBLT::_hash(const hash_t& initial, long kk) {
     return _hash(shash(toStr(initial)), kk-1);
 }
 
-hash_t IBLT::_hashK(const ZZ &item, long kk) {
+hash_t IBLT::_hashK(const ZZ &item, long kk, IBLTHashScheme scheme) {
+    if (scheme == IBLTHashScheme::Seeded)
+        return seededHashK(seededHash(item, 0), kk);
     std::hash<std::string> shash; // stl uses MurmurHashUnaligned2 for calculating the hash of a string
     return _hash(shash(toStr(item)), kk-1);
 }
 
-hash_t IBLT::_setHash(multiset<shared_ptr<DataObject>> &tarSet)
+void IBLT::_hashes(const ZZ &key, IBLTHashScheme scheme, hash_t *hashes) {
+    if (scheme == IBLTHashScheme::Seeded) {
+        hash_t base = seededHash(key, 0);
+        for (int ii = 0; ii < N_HASH; ii++)
+            hashes[ii] = seededHashK(base, ii);
+        hashes[N_HASH] = seededHashK(base, N_HASHCHECK);
+    } else {
+        // the legacy hashes form a chain, each being the hash of the previous one
+        std::hash<std::string> shash;
+        hash_t hk = shash(toStr(key));
+        for (int ii = 0; ii < N_HASHCHECK; ii++) {
+            if (ii < N_HASH) hashes[ii] = hk;
+            hk = shash(toStr(hk));
+        }
+        hashes[N_HASH] = hk;
+    }
+}
+
+hash_t IBLT::_setHash(multiset<shared_ptr<DataObject>> &tarSet) const
 {
     hash_t outHash = 0;
     for (auto itr : tarSet)
     {
-        outHash += _hashK(itr->to_ZZ(), 1);
+        outHash += _hashK(itr->to_ZZ(), 1, hashScheme);
     }
     return outHash;
 }
 
-void IBLT::_insert(long plusOrMinus, ZZ key, ZZ value) {
+void IBLT::_insert(long plusOrMinus, ZZ key, ZZ value, long *cells) {
     long bucketsPerHash = hashTable.size() / N_HASH;
 
     if(sizeof(value) != valueSize) {
@@ -51,14 +71,19 @@ void IBLT::_insert(long plusOrMinus, ZZ key, ZZ value) {
                                + toStr(sizeof(value)) + ". IBLT value size: " + toStr(valueSize));
     }
 
+    hash_t hashes[N_HASH + 1];
+    _hashes(key, hashScheme, hashes);
+
     for(int ii=0; ii < N_HASH; ii++){
-        hash_t hk = _hashK(key, ii);
+        hash_t hk = hashes[ii];
         long startEntry = ii * bucketsPerHash;
         IBLT::HashTableEntry& entry = hashTable.at(startEntry + (hk%bucketsPerHash));
+        if (cells != nullptr)
+            cells[ii] = startEntry + (hk%bucketsPerHash);
 
         entry.count += plusOrMinus;
         entry.keySum ^= key;
-        entry.keyCheck ^= _hashK(key, N_HASHCHECK);
+        entry.keyCheck ^= hashes[N_HASH];
         if (entry.empty()) {
             entry.valueSum.kill();
         }
@@ -78,11 +103,53 @@ void IBLT::erase(ZZ key, ZZ value)
     _insert(-1, key, value);
 }
 
+void IBLT::bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                      vector<shared_ptr<DataObject>>::const_iterator end, size_t numThreads) {
+    size_t numElems = end - begin;
+    numThreads = numWorkers(numThreads, numElems, MIN_BULK_PER_THREAD);
+
+    // each thread fills a partial table with the same shape as this one ...
+    IBLT empty;
+    empty.valueSize = valueSize;
+    empty.hashScheme = hashScheme;
+    empty.hashTable.resize(hashTable.size());
+    vector<IBLT> partials(numThreads, empty);
+    parallelFor(numElems, numThreads, [&](size_t first, size_t last, size_t slice) {
+        for (size_t ii = first; ii < last; ii++) {
+            ZZ elt = begin[ii]->to_ZZ();
+            partials[slice]._insert(1, elt, elt);
+        }
+    });
+
+    // ... and then each thread merges a slice of the cells from all partial tables
+    parallelFor(hashTable.size(), numThreads, [&](size_t first, size_t last, size_t) {
+        for (size_t ii = first; ii < last; ii++) {
+            IBLT::HashTableEntry &entry = hashTable[ii];
+            for (const IBLT &partial : partials) {
+                const IBLT::HashTableEntry &other = partial.hashTable[ii];
+                if (other.empty())
+                    continue;
+                entry.count += other.count;
+                entry.keySum ^= other.keySum;
+                entry.keyCheck ^= other.keyCheck;
+                if (entry.empty()) {
+                    entry.valueSum.kill();
+                }
+                else {
+                    entry.valueSum ^= other.valueSum;
+                }
+            }
+        }
+    });
+}
+
 bool IBLT::get(ZZ key, ZZ& result){
     long bucketsPerHash = hashTable.size()/N_HASH;
+    hash_t hashes[N_HASH + 1];
+    _hashes(key, hashScheme, hashes);
     for (long ii = 0; ii < N_HASH; ii++) {
         long startEntry = ii*bucketsPerHash;
-        unsigned long hk = _hashK(key, ii);
+        unsigned long hk = hashes[ii];
         const IBLT::HashTableEntry& entry = hashTable[startEntry + (hk%bucketsPerHash)];
 
         if (entry.empty()) {
@@ -91,7 +158,7 @@ bool IBLT::get(ZZ key, ZZ& result){
 
             return true;
         }
-        else if (entry.isPure()) {
+        else if (entry.isPure(hashScheme)) {
             if (entry.keySum == key) {
                 // Found!
                 result = entry.valueSum;
@@ -106,28 +173,46 @@ bool IBLT::get(ZZ key, ZZ& result){
     }
 
     // Don't know if k is in table or not; "peel" the IBLT to try to find it:
-    long nErased;
-    do {
-        nErased = 0;
-        for (IBLT::HashTableEntry &entry : this->hashTable) {
-            if (entry.isPure()) {
-                if (entry.keySum == key) {
-                    string s = toStr(entry.valueSum);
-                    result = entry.valueSum;
-                    return true;
-                }
-                nErased++;
-                this->_insert(-entry.count, entry.keySum, entry.valueSum);
-            }
+    vector<long> candidates = _pureCells();
+    while (!candidates.empty()) {
+        IBLT::HashTableEntry &entry = hashTable[candidates.back()];
+        candidates.pop_back();
+        if (!entry.isPure(hashScheme))
+            continue; // changed by an earlier peel
+
+        if (entry.keySum == key) {
+            result = entry.valueSum;
+            return true;
         }
-    } while (nErased > 0);
+        _peel(entry, candidates);
+    }
     return false;
 }
 
-bool IBLT::HashTableEntry::isPure() const
+vector<long> IBLT::_pureCells() const {
+    vector<long> pure;
+    for (long ii = 0; ii < (long) hashTable.size(); ii++)
+        if (hashTable[ii].isPure(hashScheme))
+            pure.push_back(ii);
+    return pure;
+}
+
+void IBLT::_peel(IBLT::HashTableEntry &entry, vector<long> &candidates) {
+    long cells[N_HASH];
+    _insert(-entry.count, entry.keySum, entry.valueSum, cells);
+
+    // only the cells that were just updated can have become pure
+    for (long cell : cells) {
+        long count = hashTable[cell].count;
+        if (count == 1 || count == -1)
+            candidates.push_back(cell);
+    }
+}
+
+bool IBLT::HashTableEntry::isPure(IBLTHashScheme scheme) const
 {
     if (count == 1 || count == -1) {
-        hash_t check = _hashK(keySum, N_HASHCHECK);
+        hash_t check = _hashK(keySum, N_HASHCHECK, scheme);
         return (keyCheck == check);
     }
     return false;
@@ -139,22 +224,22 @@ bool IBLT::HashTableEntry::empty() const
 }
 
 bool IBLT::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative){
-    long nErased;
-    do {
-        nErased = 0;
-        for(IBLT::HashTableEntry& entry : this->hashTable) {
-            if (entry.isPure()) {
-                if (entry.count == 1) {
-                    positive.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
-                }
-                else {
-                    negative.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
-                }
-                this->_insert(-entry.count, entry.keySum, entry.valueSum);
-                ++nErased;
-            }
+    // peel pure cells, revisiting only the cells touched by each peel
+    vector<long> candidates = _pureCells();
+    while (!candidates.empty()) {
+        IBLT::HashTableEntry &entry = hashTable[candidates.back()];
+        candidates.pop_back();
+        if (!entry.isPure(hashScheme))
+            continue; // changed by an earlier peel
+
+        if (entry.count == 1) {
+            positive.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
+        }
+        else {
+            negative.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
         }
-    } while (nErased > 0);
+        _peel(entry, candidates);
+    }
 
     // If any buckets for one of the hash functions is not empty,
     // then we didn't peel them all:
@@ -171,10 +256,13 @@ IBLT& IBLT::operator-=(const IBLT& other) {
     if(hashTable.size() != other.hashTable.size())
         Logger::error_and_quit("The IBLT hash table sizes are different! Ours: "
         + toStr(hashTable.size()) + ". Theirs: " + toStr(other.valueSize));
+    if(hashScheme != other.hashScheme)
+        Logger::error_and_quit("The IBLT hash schemes are different!");
 
+    // the sizes match, so the cells need no bounds checks
     for (unsigned long ii = 0; ii < hashTable.size(); ii++) {
-        IBLT::HashTableEntry& e1 = this->hashTable.at(ii);
-        const IBLT::HashTableEntry& e2 = other.hashTable.at(ii);
+        IBLT::HashTableEntry& e1 = this->hashTable[ii];
+        const IBLT::HashTableEntry& e2 = other.hashTable[ii];
         e1.count -= e2.count;
         e1.keySum ^= e2.keySum;
         e1.keyCheck ^= e2.keyCheck;
@@ -203,38 +291,61 @@ size_t IBLT::eltSize() const {
     return valueSize;
 }
 
-vector<byte> IBLT::toByteVector() const {
-    vector<byte> res;
-    for (auto entry: hashTable) {
-        vector<byte> byteRep = toBytes<long>(entry.count);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes<hash_t>(entry.keyCheck);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes(entry.keySum);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes(entry.valueSum);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-    }
+IBLTHashScheme IBLT::getHashScheme() const {
+    return hashScheme;
+}
+
+size_t IBLT::_cellSize(size_t idx) const {
+    const IBLT::HashTableEntry &entry = hashTable[idx];
+    return sizeof(long) + sizeof(hash_t) + serialSizeZZ(entry.keySum) + serialSizeZZ(entry.valueSum);
+}
+
+byte *IBLT::_writeCell(size_t idx, byte *out) const {
+    // the same bytes as toBytes of each field, written in place
+    const IBLT::HashTableEntry &entry = hashTable[idx];
+    out = writeWordLE((std::uint64_t) std::labs(entry.count), out);
+    out = writeWordLE(entry.keyCheck, out);
+    out = writeBytesZZ(entry.keySum, out);
+    return writeBytesZZ(entry.valueSum, out);
+}
 
+size_t IBLT::_trailerSize() const {
+    return hashes.empty() ? 0 : sizeof(long) + hashes.size() * sizeof(hash_t);
+}
+
+byte *IBLT::_writeTrailer(byte *out) const {
     // if IBLTSetOfSet
-    if (hashes.size() > 0 ) {
-        vector<byte> byteRep = toBytes((long)hashes.size());
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        for (const auto &hash : hashes) {
-            byteRep = toBytes(hash);
-            res.insert(res.end(), byteRep.begin(), byteRep.end());
-        }
+    if (!hashes.empty()) {
+        out = writeWordLE(hashes.size(), out);
+        for (const auto &hash : hashes)
+            out = writeWordLE(hash, out);
     }
+    return out;
+}
+
+vector<byte> IBLT::toByteVector() const {
+    size_t total = _trailerSize();
+    for (size_t idx = 0; idx < hashTable.size(); idx++)
+        total += _cellSize(idx);
+
+    vector<byte> res(total);
+    byte *out = res.data();
+    for (size_t idx = 0; idx < hashTable.size(); idx++)
+        out = _writeCell(idx, out);
+    _writeTrailer(out);
     return res;
 }
 
 void IBLT::fromByteVector(vector<byte> data) {
-    vector<byte> res;
-    byte *buf = data.data();
-    for (long index = 0; index < hashTable.size(); index++) {
-        hashTable[index].count = fromBytes<long>(buf);
+    _parseBytes(data.data(), data.size());
+}
+
+void IBLT::_parseBytes(const byte *buf, size_t len) {
+    const byte *end = buf + len;
+    for (size_t index = 0; index < hashTable.size(); index++) {
+        hashTable[index].count = (long) readWordLE(buf);
         buf += sizeof(long);
-        hashTable[index].keyCheck = fromBytes<hash_t>(buf);
+        hashTable[index].keyCheck = readWordLE(buf);
         buf += sizeof(hash_t);
         long bytesRead;
         hashTable[index].keySum = fromBytesZZ(buf, bytesRead);
@@ -244,16 +355,16 @@ void IBLT::fromByteVector(vector<byte> data) {
     }
 
     // if IBLTSetOfSet
-    if (buf != data.data() + data.size()) {
-        long hashNum = fromBytes<long>(buf);
+    if (buf < end) {
+        auto hashNum = (long) readWordLE(buf);
         buf += sizeof(hashNum);
         hashes.resize(hashNum);
         for (int ii = 0; ii < hashNum; ii++) {
-            hashes[ii] = fromBytes<hash_t>(buf);
+            hashes[ii] = readWordLE(buf);
             buf += sizeof(hash_t);
         }
     }
-    Logger::gLog(Logger::METHOD_DETAILS, "IBLT fromByteVector complete, "
+    Logger::gLog(Logger::METHOD_DETAILS, "IBLT parse complete, "
                                "read entries: " + toStr(hashTable.size()));
 }
 
@@ -325,7 +436,7 @@ void IBLT::insert(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, size
     
     hashes.push_back(setHash);
     // Put chld set into a chld IBLT
-    IBLT chldIBLT(expnChldSet, elemSize);
+    IBLT chldIBLT(expnChldSet, elemSize, hashScheme);
     for (auto itr : tarSet)
     {
         chldIBLT.insert(itr->to_ZZ(), itr->to_ZZ());
@@ -344,7 +455,7 @@ void IBLT::erase(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, size_
     bool found = false;
 
     // if target hash not in current structure, hash again and perform another round of search
-    long curInd = 0;
+    size_t curInd = 0;
     while(true){
         for (auto itr = hashes.begin(); itr < hashes.end(); itr++)
         {
@@ -368,7 +479,7 @@ void IBLT::erase(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, size_
     }
 
 
-    IBLT chldIBLT(expnChldSet, elemSize);
+    IBLT chldIBLT(expnChldSet, elemSize, hashScheme);
     for (auto itr : tarSet)
     {
         chldIBLT.insert(itr->to_ZZ(), itr->to_ZZ());
@@ -0,0 +1,594 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * A fixed-width, word-based cell layout for IBLT.  See IBLTFlat.h.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+#include <CPISync/Syncs/IBLTFlat.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define IBLTFLAT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+    const size_t WORD_BYTES = sizeof(IBLTFlat::word_t);
+
+    // @return the number of significant bytes in the len little-endian words at words
+    inline size_t significantBytes(const IBLTFlat::word_t *words, size_t len) {
+        for (size_t ii = len; ii > 0; ii--) {
+            IBLTFlat::word_t word = words[ii - 1];
+            if (word != 0) {
+                size_t bytes = (ii - 1) * WORD_BYTES;
+                while (word != 0) {
+                    bytes++;
+                    word >>= 8;
+                }
+                return bytes;
+            }
+        }
+        return 0;
+    }
+
+    /*
+     * Table-wide kernels.
+     * Every cell is a multiple of four words (see IBLTFlat::_init) and the table is cache-aligned,
+     * so the vector kernels below work on whole, aligned cells.  The count word is subtracted,
+     * all other words are XORed, and the value of a cell that becomes empty is cleared.
+     */
+    typedef void (*subtract_kernel)(IBLTFlat::word_t *, const IBLTFlat::word_t *, size_t, size_t, size_t);
+    typedef bool (*all_zero_kernel)(const IBLTFlat::word_t *, size_t);
+
+    // Clears the value of the cell at cell if its count, check and key words are all zero
+    inline void clearIfEmpty(IBLTFlat::word_t *cell, size_t keyWords) {
+        IBLTFlat::word_t any = 0;
+        for (size_t jj = 0; jj < 2 + keyWords; jj++)
+            any |= cell[jj];
+        if (any == 0)
+            std::fill(cell + 2 + keyWords, cell + 2 + 2 * keyWords, 0);
+    }
+
+    void subtractScalar(IBLTFlat::word_t *mine, const IBLTFlat::word_t *theirs,
+                        size_t numCells, size_t cellWords, size_t keyWords) {
+        for (size_t idx = 0; idx < numCells; idx++, mine += cellWords, theirs += cellWords) {
+            mine[0] -= theirs[0];
+            for (size_t jj = 1; jj < cellWords; jj++)
+                mine[jj] ^= theirs[jj];
+            clearIfEmpty(mine, keyWords);
+        }
+    }
+
+    bool allZeroScalar(const IBLTFlat::word_t *words, size_t len) {
+        IBLTFlat::word_t any = 0;
+        for (size_t ii = 0; ii < len; ii++)
+            any |= words[ii];
+        return any == 0;
+    }
+
+#ifdef IBLTFLAT_X86_KERNELS
+    __attribute__((target("avx2")))
+    void subtractAVX2(IBLTFlat::word_t *mine, const IBLTFlat::word_t *theirs,
+                      size_t numCells, size_t cellWords, size_t keyWords) {
+        const __m256i countLane = _mm256_set_epi64x(0, 0, 0, -1);
+        const __m256i headLanes = _mm256_set_epi64x(0, -1, -1, -1); // count, check and a one-word key
+        for (size_t idx = 0; idx < numCells; idx++, mine += cellWords, theirs += cellWords) {
+            __m256i aa = _mm256_load_si256((const __m256i *) mine);
+            __m256i bb = _mm256_load_si256((const __m256i *) theirs);
+            __m256i res = _mm256_blendv_epi8(_mm256_xor_si256(aa, bb), _mm256_sub_epi64(aa, bb), countLane);
+            if (keyWords == 1) {
+                // the whole cell is in one register
+                if (_mm256_testz_si256(res, headLanes))
+                    res = _mm256_and_si256(res, headLanes);
+                _mm256_store_si256((__m256i *) mine, res);
+                continue;
+            }
+            _mm256_store_si256((__m256i *) mine, res);
+            for (size_t jj = 4; jj < cellWords; jj += 4) {
+                __m256i cc = _mm256_load_si256((const __m256i *) (mine + jj));
+                __m256i dd = _mm256_load_si256((const __m256i *) (theirs + jj));
+                _mm256_store_si256((__m256i *) (mine + jj), _mm256_xor_si256(cc, dd));
+            }
+            clearIfEmpty(mine, keyWords);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    bool allZeroAVX2(const IBLTFlat::word_t *words, size_t len) {
+        __m256i any = _mm256_setzero_si256();
+        size_t ii = 0;
+        for (; ii + 4 <= len; ii += 4)
+            any = _mm256_or_si256(any, _mm256_load_si256((const __m256i *) (words + ii)));
+        return _mm256_testz_si256(any, any) && allZeroScalar(words + ii, len - ii);
+    }
+
+    __attribute__((target("sse4.2")))
+    void subtractSSE42(IBLTFlat::word_t *mine, const IBLTFlat::word_t *theirs,
+                       size_t numCells, size_t cellWords, size_t keyWords) {
+        for (size_t idx = 0; idx < numCells; idx++, mine += cellWords, theirs += cellWords) {
+            __m128i aa = _mm_load_si128((const __m128i *) mine);
+            __m128i bb = _mm_load_si128((const __m128i *) theirs);
+            // low word (count) from the difference, high word (check) from the XOR
+            _mm_store_si128((__m128i *) mine, _mm_blend_epi16(_mm_xor_si128(aa, bb), _mm_sub_epi64(aa, bb), 0x0F));
+            for (size_t jj = 2; jj < cellWords; jj += 2) {
+                __m128i cc = _mm_load_si128((const __m128i *) (mine + jj));
+                __m128i dd = _mm_load_si128((const __m128i *) (theirs + jj));
+                _mm_store_si128((__m128i *) (mine + jj), _mm_xor_si128(cc, dd));
+            }
+            clearIfEmpty(mine, keyWords);
+        }
+    }
+
+    __attribute__((target("sse4.2")))
+    bool allZeroSSE42(const IBLTFlat::word_t *words, size_t len) {
+        __m128i any = _mm_setzero_si128();
+        size_t ii = 0;
+        for (; ii + 2 <= len; ii += 2)
+            any = _mm_or_si128(any, _mm_load_si128((const __m128i *) (words + ii)));
+        return _mm_testz_si128(any, any) && allZeroScalar(words + ii, len - ii);
+    }
+#endif
+
+    // @return the best subtraction kernel supported by this processor
+    subtract_kernel subtractKernel() {
+        static const subtract_kernel kernel = [] {
+#ifdef IBLTFLAT_X86_KERNELS
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return (subtract_kernel) subtractAVX2;
+            if (__builtin_cpu_supports("sse4.2")) return (subtract_kernel) subtractSSE42;
+#endif
+            return (subtract_kernel) subtractScalar;
+        }();
+        return kernel;
+    }
+
+    // @return the best emptiness scan supported by this processor
+    all_zero_kernel allZeroKernel() {
+        static const all_zero_kernel kernel = [] {
+#ifdef IBLTFLAT_X86_KERNELS
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return (all_zero_kernel) allZeroAVX2;
+            if (__builtin_cpu_supports("sse4.2")) return (all_zero_kernel) allZeroSSE42;
+#endif
+            return (all_zero_kernel) allZeroScalar;
+        }();
+        return kernel;
+    }
+}
+
+IBLTFlat::IBLTFlat() = default;
+
+IBLTFlat::~IBLTFlat() {
+    _close();
+}
+
+IBLTFlat::IBLTFlat(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme) {
+    _init(_numCells(expectedNumEntries), _valueSize, scheme);
+}
+
+IBLTFlat::IBLTFlat(const string &fileName, size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme) {
+    _layout(_numCells(expectedNumEntries), _valueSize, scheme);
+    snapshot.reset(new MappedFile(fileName, (SNAP_HEADER_WORDS + numCells * cellWords) * WORD_BYTES));
+    cells = _header() + SNAP_HEADER_WORDS;
+
+    word_t *header = _header();
+    wasResumed = !snapshot->fresh() && header[SNAP_MAGIC] == SNAPSHOT_MAGIC && header[SNAP_CELLS] == numCells
+                 && header[SNAP_VALUE_SIZE] == valueSize && header[SNAP_CELL_WORDS] == cellWords
+                 && header[SNAP_SCHEME] == (word_t) hashScheme && header[SNAP_CLEAN] != 0;
+    if (wasResumed) {
+        Logger::gLog(Logger::METHOD_DETAILS, "IBLTFlat resumed from " + fileName);
+        return;
+    }
+
+    // a new file, another IBLT's, or one that changed after it was last flushed: start over
+    Logger::gLog(Logger::METHOD_DETAILS, "IBLTFlat snapshot " + fileName + " cannot be resumed; starting empty");
+    std::fill(cells, cells + numCells * cellWords, 0);
+    header[SNAP_CELLS] = numCells;
+    header[SNAP_VALUE_SIZE] = valueSize;
+    header[SNAP_CELL_WORDS] = cellWords;
+    header[SNAP_SCHEME] = (word_t) hashScheme;
+    header[SNAP_CLEAN] = 0;
+    header[SNAP_MAGIC] = SNAPSHOT_MAGIC;
+    flush();
+}
+
+IBLTFlat::IBLTFlat(const IBLTFlat &other) {
+    *this = other;
+}
+
+IBLTFlat &IBLTFlat::operator=(const IBLTFlat &other) {
+    if (this == &other)
+        return *this;
+    _close();
+    _layout(other.numCells, other.valueSize, other.hashScheme);
+    table.assign(other.cells, other.cells + numCells * cellWords);
+    cells = table.data();
+    return *this;
+}
+
+IBLTFlat::IBLTFlat(IBLTFlat &&other) noexcept {
+    *this = std::move(other);
+}
+
+IBLTFlat &IBLTFlat::operator=(IBLTFlat &&other) noexcept {
+    if (this == &other)
+        return *this;
+    _close();
+    _layout(other.numCells, other.valueSize, other.hashScheme);
+    table = std::move(other.table);
+    snapshot = std::move(other.snapshot);
+    cells = other.cells;
+    wasResumed = other.wasResumed;
+    other.cells = nullptr;
+    other.numCells = 0;
+    return *this;
+}
+
+void IBLTFlat::_close() {
+    flush();
+    snapshot.reset();
+    table.clear();
+    cells = nullptr;
+    wasResumed = false;
+}
+
+bool IBLTFlat::resumed() const {
+    return wasResumed;
+}
+
+void IBLTFlat::flush() {
+    if (!snapshot)
+        return;
+    // the cells must be on disk before the header claims that they are consistent
+    snapshot->flush();
+    _header()[SNAP_CLEAN] = 1;
+    snapshot->flush(SNAP_HEADER_WORDS * WORD_BYTES);
+}
+
+void IBLTFlat::_markChanged() {
+    // a clean mark must never reach the disk after changed cells do
+    _header()[SNAP_CLEAN] = 0;
+    snapshot->flush(SNAP_HEADER_WORDS * WORD_BYTES);
+}
+
+size_t IBLTFlat::_numCells(size_t expectedNumEntries) {
+    // same sizing as IBLT, so that the two are interchangeable on the wire
+    size_t nEntries = expectedNumEntries + expectedNumEntries/2;
+    while (N_HASH * (nEntries/N_HASH) != nEntries) ++nEntries;
+    return nEntries;
+}
+
+void IBLTFlat::_init(size_t _numCells, size_t _valueSize, IBLTHashScheme scheme) {
+    _close();
+    _layout(_numCells, _valueSize, scheme);
+    table.assign(numCells * cellWords, 0);
+    cells = table.data();
+}
+
+void IBLTFlat::_layout(size_t _numCells, size_t _valueSize, IBLTHashScheme scheme) {
+    numCells = _numCells;
+    valueSize = _valueSize;
+    hashScheme = scheme;
+    keyWords = (valueSize + WORD_BYTES - 1) / WORD_BYTES;
+    if (keyWords == 0) keyWords = 1;
+
+    // pad cells to a power of two words while they fit into a cache line, and to whole cache lines otherwise
+    const size_t lineWords = CACHE_LINE / WORD_BYTES;
+    size_t used = KEY + 2 * keyWords;
+    if (used <= lineWords) {
+        cellWords = 1;
+        while (cellWords < used) cellWords <<= 1;
+    } else
+        cellWords = lineWords * ((used + lineWords - 1) / lineWords);
+
+    peelBuf.assign(2 * keyWords, 0);
+    keyBuf.assign(keyWords, 0);
+    valueBuf.assign(keyWords, 0);
+    candidates.clear();
+}
+
+void IBLTFlat::_hashes(const word_t *key, hash_t *hashes) const {
+    size_t keyBytes = significantBytes(key, keyWords);
+    if (hashScheme == IBLTHashScheme::Seeded) {
+        // the words hold the little-endian bytes of the key, as hashed by IBLT
+        hash_t base = seededHashWords(key, keyBytes, 0);
+        for (int ii = 0; ii < N_HASH; ii++)
+            hashes[ii] = seededHashK(base, ii);
+        hashes[N_HASH] = seededHashK(base, N_HASHCHECK);
+        return;
+    }
+
+    // IBLT hashes the decimal representation of a key, and then iterates the hash on its own decimal representation
+    std::hash<std::string> shash;
+    hash_t hk = keyBytes <= WORD_BYTES ? shash(toStr(key[0])) : shash(toStr(_toZZ(key)));
+    for (int ii = 0; ii < N_HASHCHECK; ii++) {
+        if (ii < N_HASH) hashes[ii] = hk;
+        hk = shash(toStr(hk));
+    }
+    hashes[N_HASH] = hk;
+}
+
+void IBLTFlat::_toWords(const ZZ &num, word_t *words) const {
+    if (sign(num) < 0 || NumBytes(num) > (long) (keyWords * WORD_BYTES)) {
+        Logger::error_and_quit("The number being inserted does not fit into the IBLT value size! number: "
+                               + toStr(num) + ". IBLT value size: " + toStr(valueSize));
+    }
+    auto *bytes = reinterpret_cast<byte *>(words);
+    BytesFromZZ(bytes, num, keyWords * WORD_BYTES);
+    for (size_t ii = 0; ii < keyWords; ii++)
+        words[ii] = readWordLE(bytes + ii * WORD_BYTES);
+}
+
+ZZ IBLTFlat::_toZZ(const word_t *words) const {
+    // the ZZ allocates anyway, so a buffer of its own costs little
+    vector<byte> bytes(keyWords * WORD_BYTES);
+    for (size_t ii = 0; ii < keyWords; ii++)
+        writeWordLE(words[ii], bytes.data() + ii * WORD_BYTES);
+    return ZZFromBytes(bytes.data(), bytes.size());
+}
+
+bool IBLTFlat::_isEmpty(const word_t *cell) const {
+    if (cell[COUNT] != 0 || cell[CHECK] != 0) return false;
+    for (size_t ii = 0; ii < keyWords; ii++)
+        if (cell[KEY + ii] != 0) return false;
+    return true;
+}
+
+bool IBLTFlat::_isPure(const word_t *cell) const {
+    auto count = (std::int64_t) cell[COUNT];
+    if (count == 1 || count == -1) {
+        hash_t hashes[N_HASH + 1];
+        _hashes(cell + KEY, hashes);
+        return cell[CHECK] == hashes[N_HASH];
+    }
+    return false;
+}
+
+void IBLTFlat::_insert(long plusOrMinus, const word_t *key, const word_t *value, size_t *cells) {
+    size_t bucketsPerHash = numCells / N_HASH;
+    hash_t hashes[N_HASH + 1];
+    _hashes(key, hashes);
+    _touch();
+
+    for (int ii = 0; ii < N_HASH; ii++) {
+        size_t idx = ii * bucketsPerHash + (hashes[ii] % bucketsPerHash);
+        if (cells != nullptr) cells[ii] = idx;
+        word_t *cell = _cell(idx);
+
+        cell[COUNT] += (word_t) plusOrMinus;
+        cell[CHECK] ^= hashes[N_HASH];
+        for (size_t jj = 0; jj < keyWords; jj++)
+            cell[KEY + jj] ^= key[jj];
+
+        word_t *valueSum = cell + KEY + keyWords;
+        if (_isEmpty(cell)) {
+            std::fill(valueSum, valueSum + keyWords, 0);
+        } else {
+            for (size_t jj = 0; jj < keyWords; jj++)
+                valueSum[jj] ^= value[jj];
+        }
+    }
+}
+
+void IBLTFlat::insert(const ZZ &key, const ZZ &value) {
+    _toWords(key, keyBuf.data());
+    _toWords(value, valueBuf.data());
+    _insert(1, keyBuf.data(), valueBuf.data());
+}
+
+void IBLTFlat::erase(const ZZ &key, const ZZ &value) {
+    _toWords(key, keyBuf.data());
+    _toWords(value, valueBuf.data());
+    _insert(-1, keyBuf.data(), valueBuf.data());
+}
+
+void IBLTFlat::bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                          vector<shared_ptr<DataObject>>::const_iterator end) {
+    for (auto iter = begin; iter != end; ++iter) {
+        _toWords((*iter)->to_ZZ(), keyBuf.data());
+        _insert(1, keyBuf.data(), keyBuf.data());
+    }
+}
+
+bool IBLTFlat::get(const ZZ &key, ZZ &result) {
+    size_t bucketsPerHash = numCells / N_HASH;
+    _toWords(key, keyBuf.data());
+    hash_t hashes[N_HASH + 1];
+    _hashes(keyBuf.data(), hashes);
+
+    for (int ii = 0; ii < N_HASH; ii++) {
+        const word_t *cell = _cell(ii * bucketsPerHash + (hashes[ii] % bucketsPerHash));
+
+        if (_isEmpty(cell)) {
+            // Definitely not in table. Leave result empty, return true.
+            return true;
+        } else if (_isPure(cell)) {
+            if (std::equal(keyBuf.begin(), keyBuf.end(), cell + KEY))
+                result = _toZZ(cell + KEY + keyWords); // Found!
+            else
+                result.kill(); // Definitely not in table
+            return true;
+        }
+    }
+
+    // Don't know if k is in table or not; "peel" the IBLT to try to find it:
+    _findPureCells();
+    while (!candidates.empty()) {
+        const word_t *cell = _cell(candidates.back());
+        candidates.pop_back();
+        if (!_isPure(cell))
+            continue; // changed by an earlier peel
+
+        if (std::equal(keyBuf.begin(), keyBuf.end(), cell + KEY)) {
+            result = _toZZ(cell + KEY + keyWords);
+            return true;
+        }
+        _peel(cell);
+    }
+    return false;
+}
+
+void IBLTFlat::_findPureCells() {
+    candidates.clear();
+    for (size_t idx = 0; idx < numCells; idx++)
+        if (_isPure(_cell(idx)))
+            candidates.push_back(idx);
+}
+
+void IBLTFlat::_peel(const word_t *cell) {
+    // the cell itself is modified by _insert, so work from a copy of its contents
+    std::copy(cell + KEY, cell + KEY + 2 * keyWords, peelBuf.begin());
+    size_t cells[N_HASH];
+    _insert(-(std::int64_t) cell[COUNT], peelBuf.data(), peelBuf.data() + keyWords, cells);
+
+    // only the cells that were just updated can have become pure
+    for (size_t idx : cells) {
+        auto count = (std::int64_t) _cell(idx)[COUNT];
+        if (count == 1 || count == -1)
+            candidates.push_back(idx);
+    }
+}
+
+bool IBLTFlat::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative) {
+    // peel pure cells, revisiting only the cells touched by each peel
+    _findPureCells();
+    while (!candidates.empty()) {
+        const word_t *cell = _cell(candidates.back());
+        candidates.pop_back();
+        if (!_isPure(cell))
+            continue; // changed by an earlier peel
+
+        if ((std::int64_t) cell[COUNT] == 1)
+            positive.emplace_back(_toZZ(cell + KEY), _toZZ(cell + KEY + keyWords));
+        else
+            negative.emplace_back(_toZZ(cell + KEY), _toZZ(cell + KEY + keyWords));
+        _peel(cell);
+    }
+
+    // If any cell is not empty, then we didn't peel them all.
+    // Empty cells normally hold no value and padding is always zero, so first scan for a nonzero word ...
+    if (allZeroKernel()(cells, numCells * cellWords))
+        return true;
+    // ... and only then look at the cells, in case a received cell is empty but carries a value
+    for (size_t idx = 0; idx < numCells; idx++)
+        if (!_isEmpty(_cell(idx))) return false;
+    return true;
+}
+
+IBLTFlat &IBLTFlat::operator-=(const IBLTFlat &other) {
+    if (valueSize != other.valueSize)
+        Logger::error_and_quit("The value sizes between IBLTs don't match! Ours: "
+                               + toStr(valueSize) + ". Theirs: " + toStr(other.valueSize));
+    if (numCells != other.numCells)
+        Logger::error_and_quit("The IBLT hash table sizes are different! Ours: "
+                               + toStr(numCells) + ". Theirs: " + toStr(other.numCells));
+    if (hashScheme != other.hashScheme)
+        Logger::error_and_quit("The IBLT hash schemes are different!");
+
+    _touch();
+    subtractKernel()(cells, other.cells, numCells, cellWords, keyWords);
+    return *this;
+}
+
+IBLTFlat IBLTFlat::operator-(const IBLTFlat &other) const {
+    IBLTFlat result(*this);
+    result -= other;
+    return result;
+}
+
+size_t IBLTFlat::size() const {
+    return numCells;
+}
+
+size_t IBLTFlat::eltSize() const {
+    return valueSize;
+}
+
+IBLTHashScheme IBLTFlat::getHashScheme() const {
+    return hashScheme;
+}
+
+size_t IBLTFlat::_cellSize(size_t idx) const {
+    const word_t *cell = _cell(idx);
+    size_t res = 2 * WORD_BYTES;
+    for (const word_t *field : {cell + KEY, cell + KEY + keyWords})
+        res += WORD_BYTES + std::max<size_t>(1, significantBytes(field, keyWords));
+    return res;
+}
+
+byte *IBLTFlat::_writeCell(size_t idx, byte *out) const {
+    // |count|, keyCheck, then the key and value as length-prefixed ZZs (see IBLT::toByteVector)
+    const word_t *cell = _cell(idx);
+    auto count = (std::int64_t) cell[COUNT];
+    out = writeWordLE((word_t) (count < 0 ? -count : count), out);
+    out = writeWordLE(cell[CHECK], out);
+
+    byte word[WORD_BYTES];
+    for (const word_t *field : {cell + KEY, cell + KEY + keyWords}) {
+        size_t numBytes = significantBytes(field, keyWords);
+        if (numBytes == 0) numBytes = 1; // special case to send 0 value
+        out = writeWordLE(numBytes, out);
+        for (size_t jj = 0; jj * WORD_BYTES < numBytes; jj++) {
+            size_t len = std::min(WORD_BYTES, numBytes - jj * WORD_BYTES);
+            writeWordLE(field[jj], word);
+            std::memcpy(out, word, len);
+            out += len;
+        }
+    }
+    return out;
+}
+
+vector<byte> IBLTFlat::toByteVector() const {
+    size_t total = 0;
+    for (size_t idx = 0; idx < numCells; idx++)
+        total += _cellSize(idx);
+
+    vector<byte> res(total);
+    byte *out = res.data();
+    for (size_t idx = 0; idx < numCells; idx++)
+        out = _writeCell(idx, out);
+    return res;
+}
+
+void IBLTFlat::fromByteVector(vector<byte> data) {
+    _parseBytes(data.data(), data.size());
+}
+
+void IBLTFlat::_parseBytes(const byte *buf, size_t len) {
+    const byte *end = buf + len;
+    const size_t fieldBytes = keyWords * WORD_BYTES;
+    vector<byte> bytes(fieldBytes);
+    _touch();
+    for (size_t idx = 0; idx < numCells; idx++) {
+        if (buf + 2 * WORD_BYTES > end)
+            Logger::error_and_quit("IBLT byte representation is truncated at entry " + toStr(idx));
+        word_t *cell = _cell(idx);
+        cell[COUNT] = readWordLE(buf);
+        buf += WORD_BYTES;
+        cell[CHECK] = readWordLE(buf);
+        buf += WORD_BYTES;
+
+        for (word_t *field : {cell + KEY, cell + KEY + keyWords}) {
+            if (buf + WORD_BYTES > end)
+                Logger::error_and_quit("IBLT byte representation is truncated at entry " + toStr(idx));
+            auto numBytes = (size_t) readWordLE(buf);
+            buf += WORD_BYTES;
+            if (numBytes > (size_t) (end - buf))
+                Logger::error_and_quit("IBLT byte representation is truncated at entry " + toStr(idx));
+            for (size_t jj = fieldBytes; jj < numBytes; jj++)
+                if (buf[jj] != 0)
+                    Logger::error_and_quit("IBLT entry " + toStr(idx) + " does not fit into value size "
+                                           + toStr(valueSize));
+
+            std::fill(bytes.begin(), bytes.end(), 0);
+            std::memcpy(bytes.data(), buf, std::min(numBytes, fieldBytes));
+            for (size_t jj = 0; jj < keyWords; jj++)
+                field[jj] = readWordLE(bytes.data() + jj * WORD_BYTES);
+            buf += numBytes;
+        }
+    }
+    Logger::gLog(Logger::METHOD_DETAILS, "IBLTFlat parse complete, "
+                                         "read entries: " + toStr(numCells));
+}
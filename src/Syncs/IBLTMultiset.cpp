@@ -9,8 +9,9 @@ IBLTMultiset::IBLTMultiset()
 : valueSize(0){
 }
 
-IBLTMultiset::IBLTMultiset(size_t expectedNumEntries, size_t _valueSize)
+IBLTMultiset::IBLTMultiset(size_t expectedNumEntries, size_t _valueSize, IBLTHashScheme scheme)
         : valueSize(_valueSize) {
+    hashScheme = scheme;
     // atleast 2x expectedNumEntries
     size_t nEntries = expectedNumEntries * 2 ;
     // ... make nEntries exactly divisible by N_HASH
@@ -40,19 +41,23 @@ hash_t addModHash(hash_t x, hash_t y ) {
     return res;
 }
 
-void IBLTMultiset::_insertModular(long plusOrMinus, const ZZ &key, const ZZ& value) {
+void IBLTMultiset::_insertModular(long plusOrMinus, const ZZ &key, const ZZ& value, long *cells) {
     long bucketsPerHash = hashTable.size() / N_HASH;
 
     if(sizeof(value) != valueSize)
         Logger::error_and_quit("The value being inserted is different than the IBLT value size! value size: "
                                + toStr(sizeof(value)) + ". IBLT value size: " + toStr(valueSize));
 
+    hash_t hashes[N_HASH + 1];
+    _hashes(key, hashScheme, hashes);
+    hash_t modHashCheck = hashes[N_HASH] % LARGE_PRIME;
+
     for(int ii=0; ii < N_HASH; ii++){
-        hash_t hk = _hashK(key, ii);
+        hash_t hk = hashes[ii];
         long startEntry = ii * bucketsPerHash;
-        long pos = startEntry + (hk%bucketsPerHash);
         IBLTMultiset::HashTableEntry& entry = hashTable.at(startEntry + (hk%bucketsPerHash));
-        hash_t modHashCheck = _hashK(key, N_HASHCHECK) % LARGE_PRIME;
+        if (cells != nullptr)
+            cells[ii] = startEntry + (hk%bucketsPerHash);
 
         entry.count += plusOrMinus;
         entry.keySum += plusOrMinus*key;
@@ -79,51 +84,107 @@ void IBLTMultiset::erase(ZZ key, ZZ value) {
     _insertModular(-1, key, value);
 }
 
+void IBLTMultiset::bulkInsert(vector<shared_ptr<DataObject>>::const_iterator begin,
+                              vector<shared_ptr<DataObject>>::const_iterator end, size_t numThreads) {
+    size_t numElems = end - begin;
+    numThreads = numWorkers(numThreads, numElems, MIN_BULK_PER_THREAD);
+
+    // each thread fills a partial table with the same shape as this one ...
+    IBLTMultiset empty;
+    empty.valueSize = valueSize;
+    empty.hashScheme = hashScheme;
+    empty.hashTable.resize(hashTable.size());
+    vector<IBLTMultiset> partials(numThreads, empty);
+    parallelFor(numElems, numThreads, [&](size_t first, size_t last, size_t slice) {
+        for (size_t ii = first; ii < last; ii++) {
+            ZZ elt = begin[ii]->to_ZZ();
+            partials[slice]._insertModular(1, elt, elt);
+        }
+    });
+
+    // ... and then each thread merges a slice of the cells from all partial tables
+    parallelFor(hashTable.size(), numThreads, [&](size_t first, size_t last, size_t) {
+        for (size_t ii = first; ii < last; ii++) {
+            IBLTMultiset::HashTableEntry &entry = hashTable[ii];
+            for (const IBLTMultiset &partial : partials) {
+                const IBLTMultiset::HashTableEntry &other = partial.hashTable[ii];
+                if (other.empty())
+                    continue;
+                entry.count += other.count;
+                entry.keySum += other.keySum;
+                entry.keyCheck = addModHash(entry.keyCheck, other.keyCheck);
+                if (entry.empty())
+                    entry.valueSum.kill();
+                else
+                    entry.valueSum += other.valueSum;
+            }
+        }
+    });
+}
 
 bool IBLTMultiset::get(ZZ key, ZZ& result){
     long bucketsPerHash = hashTable.size()/N_HASH;
+    hash_t hashes[N_HASH + 1];
+    _hashes(key, hashScheme, hashes);
     for (long ii = 0; ii < N_HASH; ii++) {
         long startEntry = ii*bucketsPerHash;
-        unsigned long hk = _hashK(key, ii);
+        unsigned long hk = hashes[ii];
         const IBLTMultiset::HashTableEntry& entry = hashTable[startEntry + (hk%bucketsPerHash)];
 
         if (entry.empty()) {
             // Definitely not in table. Leave
             // result empty, return true.
             return true;
-        } else if(entry.isPure()) {
+        } else if(entry.isPure(hashScheme)) {
             result = entry.valueSum / entry.count;
             return true;
         }
     }
 
     // Don't know if k is in table or not; "peel" the IBLT to try to find it:
-    long nErased;
-    do {
-        nErased = 0;
-        for (IBLTMultiset::HashTableEntry &entry : this->hashTable) {
-            if (entry.isPure()) {
-                if ( entry.keySum/entry.count == key) {
-                    result = entry.valueSum/entry.count;
-                    return true;
-                }
-
-                this->_insertModular(-entry.count / abs(entry.count), entry.keySum / entry.count, entry.valueSum / entry.count);
-                ++nErased;
-            }
+    vector<long> candidates = _pureCells();
+    while (!candidates.empty()) {
+        IBLTMultiset::HashTableEntry &entry = hashTable[candidates.back()];
+        candidates.pop_back();
+        if (!entry.isPure(hashScheme))
+            continue; // changed by an earlier peel
+
+        if ( entry.keySum/entry.count == key) {
+            result = entry.valueSum/entry.count;
+            return true;
         }
-    } while (nErased > 0);
+        _peel(entry, candidates);
+    }
 
     return false;
 }
 
-bool IBLTMultiset::HashTableEntry::isPure() const {
+vector<long> IBLTMultiset::_pureCells() const {
+    vector<long> pure;
+    for (long ii = 0; ii < (long) hashTable.size(); ii++)
+        if (hashTable[ii].isPure(hashScheme))
+            pure.push_back(ii);
+    return pure;
+}
+
+void IBLTMultiset::_peel(IBLTMultiset::HashTableEntry &entry, vector<long> &candidates) {
+    long cells[N_HASH];
+    _insertModular(-entry.count / abs(entry.count), entry.keySum / entry.count, entry.valueSum / entry.count, cells);
+
+    // only the cells that were just updated can have changed purity; a cell holding
+    // several copies of one key stays pure, so candidates are not filtered by count
+    for (long cell : cells)
+        if (hashTable[cell].count != 0)
+            candidates.push_back(cell);
+}
+
+bool IBLTMultiset::HashTableEntry::isPure(IBLTHashScheme scheme) const {
     if (count != 0 && keySum!=0) {
-        long absCount = abs(count);
+        size_t absCount = abs(count);
         long plusOrMinus = conv<long>(keySum / abs(keySum));
-        hash_t singleCountHash = _hashK(keySum / count, N_HASHCHECK) % LARGE_PRIME;
-        long check = 0;
-        int ii = 0;
+        hash_t singleCountHash = _hashK(keySum / count, N_HASHCHECK, scheme) % LARGE_PRIME;
+        hash_t check = 0;
+        size_t ii = 0;
         while (ii < absCount) {
             if(plusOrMinus == 1)
                 check = addModHash(check, singleCountHash);
@@ -138,25 +199,24 @@ bool IBLTMultiset::HashTableEntry::isPure() const {
 }
 
 bool IBLTMultiset::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative){
-    long nErased;
-    do {
-        nErased = 0;
-        for(IBLTMultiset::HashTableEntry& entry : this->hashTable) {
-            if (entry.isPure()) {
-                if (entry.count >= 1) {
-                    positive.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
-                } else if (entry.count <= -1) {
-                    negative.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
-                } else {
-                    Logger::error_and_quit("Unreachable state. Entry with count zero in IBLT.");
-                    return false;
-                }
-                this->_insertModular(-entry.count / abs(entry.count), entry.keySum / entry.count, entry.valueSum / entry.count);
-
-                ++nErased;
-            }
+    // peel pure cells, revisiting only the cells touched by each peel
+    vector<long> candidates = _pureCells();
+    while (!candidates.empty()) {
+        IBLTMultiset::HashTableEntry &entry = hashTable[candidates.back()];
+        candidates.pop_back();
+        if (!entry.isPure(hashScheme))
+            continue; // changed by an earlier peel
+
+        if (entry.count >= 1) {
+            positive.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
+        } else if (entry.count <= -1) {
+            negative.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
+        } else {
+            Logger::error_and_quit("Unreachable state. Entry with count zero in IBLT.");
+            return false;
         }
-    } while (nErased > 0);
+        _peel(entry, candidates);
+    }
 
     // If any buckets for one of the hash functions is not empty,
     // then we didn't peel them all:
@@ -174,6 +234,8 @@ IBLTMultiset &IBLTMultiset::operator-=(const IBLTMultiset &other) {
     if (hashTable.size() != other.hashTable.size())
         Logger::error_and_quit("The IBLT hash table sizes are different! Ours: "
                                + toStr(hashTable.size()) + ". Theirs: " + toStr(other.valueSize));
+    if (hashScheme != other.hashScheme)
+        Logger::error_and_quit("The IBLT hash schemes are different!");
 
     for (unsigned long ii = 0; ii < hashTable.size(); ii++) {
         IBLTMultiset::HashTableEntry &e1 = this->hashTable.at(ii);
@@ -206,35 +268,47 @@ size_t IBLTMultiset::eltSize() const {
     return valueSize;
 }
 
+size_t IBLTMultiset::_cellSize(size_t idx) const {
+    const IBLTMultiset::HashTableEntry &entry = hashTable[idx];
+    return sizeof(long) + sizeof(hash_t) + serialSizeZZ(entry.keySum) + serialSizeZZ(entry.valueSum);
+}
+
+byte *IBLTMultiset::_writeCell(size_t idx, byte *out) const {
+    const IBLTMultiset::HashTableEntry &entry = hashTable[idx];
+    out = writeWordLE((std::uint64_t) std::labs(entry.count), out);
+    out = writeWordLE(entry.keyCheck, out);
+    out = writeBytesZZ(entry.keySum, out);
+    return writeBytesZZ(entry.valueSum, out);
+}
+
 vector<byte> IBLTMultiset::toByteVector() const {
-    vector<byte> res;
-    for (auto entry: hashTable) {
-        vector<byte> byteRep = toBytes(entry.count);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes(entry.keyCheck);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes(entry.keySum);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-        byteRep = toBytes(entry.valueSum);
-        res.insert(res.end(), byteRep.begin(), byteRep.end());
-    }
+    size_t total = 0;
+    for (size_t idx = 0; idx < hashTable.size(); idx++)
+        total += _cellSize(idx);
+
+    vector<byte> res(total);
+    byte *out = res.data();
+    for (size_t idx = 0; idx < hashTable.size(); idx++)
+        out = _writeCell(idx, out);
     return res;
 }
 
 void IBLTMultiset::fromByteVector(vector<byte> data) {
-    vector<byte> res;
-    byte *buf = data.data();
-    for (long index = 0; index < hashTable.size(); index++) {
-        hashTable[index].count = fromBytes<long>(buf);
-        buf += sizeof(long);
-        hashTable[index].keyCheck = fromBytes<hash_t>(buf);
+    _parseBytes(data.data(), data.size());
+}
+
+void IBLTMultiset::_parseBytes(const byte *buf, size_t) {
+    for (size_t index = 0; index < hashTable.size(); index++) {
+        hashTable[index].count = (long) readWordLE(buf);
         buf += sizeof(long);
+        hashTable[index].keyCheck = readWordLE(buf);
+        buf += sizeof(hash_t);
         long bytesRead;
         hashTable[index].keySum = fromBytesZZ(buf, bytesRead);
         buf += bytesRead;
         hashTable[index].valueSum = fromBytesZZ(buf, bytesRead);
         buf += bytesRead;
     }
-    Logger::gLog(Logger::METHOD_DETAILS, "IBLTMultiset fromByteVectorComplete");
+    Logger::gLog(Logger::METHOD_DETAILS, "IBLTMultiset parse complete");
 }
 
@@ -16,9 +16,10 @@
  * @param eltSize size of a child IBLT after serialization
  * @param chldSize Upper bound for # elements in a child set
  * @param innerSize size of a inner element in a child set
+ * @param scheme hash family of the outer and child IBLTs
  * */
 
-IBLTSetOfSets::IBLTSetOfSets(size_t expected, size_t chldSize, size_t innerSize) : myIBLT(expected, sizeof(ZZ))
+IBLTSetOfSets::IBLTSetOfSets(size_t expected, size_t chldSize, size_t innerSize, IBLTHashScheme scheme) : myIBLT(expected, sizeof(ZZ), scheme)
 {
     Logger::gLog(Logger::METHOD, "Entering IBLTSetOfSets::IBLTSetOfSets");
     expNumElems = expected;
@@ -47,7 +48,7 @@ bool IBLTSetOfSets::SyncClient(const shared_ptr<Communicant> &commSync, list<sha
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if (!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay))
+        if (!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay, myIBLT.getHashScheme()))
         {
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
@@ -148,7 +149,7 @@ bool IBLTSetOfSets::SyncServer(const shared_ptr<Communicant> &commSync, list<sha
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if (!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay))
+        if (!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay, myIBLT.getHashScheme()))
         {
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
@@ -156,7 +157,7 @@ bool IBLTSetOfSets::SyncServer(const shared_ptr<Communicant> &commSync, list<sha
         }
         // verified that our size and eltSize == theirs
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        IBLT theirs = commSync->commRecv_IBLTNHash(myIBLT.size(), myIBLT.eltSize());
+        IBLT theirs = commSync->commRecv_IBLTNHash(myIBLT.size(), myIBLT.eltSize(), myIBLT.getHashScheme());
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
         // positiveChld -> pairs {chldIBLT, hash} for Ea/Eb, containing all childsets with unique hashes on client but not server
@@ -314,7 +315,7 @@ pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> IBLTSetOfSets::_
         size_t MIN = SIZE_MAX;
         // rebuild Ta in Ea/Eb from string
         string info = zzToString(itr.first);
-        IBLT II(childSize, elemSize);
+        IBLT II(childSize, elemSize, myIBLT.getHashScheme());
         II.reBuild(info);
 
         // for storing missing elements in the child set
@@ -330,7 +331,7 @@ pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> IBLTSetOfSets::_
         {
             // rebuild Tb in Eb/Ea from string
             string infoJ = zzToString(itrJ.first);
-            IBLT JJ(childSize, elemSize);
+            IBLT JJ(childSize, elemSize, myIBLT.getHashScheme());
             JJ.reBuild(infoJ);
 
             vector<pair<ZZ, ZZ>> curPos, curNeg;
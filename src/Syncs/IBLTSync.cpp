@@ -7,13 +7,172 @@
 #include <CPISync/Aux/Exceptions.h>
 #include <CPISync/Syncs/IBLTSync.h>
 
-IBLTSync::IBLTSync(size_t expected, size_t eltSize) : myIBLT(expected, eltSize) {
+namespace {
+    // receive an IBLT of the same kind as like, which has the size the peer's should have
+    IBLT recvIBLT(const shared_ptr<Communicant> &commSync, const IBLT &like) {
+        return commSync->commRecv_IBLT(like.size(), like.eltSize(), like.getHashScheme());
+    }
+
+    IBLTFlat recvIBLT(const shared_ptr<Communicant> &commSync, const IBLTFlat &like) {
+        return commSync->commRecv_IBLTFlat(like.size(), like.eltSize(), like.getHashScheme());
+    }
+}
+
+IBLTSync::IBLTSync(size_t expected, size_t eltSize, IBLTHashScheme scheme, bool estimate, size_t retries, bool flat,
+                   const string &snapshotFile)
+        : myIBLT(flat || !snapshotFile.empty() ? 0 : expected, eltSize, scheme), snapshotFile(snapshotFile) {
+    if (!snapshotFile.empty()) {
+        myFlat = make_shared<IBLTFlat>(snapshotFile, expected, eltSize, scheme);
+        replaying = myFlat->resumed();
+    } else if (flat)
+        myFlat = make_shared<IBLTFlat>(expected, eltSize, scheme);
     expNumElems = expected;
+    maxRetries = retries;
     oneWay = false;
+    if (estimate)
+        myEstimator = make_shared<StrataEstimator>(eltSize, scheme);
+}
+
+void IBLTSync::_sizeFor(size_t diff) {
+    // the IBLT's own 1.5x cells cover the estimator's error, so the estimate is only rounded up, to the next of
+    // 16, 24, 32, 48, 64, ..., so that similar estimates land on the table we already keep
+    size_t expected = MIN_ESTIMATED_ELEMS;
+    while (expected < diff)
+        expected = (expected & (expected - 1)) == 0 ? expected / 2 * 3 : expected / 3 * 4;
+    Logger::gLog(Logger::METHOD_DETAILS, "IBLTSync: estimated difference " + toStr(diff)
+                                         + ", sizing the IBLT for " + toStr(expected) + " elements");
+
+    // addElem and delElem keep the table current, so only a new size needs a pass over the elements
+    if (expected == expNumElems)
+        return;
+    expNumElems = expected;
+    if (!snapshotFile.empty()) {
+        myFlat.reset(); // flushes the file before it is reopened
+        myFlat = make_shared<IBLTFlat>(snapshotFile, expected, myIBLT.eltSize(), myIBLT.getHashScheme());
+        if (!myFlat->resumed())
+            myFlat->bulkInsert(beginElements(), endElements());
+    } else if (myFlat)
+        *myFlat = _buildIBLT<IBLTFlat>(expected);
+    else
+        myIBLT = _buildIBLT<IBLT>(expected);
+}
+
+template <class Table>
+Table IBLTSync::_buildIBLT(size_t expected) {
+    Table res(expected, myIBLT.eltSize(), myIBLT.getHashScheme());
+    res.bulkInsert(beginElements(), endElements());
+    return res;
+}
+
+size_t IBLTSync::_retrySize(size_t expected) {
+    return expected * 2 < MIN_ESTIMATED_ELEMS ? MIN_ESTIMATED_ELEMS : expected * 2;
 }
 
 IBLTSync::~IBLTSync() = default;
 
+bool IBLTSync::resumed() const {
+    return myFlat && myFlat->resumed();
+}
+
+void IBLTSync::endReplay() {
+    replaying = false;
+}
+
+template <class Table>
+bool IBLTSync::_sendIBLTs(const shared_ptr<Communicant>& commSync, const Table &mine) {
+    // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
+    mySyncStats.timerStart(SyncStats::COMM_TIME);
+    if(!commSync->establishIBLTSend(mine.size(), mine.eltSize(), oneWay, mine.getHashScheme())) {
+        Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        return false;
+    }
+
+    commSync->commSend(mine, true);
+
+    // as long as the server fails to decode, send it IBLTs with twice as many cells
+    size_t expected = expNumElems;
+    for (size_t round = 0; !oneWay && round < maxRetries; round++) {
+        if (commSync->commRecv_byte() != SYNC_FAIL_FLAG)
+            break;
+        expected = _retrySize(expected);
+        Logger::gLog(Logger::METHOD_DETAILS, "IBLTSync: server could not decode; resending an IBLT for "
+                                             + toStr(expected) + " elements");
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        Table larger = _buildIBLT<Table>(expected);
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        commSync->commSend(larger, true);
+    }
+    mySyncStats.timerEnd(SyncStats::COMM_TIME);
+    return true;
+}
+
+template <class Table>
+bool IBLTSync::_decodeIBLTs(const shared_ptr<Communicant>& commSync, const Table &mine,
+                            vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative, bool &decoded) {
+    mySyncStats.timerStart(SyncStats::COMM_TIME);
+    // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
+    if(!commSync->establishIBLTRecv(mine.size(), mine.eltSize(), oneWay, mine.getHashScheme())) {
+        Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        return false;
+    }
+
+    // verified that our size and eltSize == theirs
+    Table theirs = recvIBLT(commSync, mine);
+    mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+    mySyncStats.timerStart(SyncStats::COMP_TIME);
+    // more efficient than - and modifies theirs, which we don't care about
+    const Table *current = &mine;
+    Table larger(0, mine.eltSize(), mine.getHashScheme());
+    size_t expected = expNumElems;
+    for (size_t round = 0; ; round++) {
+        theirs -= *current;
+        // take out the differences decoded in earlier rounds, leaving only the rest to peel
+        for (const auto &pair : positive)
+            theirs.erase(pair.first, pair.second);
+        for (const auto &pair : negative)
+            theirs.insert(pair.first, pair.second);
+
+        decoded = theirs.listEntries(positive, negative);
+        if (decoded || oneWay || round == maxRetries) {
+            if (!oneWay && round < maxRetries) {
+                mySyncStats.timerEnd(SyncStats::COMP_TIME);
+                mySyncStats.timerStart(SyncStats::COMM_TIME);
+                commSync->commSend(SYNC_OK_FLAG);
+                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                return true;
+            }
+            break;
+        }
+
+        // ask the client for an IBLT with twice as many cells, and build ours to match
+        expected = _retrySize(expected);
+        Logger::gLog(Logger::METHOD_DETAILS, "IBLTSync: decoded " + toStr(positive.size() + negative.size())
+                                             + " differences so far; retrying with an IBLT for "
+                                             + toStr(expected) + " elements");
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        commSync->commSend(SYNC_FAIL_FLAG);
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        larger = _buildIBLT<Table>(expected);
+        current = &larger;
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        theirs = recvIBLT(commSync, larger);
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+    }
+    mySyncStats.timerEnd(SyncStats::COMP_TIME);
+    return true;
+}
+
 bool IBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf){
     try {
 
@@ -23,26 +182,31 @@ bool IBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_p
 
         // call parent method for bookkeeping
         SyncMethod::SyncClient(commSync, selfMinusOther, otherMinusSelf);
+        endReplay(); // whatever was added before the first sync was the replay
 
         // connect to server
         mySyncStats.timerStart(SyncStats::IDLE_TIME);
         commSync->commConnect();
         mySyncStats.timerEnd(SyncStats::IDLE_TIME);
 
-
-        // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
-            Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
+        // let the server estimate the difference, and size the IBLT as it decides
+        if (myEstimator) {
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            commSync->commSend(*myEstimator);
+            auto diff = (size_t) commSync->commRecv_long();
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMP_TIME);
+            _sizeFor(diff);
+            mySyncStats.timerEnd(SyncStats::COMP_TIME);
+        }
+
+        if (!(myFlat ? _sendIBLTs(commSync, *myFlat) : _sendIBLTs(commSync, myIBLT))) {
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
             mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
             return false;
         }
 
-        commSync->commSend(myIBLT, true);
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
-
 
         if(!oneWay) {
             mySyncStats.timerStart(SyncStats::COMM_TIME);
@@ -81,38 +245,45 @@ bool IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_p
 
         // call parent method for bookkeeping
         SyncMethod::SyncServer(commSync, selfMinusOther, otherMinusSelf);
+        endReplay(); // whatever was added before the first sync was the replay
 
         // listen for client
         mySyncStats.timerStart(SyncStats::IDLE_TIME);
         commSync->commListen();
         mySyncStats.timerEnd(SyncStats::IDLE_TIME);
 
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
-        // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
-        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
-            Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
+        // estimate the difference from the client's estimator, and tell the client
+        if (myEstimator) {
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            StrataEstimator theirEstimator = commSync->commRecv_StrataEstimator(myIBLT.eltSize(),
+                                                                                myIBLT.getHashScheme());
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMP_TIME);
+            size_t diff = myEstimator->estimate(theirEstimator);
+            _sizeFor(diff);
+            mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            commSync->commSend((long) diff);
+            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        }
+        vector<pair<ZZ, ZZ>> positive, negative;
+        bool decoded;
+        if (!(myFlat ? _decodeIBLTs(commSync, *myFlat, positive, negative, decoded)
+                     : _decodeIBLTs(commSync, myIBLT, positive, negative, decoded))) {
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
             mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
             return false;
         }
-
-        // verified that our size and eltSize == theirs
-        IBLT theirs = commSync->commRecv_IBLT(myIBLT.size(), myIBLT.eltSize());
-
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
-
-
-        mySyncStats.timerStart(SyncStats::COMP_TIME);
-        // more efficient than - and modifies theirs, which we don't care about
-        vector<pair<ZZ, ZZ>> positive, negative;
-        if(!(theirs -= myIBLT).listEntries(positive, negative)) {
+        if (!decoded) {
             Logger::gLog(Logger::METHOD_DETAILS,
                          "Unable to completely reconcile, returning a partial list of differences");
             success = false;
         }
 
         // store values because they're what we care about
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
         for(const auto& pair : positive) {
             otherMinusSelf.push_back(make_shared<DataObject>(pair.second));
         }
@@ -149,13 +320,36 @@ bool IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_p
 bool IBLTSync::addElem(shared_ptr<DataObject> datum){
     // call parent add
     SyncMethod::addElem(datum);
-    myIBLT.insert(datum->to_ZZ(), datum->to_ZZ());
+    if (!myFlat)
+        myIBLT.insert(datum->to_ZZ(), datum->to_ZZ());
+    else if (!replaying) // a resumed IBLT already holds the elements being replayed
+        myFlat->insert(datum->to_ZZ(), datum->to_ZZ());
+    if (myEstimator)
+        myEstimator->insert(datum->to_ZZ());
+    return true;
+}
+bool IBLTSync::addElems(const vector<shared_ptr<DataObject>> &data){
+    // call parent add for each element, and build the IBLT in bulk
+    for (const auto &datum : data)
+        SyncMethod::addElem(datum);
+    if (!myFlat)
+        myIBLT.bulkInsert(data.begin(), data.end());
+    else if (!replaying) // a resumed IBLT already holds the elements being replayed
+        myFlat->bulkInsert(data.begin(), data.end());
+    if (myEstimator)
+        for (const auto &datum : data)
+            myEstimator->insert(datum->to_ZZ());
     return true;
 }
 bool IBLTSync::delElem(shared_ptr<DataObject> datum){
     // call parent delete
     SyncMethod::delElem(datum);
-    myIBLT.erase(datum->to_ZZ(), datum->to_ZZ());
+    if (myFlat)
+        myFlat->erase(datum->to_ZZ(), datum->to_ZZ());
+    else
+        myIBLT.erase(datum->to_ZZ(), datum->to_ZZ());
+    if (myEstimator)
+        myEstimator->erase(datum->to_ZZ());
     return true;
 }
 string IBLTSync::getName(){ return "IBLTSync\n   * expected number of elements = " + toStr(expNumElems) + "\n   * size of values =  " + toStr(myIBLT.eltSize()) + '\n';}
\ No newline at end of file
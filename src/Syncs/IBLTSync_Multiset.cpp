@@ -5,7 +5,7 @@
 #include <CPISync/Aux/Exceptions.h>
 #include <CPISync/Syncs/IBLTSync_Multiset.h>
 
-IBLTSync_Multiset::IBLTSync_Multiset(size_t expected, size_t eltSize): myIBLT(expected, eltSize) {
+IBLTSync_Multiset::IBLTSync_Multiset(size_t expected, size_t eltSize, IBLTHashScheme scheme): myIBLT(expected, eltSize, scheme) {
     expNumElems = expected;
     oneWay = false;
 }
@@ -27,7 +27,7 @@ bool IBLTSync_Multiset::SyncClient(const shared_ptr<Communicant>& commSync, list
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay, myIBLT.getHashScheme())) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -84,7 +84,7 @@ bool IBLTSync_Multiset::SyncServer(const shared_ptr<Communicant>& commSync, list
 
         mySyncStats.timerStart(SyncStats::COMM_TIME);
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
-        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay, myIBLT.getHashScheme())) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -94,7 +94,8 @@ bool IBLTSync_Multiset::SyncServer(const shared_ptr<Communicant>& commSync, list
 
         // verified that our size and eltSize == theirs
         IBLTMultiset theirs = commSync->commRecv_IBLTMultiset(myIBLT.size(),
-                                                                  myIBLT.eltSize());
+                                                                  myIBLT.eltSize(),
+                                                                  myIBLT.getHashScheme());
 
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
@@ -149,6 +150,13 @@ bool IBLTSync_Multiset::addElem(shared_ptr<DataObject> datum){
     myIBLT.insert(datum->to_ZZ(), datum->to_ZZ());
     return true;
 }
+bool IBLTSync_Multiset::addElems(const vector<shared_ptr<DataObject>> &data){
+    // call parent add for each element, and build the IBLT in bulk
+    for (const auto &datum : data)
+        SyncMethod::addElem(datum);
+    myIBLT.bulkInsert(data.begin(), data.end());
+    return true;
+}
 bool IBLTSync_Multiset::delElem(shared_ptr<DataObject> datum){
     // call parent delete
     SyncMethod::delElem(datum);
@@ -7,12 +7,47 @@
  * Created on November 30, 2011, 10:46 PM
  */
 
+#include <exception>
 #include <CPISync/Aux/Auxiliary.h>
 #include <CPISync/Communicants/Communicant.h>
 #include <CPISync/Aux/Exceptions.h>
 #include <CPISync/Syncs/CPISync.h>
 #include <CPISync/Syncs/InterCPISync.h>
 
+namespace {
+	// the server's verdict on each node of a level, when synchronizing breadth-first
+	const byte NODE_EMPTY = SYNC_NO_INFO;     // neither side has elements in the node
+	const byte CLIENT_EMPTY = SYNC_SOME_INFO; // only the server has elements; it sends them all
+	const byte SERVER_EMPTY = 4;              // only the client has elements; it sends them all with the next level
+	const byte NODE_SYNCED = SYNC_OK_FLAG;    // the node synchronized; the differing hashes follow
+	const byte NODE_FAILED = SYNC_FAIL_FLAG;  // the node failed to synchronize; its children join the next level
+
+	// Releases, on destruction, the nodes added to an arena since construction, i.e. those made during a synchronization
+	class NodeMark {
+	public:
+		explicit NodeMark(std::deque<pTree> &arena) : arena(arena), mark(arena.size()) {}
+		~NodeMark() {
+			while (arena.size() > mark)
+				arena.pop_back();
+		}
+	private:
+		std::deque<pTree> &arena;
+		size_t mark;
+	};
+
+	// @return true iff the node holds no elements
+	bool emptyNode(pTree *node) {
+		return node == nullptr || node->getDatum()->getNumElem() == 0;
+	}
+
+	// Adds the bytes sent and received over comm since its counters were last reset to stats, and resets them
+	void countBytes(const shared_ptr<Communicant> &comm, SyncMethod::SyncStats &stats) {
+		stats.increment(SyncMethod::SyncStats::XMIT, comm->getXmitBytes());
+		stats.increment(SyncMethod::SyncStats::RECV, comm->getRecvBytes());
+		comm->resetCommCounters();
+	}
+}
+
 InterCPISync::InterCPISync(long m_bar, long bits, int epsilon, int partition,bool Hashes /* = false*/)
 : maxDiff(m_bar), bitNum(bits), pFactor(partition), hashes(Hashes),
 	probEps(conv<int>(ceil(-log10((RR_ONE - pow(RR_ONE - pow(RR_TWO,(RR) -epsilon),RR_ONE/ (RR_ONE+ pow(RR_TWO,(RR) bits) *
@@ -37,15 +72,14 @@ InterCPISync::InterCPISync(long m_bar, long bits, int epsilon, int partition,boo
 	ZZ fieldSize = NextPrime(DATA_MAX + maxDiff + redundant_k);
 	ZZ_p::init(fieldSize);
 
+	nodeParams.reset(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes));
 	treeNode = nullptr;
 	useExisting=false;
+	breadthFirst=false;
 	SyncID = SYNC_TYPE::Interactive_CPISync; // the synchronization type
 }
 
-InterCPISync::~InterCPISync() {
-	// clean out the CPISync tree
-	_deleteTree(treeNode);
-}
+InterCPISync::~InterCPISync() = default; // the node arena deletes the CPISync tree
 
 
 bool InterCPISync::delElem(shared_ptr<DataObject> datum) {
@@ -65,32 +99,38 @@ bool InterCPISync::delElem(shared_ptr<DataObject> datum) {
 		//If the parent node contains an empty set then clear
 		if(treeNode->getDatum()->getNumElem() == 0) {
 			treeNode = nullptr;
+			nodeArena.clear();
 		}
 		return success;
 	}
 }
 
 bool InterCPISync::addElem(shared_ptr<DataObject> newDatum) {
-	/* recursively add an element to all appropriate nodes until:
-	* 1.  We reach a leaf node with <m_bar entries.
-	* 2.  We reach a node with range < m_bar
-	* Assuming there are no hash collisions, we should always end at one
-	* of these two options.  Otherwise, we report an error by returning false.
-	*/
+	/* add the element to the root only.  The rest of the tree is materialized lazily:  the children of a node are
+	 * made, and filled from its elements, only when a synchronization fails at the node and must recurse.
+	 */
 
 	Logger::gLog(Logger::METHOD,"Entering InterCPISync::AddElem");
 	if (!SyncMethod::addElem(newDatum)) return false; //Run parents version
 
-	addElemHashID = rep(_hash(newDatum)); // compute the hash of the item for use in the recursive addElem
-
-	Logger::gLog(Logger::METHOD_DETAILS, ". (InterCPISync) adding item " + newDatum->print() + " with representation = " + toStr(addElemHashID)); // log the action
+	Logger::gLog(Logger::METHOD_DETAILS, ". (InterCPISync) adding item " + newDatum->print() + " with representation = " + toStr(rep(_hash(newDatum)))); // log the action
 
 	if(treeNode == nullptr)
-		treeNode = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes), pFactor);
+		treeNode = _newNode();
 
 	CPISync *curr = treeNode->getDatum();
 	return curr->addElem(newDatum);
-	//  return addElem(newDatum, treeNode, NULL, ZZ_ZERO, DATA_MAX); // use the recursive helper method
+}
+
+bool InterCPISync::addElems(const vector<shared_ptr<DataObject>> &data) {
+	Logger::gLog(Logger::METHOD,"Entering InterCPISync::addElems");
+	bool result = true;
+	for (const auto &datum : data)
+		result = SyncMethod::addElem(datum) && result;
+
+	if(treeNode == nullptr)
+		treeNode = _newNode();
+	return treeNode->getDatum()->addElems(data) && result;
 }
 
 bool InterCPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>>& selfMinusOther, list<shared_ptr<DataObject>>& otherMinusSelf) {
@@ -108,10 +148,14 @@ bool InterCPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shar
     mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
     // 1. Do the sync
+    NodeMark syncNodes(nodeArena); // the children made while synchronizing are only needed until it is done
     pTree *parentNode = treeNode;//Create a copy of the root node - Just to make sure that it is not deleted
     commSync->hardResetCommCounters(); //Because each CPISync will reset the communicant stats need to reset and use the "total" fields
+    exchanges = 0;
     bool result = SyncMethod::SyncClient(commSync, selfMinusOther, otherMinusSelf) // also call the parent to establish bookkeeping variables
-                  && _SyncClient(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX);//Call the modified Sync with data Ranges
+                  && (breadthFirst ?
+                      _SyncClientBreadthFirst(commSync, selfMinusOther, otherMinusSelf, mySyncStats) :
+                      _SyncClient(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX, mySyncStats, subtreeComms));//Call the modified Sync with data Ranges
 
     if (result) { // Sync succeeded
         Logger::gLog(Logger::METHOD, string("Interactive sync succeeded.\n")
@@ -141,6 +185,8 @@ void InterCPISync::SendSyncParam(const shared_ptr<Communicant>& commSync, bool o
     commSync->commSend(bitNum);
     commSync->commSend(probEps);
     commSync->commSend(pFactor);
+    commSync->commSend((long) subtreeComms.size());
+    commSync->commSend((byte) breadthFirst);
 
     if (commSync->commRecv_byte() == SYNC_FAIL_FLAG) throw SyncFailureException("Sync parameters do not match.");
 
@@ -158,13 +204,16 @@ void InterCPISync::RecvSyncParam(const shared_ptr<Communicant>& commSync, bool o
     long bitsClient = commSync->commRecv_long();
     int epsilonClient = commSync->commRecv_int();
     long pFactorClient = commSync->commRecv_long();
+    long subtreeCommsClient = commSync->commRecv_long();
+    bool breadthFirstClient = commSync->commRecv_byte() != 0;
 
-    if (theSyncID != enumToByte(SyncID) || mbarClient != maxDiff || bitsClient != bitNum || epsilonClient != probEps || pFactor != pFactorClient) {
+    if (theSyncID != enumToByte(SyncID) || mbarClient != maxDiff || bitsClient != bitNum || epsilonClient != probEps || pFactor != pFactorClient
+        || subtreeCommsClient != (long) subtreeComms.size() || breadthFirstClient != breadthFirst) {
         // report a failure to establish sync parameters
         commSync->commSend(SYNC_FAIL_FLAG);
         Logger::gLog(Logger::COMM, "Sync parameters differ from client to server: Client has (" +
-                                   toStr(mbarClient) + "," + toStr(bitsClient) + "," + toStr(epsilonClient) + "," + toStr(pFactorClient) +
-                                   ").  Server has (" + toStr(maxDiff) + "," + toStr(bitNum) + "," + toStr(probEps) + "," + toStr(pFactor) + ").");
+                                   toStr(mbarClient) + "," + toStr(bitsClient) + "," + toStr(epsilonClient) + "," + toStr(pFactorClient) + "," + toStr(subtreeCommsClient) + "," + toStr(breadthFirstClient) +
+                                   ").  Server has (" + toStr(maxDiff) + "," + toStr(bitNum) + "," + toStr(probEps) + "," + toStr(pFactor) + "," + toStr(subtreeComms.size()) + "," + toStr(breadthFirst) + ").");
         throw SyncFailureException("Sync parameters do not match.");
     }
     commSync->commSend(SYNC_OK_FLAG);
@@ -188,9 +237,13 @@ bool InterCPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shar
     mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
     // 1. Do the sync
+    NodeMark syncNodes(nodeArena); // the children made while synchronizing are only needed until it is done
     pTree * parentNode = treeNode;
     commSync->hardResetCommCounters(); //Because each CPISync will reset the communicant stats need to reset and use the "total" fields
-    result &= _SyncServer(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX);
+    exchanges = 0;
+    result &= breadthFirst ?
+              _SyncServerBreadthFirst(commSync, selfMinusOther, otherMinusSelf, mySyncStats) :
+              _SyncServer(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX, mySyncStats, subtreeComms);
     if (result) { // Sync succeeded
         Logger::gLog(Logger::METHOD, string("Interactive sync succeeded.\n")
                                      + "   self - other =  " + printListOfSharedPtrs(selfMinusOther) + "\n"
@@ -208,16 +261,10 @@ bool InterCPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shar
 }
 
 //Private
-void InterCPISync::_deleteTree(pTree *treeNode){
-    Logger::gLog(Logger::METHOD,"Entering InterCPISync::deleteTree");
-    if (treeNode == nullptr)
-        return; // i.e. nothing to do
-    else {
-        for (int ii = 0; ii < pFactor; ii++) {
-            _deleteTree(treeNode->child[ii]);
-        }
-        delete treeNode;
-    }
+pTree *InterCPISync::_newNode() {
+    std::lock_guard<std::mutex> lock(nodeLock); // subtrees may be synchronized in parallel
+    nodeArena.emplace_back(new CPISync_ExistingConnection(nodeParams.get()), pFactor);
+    return &nodeArena.back();
 }
 
 ZZ_p InterCPISync::_hash(shared_ptr<DataObject>datum) const {
@@ -225,76 +272,6 @@ ZZ_p InterCPISync::_hash(shared_ptr<DataObject>datum) const {
     return to_ZZ_p(num % DATA_MAX); // reduce to bit_num bits and make into a ZZ_p
 }
 
-bool InterCPISync::_createTreeNode(pTree *&treeNode, pTree *parent, const ZZ &begRange, const ZZ &endRange) {
-    Logger::gLog(Logger::METHOD,"Entering InterCPISync::createTreeNode");
-    treeNode = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes),pFactor);
-
-    CPISync *curr = treeNode->getDatum(); // the current node
-
-    if (parent != nullptr) {
-        // add all appropriate parent info
-        CPISync *par = parent->getDatum(); // the parent node
-
-        for (auto elem = par->beginElements(); elem != par->endElements(); elem++) {
-            const ZZ elemZZ = rep(_hash(*elem));
-            if ((elemZZ >= begRange) && (elemZZ < endRange) && (!curr->addElem(*elem))) //if element is in range and add fails
-                return false;
-        }
-    }
-    return true;
-}
-
-bool InterCPISync::_addElem(shared_ptr<DataObject>newDatum, pTree *&treeNode, pTree *parent, const ZZ &begRange,
-                            const ZZ &endRange) {
-    Logger::gLog(Logger::METHOD,"Entering InterCPISync::addElem");
-    Logger::gLog(Logger::METHOD_DETAILS, ".  (InterCPISync) adding in range " + toStr(begRange) + " - " + toStr(endRange));
-    CPISync *curr;
-
-    // if the current node is empty, create it
-    if (treeNode == nullptr) {
-        _createTreeNode(treeNode, parent, begRange, endRange); // create a new tree node here
-        curr = treeNode->getDatum();
-
-        if (parent == nullptr) // I'm at the root of the tree ... nothing was propagated, so add the new datum
-            if (!curr->addElem(newDatum))
-                return false;
-    }
-    else { // treeNode was not null ... just add the newDatum
-        curr = treeNode->getDatum();
-        if (!curr->addElem(newDatum)) return false; //Add to current node
-    }
-
-    // do we need to add to its children as well?
-    if (curr->getNumElem() > 0 && endRange - begRange > 1) { // keep dividing until we have no elements or we reach a cell with only one value in its range
-        // find the correct child
-        ZZ step = (endRange - begRange) / pFactor;
-
-        if (step == 0) { // minimum step size is 1 - this will leave some partitions unused
-            step=1;
-        }
-
-        long childPos = to_long((addElemHashID - begRange) / step);
-        if (childPos >= pFactor) childPos = pFactor - 1; // lump all final elements into the last child
-
-        ZZ newBegin = begRange + childPos * step; // beginning point of the range of the appropriate child
-        ZZ newEnd = (childPos == pFactor - 1) ?
-                    endRange : // last elements lumped into the last child
-                    min(newBegin + step, endRange); // don't overrun the end range of the parent node
-
-        // recursively add newDatum to the appropriate child
-        if (!_addElem(newDatum, treeNode->child[childPos], treeNode, newBegin, newEnd)) return false;
-
-        // create nodes for all NULL children
-        for (long ii = 0; ii < pFactor - 1; ii++)
-            if (treeNode->child[ii] == nullptr)
-                _createTreeNode(treeNode->child[ii], treeNode, begRange + ii * step, begRange + (ii + 1) * step);
-
-        if (treeNode->child[pFactor - 1] == nullptr) // last case is special
-            _createTreeNode(treeNode->child[pFactor - 1], treeNode, begRange + (pFactor - 1) * step, endRange);
-    }
-    return true;
-}
-
 bool InterCPISync::_delElem(shared_ptr<DataObject> datum, pTree * &node, const ZZ &begRange, const ZZ &endRange) {
 	// Compute the hash of the element to find out which children to search if it is present in the parent
 	addElemHashID = rep(_hash(datum));
@@ -437,76 +414,70 @@ bool InterCPISync::_SyncServer(const shared_ptr<Communicant> &commSync, list<sha
 
 bool InterCPISync::_SyncServer(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 							   list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,
-							   const ZZ &endRange) {
+							   const ZZ &endRange, SyncStats &stats,
+							   const vector<shared_ptr<Communicant>> &childComms) {
 
 	//Establish initial Handshakes - Check If I have nothing or If Client has nothing
 	int response;
+	exchanges++;
 
 	if(treeNode == nullptr || treeNode->getDatum()->getNumElem() == 0){
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        stats.timerStart(SyncStats::COMM_TIME);
         commSync->commSend(SYNC_NO_INFO);
 		response = commSync->commRecv_byte();
 		if(response!=SYNC_NO_INFO)
 			CPISync::receiveAllElem(commSync, otherMinusSelf);
 
-        mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
-        mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
+        stats.increment(SyncStats::RECV,commSync->getRecvBytes());
+        stats.increment(SyncStats::XMIT,commSync->getXmitBytes());
 
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        stats.timerEnd(SyncStats::COMM_TIME);
         return true;
 	}
 	else {
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        stats.timerStart(SyncStats::COMM_TIME);
         commSync->commSend(SYNC_SOME_INFO);
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        stats.timerEnd(SyncStats::COMM_TIME);
 
-        mySyncStats.timerStart(SyncStats::IDLE_TIME);
+        stats.timerStart(SyncStats::IDLE_TIME);
         response = commSync->commRecv_byte();
-        mySyncStats.timerEnd(SyncStats::IDLE_TIME);
+        stats.timerEnd(SyncStats::IDLE_TIME);
 
         CPISync *node = treeNode->getDatum();
 
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        stats.timerStart(SyncStats::COMM_TIME);
         if (response == SYNC_NO_INFO) {
             node->sendAllElem(commSync, selfMinusOther); // send all I've got
-            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+            stats.timerEnd(SyncStats::COMM_TIME);
             return true;
         } else {
-            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+            stats.timerEnd(SyncStats::COMM_TIME);
             //Attempt Sync on current node
             if (!node->SyncServer(commSync, selfMinusOther,
                                   otherMinusSelf)) { // sync failure - create Children and go try to sync
 
                 // Accumulate stats from each CPISync in InterCPISyncs mySyncStats object
-                mySyncStats.increment(SyncStats::XMIT, node->mySyncStats.getStat(SyncStats::XMIT));
-                mySyncStats.increment(SyncStats::RECV, node->mySyncStats.getStat(SyncStats::RECV));
-                mySyncStats.increment(SyncStats::COMM_TIME, node->mySyncStats.getStat(SyncStats::COMM_TIME));
-                mySyncStats.increment(SyncStats::IDLE_TIME, node->mySyncStats.getStat(SyncStats::IDLE_TIME));
-                mySyncStats.increment(SyncStats::COMP_TIME, node->mySyncStats.getStat(SyncStats::COMP_TIME));
+                stats.increment(SyncStats::XMIT, node->mySyncStats.getStat(SyncStats::XMIT));
+                stats.increment(SyncStats::RECV, node->mySyncStats.getStat(SyncStats::RECV));
+                stats.increment(SyncStats::COMM_TIME, node->mySyncStats.getStat(SyncStats::COMM_TIME));
+                stats.increment(SyncStats::IDLE_TIME, node->mySyncStats.getStat(SyncStats::IDLE_TIME));
+                stats.increment(SyncStats::COMP_TIME, node->mySyncStats.getStat(SyncStats::COMP_TIME));
 
 
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
+                stats.timerStart(SyncStats::COMM_TIME);
                 commSync->commSend(SYNC_FAIL_FLAG);
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                stats.timerEnd(SyncStats::COMM_TIME);
 
-                mySyncStats.timerStart(SyncStats::COMP_TIME);
-                auto *tempTree = new pTree(
-                        new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes), pFactor);
+                stats.timerStart(SyncStats::COMP_TIME);
+                pTree *tempTree = _newNode();
                 createChildren(treeNode, tempTree, begRange, endRange);//Create child Nodes;
                 treeNode = tempTree;                    //Update the current parent node(parent node only used for referencing the child nodes)
-                ZZ step = (endRange - begRange) / pFactor;
-                mySyncStats.timerEnd(SyncStats::COMP_TIME);
-                //if(step ==0) step = 1;
-                for (int ii = 0; ii < pFactor - 1; ii++) {
-                    _SyncServer(commSync, selfMinusOther, otherMinusSelf, treeNode->child[ii], begRange + (ii * step),
-                                begRange + (ii + 1) * step);
-                }//Last child needs to handle odd pFactors
-                _SyncServer(commSync, selfMinusOther, otherMinusSelf, treeNode->child[pFactor - 1],
-                            begRange + ((pFactor - 1) * step), endRange);
+                stats.timerEnd(SyncStats::COMP_TIME);
+                _syncChildren(false, commSync, selfMinusOther, otherMinusSelf, treeNode, begRange, endRange, stats, childComms);
             } else {
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
+                stats.timerStart(SyncStats::COMM_TIME);
                 commSync->commSend(SYNC_OK_FLAG);
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                stats.timerEnd(SyncStats::COMM_TIME);
             }
             return true;
         }
@@ -517,48 +488,44 @@ void InterCPISync::createChildren(pTree * parentNode, pTree * tempTree, const ZZ
 
 	ZZ step = (endRange - begRange)/pFactor;//Get the step size of the node to establish bin sizes
 	if(step ==0) step = 1;                  //Set minimum step size to 1 to avoid divide errors
-	long pos;
-	CPISync * nodes[pFactor];
 	if(endRange != begRange){
-		for(int ii=0;ii<pFactor;ii++)
-		{
-			tempTree->child[ii] =  new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes),pFactor);//Create child nodes for parent
-			nodes[ii] = tempTree->child[ii]->getDatum();//Create references for the child nodes(used for insertion)
-		}	
+		// sort the parent's elements into the children's ranges, the last child taking the remainder ...
+		vector<vector<shared_ptr<DataObject>>> parts(pFactor);
 		CPISync * parent = parentNode->getDatum();//Get the parent node
-
 		for(auto elem = parent->beginElements();elem!=parent->endElements();elem++){    //Iterate through all parent information
-			ZZ elemZZ = rep(_hash(*elem));
-			pos = pFactor-1;
-			for(int jj=0;jj<pFactor-1;jj++){
-				if((elemZZ >= (begRange +(jj*step))) && (elemZZ < (begRange + (jj+1)*step))){
-					pos = jj;
-					break;
-				}
-			}
-			nodes[pos]->addElem(*elem);//Add to appropriate child
+			long pos = to_long((rep(_hash(*elem)) - begRange) / step);
+			parts[pos < pFactor ? pos : pFactor - 1].push_back(*elem);
+		}
+
+		// ... then fill each child at once, updating its evaluations for all of its elements together
+		for(int ii=0;ii<pFactor;ii++)
+		{
+			tempTree->child[ii] = _newNode();//Create child nodes for parent
+			tempTree->child[ii]->getDatum()->addElems(parts[ii]);
 		}
 	}
 }
 
 bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 							   list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,
-							   const ZZ &endRange)
+							   const ZZ &endRange, SyncStats &stats,
+							   const vector<shared_ptr<Communicant>> &childComms)
 {
 	try{
 	    //Initial Handshakes - Check if I have nothing or server has nothing
 		int response;
+		exchanges++;
 		if(treeNode == nullptr)
 		{
-            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            stats.timerStart(SyncStats::COMM_TIME);
             commSync->commSend(SYNC_NO_INFO);
 			response = commSync->commRecv_byte();
             if (response != SYNC_NO_INFO) // it is not the case that both nodes are empty
 				CPISync::receiveAllElem(commSync, otherMinusSelf);
-            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+            stats.timerEnd(SyncStats::COMM_TIME);
             return true;
 		} else
-            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            stats.timerStart(SyncStats::COMM_TIME);
             commSync->commSend(SYNC_SOME_INFO); // I have some elements
             response = commSync->commRecv_byte(); // get the other Communicants initial declaration
 
@@ -568,37 +535,28 @@ bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<sha
             Logger::gLog(Logger::COMM, " ... data is " + node->printElem());
             if (response == SYNC_NO_INFO) {// Case 1:  I have something; the other has nothing
                 node->sendAllElem(commSync, selfMinusOther); // send all I've got
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                stats.timerEnd(SyncStats::COMM_TIME);
                 return true;
             } else { // Case 2: We both have something
                 // synchronize the current node
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                stats.timerEnd(SyncStats::COMM_TIME);
                 node->SyncClient(commSync, selfMinusOther, otherMinusSelf); // attempt synchroniztion
 
                 // Accumulate stats from each CPISync in InterCPISyncs mySyncStats object
-                mySyncStats.increment(SyncStats::XMIT,node->mySyncStats.getStat(SyncStats::XMIT));
-                mySyncStats.increment(SyncStats::RECV,node->mySyncStats.getStat(SyncStats::RECV));
-                mySyncStats.increment(SyncStats::COMM_TIME,node->mySyncStats.getStat(SyncStats::COMM_TIME));
-                mySyncStats.increment(SyncStats::IDLE_TIME,node->mySyncStats.getStat(SyncStats::IDLE_TIME));
-                mySyncStats.increment(SyncStats::COMP_TIME,node->mySyncStats.getStat(SyncStats::COMP_TIME));
+                stats.increment(SyncStats::XMIT,node->mySyncStats.getStat(SyncStats::XMIT));
+                stats.increment(SyncStats::RECV,node->mySyncStats.getStat(SyncStats::RECV));
+                stats.increment(SyncStats::COMM_TIME,node->mySyncStats.getStat(SyncStats::COMM_TIME));
+                stats.increment(SyncStats::IDLE_TIME,node->mySyncStats.getStat(SyncStats::IDLE_TIME));
+                stats.increment(SyncStats::COMP_TIME,node->mySyncStats.getStat(SyncStats::COMP_TIME));
 
                 if (commSync->commRecv_byte() == SYNC_FAIL_FLAG)
                 { // i.e. the sync is reported by the Server to have failed; recurse
-                    mySyncStats.timerStart(SyncStats::COMP_TIME);
-                    auto *tempTree = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes),pFactor);
+                    stats.timerStart(SyncStats::COMP_TIME);
+                    pTree *tempTree = _newNode();
                     createChildren(treeNode, tempTree, begRange, endRange);//Create child Nodes;
                     treeNode = tempTree;				    //Update the current parent node(temp parent only children are used)
-                    ZZ step = (endRange - begRange)/pFactor;
-                    mySyncStats.timerEnd(SyncStats::COMP_TIME);
-
-                    //if(step ==0) step = 1;
-                    for(int ii=0;ii<pFactor-1;ii++)
-                    {
-                        _SyncClient(commSync, selfMinusOther, otherMinusSelf, treeNode->child[ii], begRange + (ii * step),
-                                    begRange + (ii + 1) * step);
-                    }//Last Child needs to handle odd pFactors
-                    _SyncClient(commSync, selfMinusOther, otherMinusSelf, treeNode->child[pFactor - 1],
-                                begRange + ((pFactor - 1) * step), endRange);
+                    stats.timerEnd(SyncStats::COMP_TIME);
+                    _syncChildren(true, commSync, selfMinusOther, otherMinusSelf, treeNode, begRange, endRange, stats, childComms);
                 }
                 return true;
             }
@@ -607,4 +565,230 @@ bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<sha
 		commSync->commClose();
 		throw (s);
 	}
-}
\ No newline at end of file
+}
+
+void InterCPISync::_syncChildren(bool asClient, const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                                 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *parent, const ZZ &begRange, const ZZ &endRange,
+                                 SyncStats &stats, const vector<shared_ptr<Communicant>> &childComms) {
+    Logger::gLog(Logger::METHOD_DETAILS, " > dividing into children");
+    ZZ step = (endRange - begRange) / pFactor;
+
+    // synchronizes the ii-th child over comm; the last child also takes the remainder of the range
+    auto syncChild = [&](const shared_ptr<Communicant> &comm, long ii, list<shared_ptr<DataObject>> &smo,
+                         list<shared_ptr<DataObject>> &oms, SyncStats &st) {
+        ZZ childBeg = begRange + ii * step;
+        ZZ childEnd = (ii == pFactor - 1) ? endRange : begRange + (ii + 1) * step;
+        if (asClient)
+            _SyncClient(comm, smo, oms, parent->child[ii], childBeg, childEnd, st);
+        else
+            _SyncServer(comm, smo, oms, parent->child[ii], childBeg, childEnd, st);
+    };
+
+    if (childComms.empty()) {
+        for (long ii = 0; ii < pFactor; ii++)
+            syncChild(commSync, ii, selfMinusOther, otherMinusSelf, stats);
+    } else {
+        // each thread synchronizes a run of children over its own connection, into its own results
+        size_t numThreads = std::min((size_t) pFactor, childComms.size());
+        vector<list<shared_ptr<DataObject>>> smo(numThreads), oms(numThreads);
+        vector<SyncStats> threadStats(numThreads);
+        vector<std::exception_ptr> failures(numThreads);
+        ZZ_pContext field; // NTL keeps the ZZ_p modulus of each thread separately
+        field.save();
+
+        parallelFor((size_t) pFactor, numThreads, [&](size_t first, size_t last, size_t slice) {
+            field.restore();
+            const shared_ptr<Communicant> &comm = childComms[slice];
+            try {
+                // a new connection must first agree on the ZZ_p modulus
+                if (asClient) {
+                    comm->commConnect();
+                    if (!comm->establishModSend())
+                        throw SyncFailureException("ZZ_p moduli do not match on a subtree connection.");
+                } else {
+                    comm->commListen();
+                    if (!comm->establishModRecv())
+                        throw SyncFailureException("ZZ_p moduli do not match on a subtree connection.");
+                }
+                for (size_t ii = first; ii < last; ii++)
+                    syncChild(comm, (long) ii, smo[slice], oms[slice], threadStats[slice]);
+                comm->commClose();
+            } catch (...) {
+                failures[slice] = std::current_exception();
+            }
+        });
+
+        for (size_t ii = 0; ii < numThreads; ii++) {
+            if (failures[ii])
+                std::rethrow_exception(failures[ii]);
+            selfMinusOther.splice(selfMinusOther.end(), smo[ii]);
+            otherMinusSelf.splice(otherMinusSelf.end(), oms[ii]);
+            // the times of the threads add up, so they may exceed the time taken
+            for (auto id : {SyncStats::XMIT, SyncStats::RECV, SyncStats::COMM_TIME, SyncStats::IDLE_TIME, SyncStats::COMP_TIME})
+                stats.increment(id, threadStats[ii].getStat(id));
+        }
+    }
+    Logger::gLog(Logger::METHOD_DETAILS, "< returning from division");
+}
+
+void InterCPISync::_splitNode(const LevelNode &parent, vector<LevelNode> &next) {
+    pTree *tempTree = _newNode();
+    createChildren(parent.node, tempTree, parent.begRange, parent.endRange);
+
+    // the last child also takes the remainder of the range
+    ZZ step = (parent.endRange - parent.begRange) / pFactor;
+    for (long ii = 0; ii < pFactor; ii++) {
+        ZZ childEnd = (ii == pFactor - 1) ? parent.endRange : parent.begRange + (ii + 1) * step;
+        next.push_back({tempTree->child[ii], parent.begRange + ii * step, childEnd});
+    }
+}
+
+bool InterCPISync::_SyncClientBreadthFirst(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                                           list<shared_ptr<DataObject>> &otherMinusSelf, SyncStats &stats) {
+    Logger::gLog(Logger::METHOD, "Entering InterCPISync::SyncClientBreadthFirst");
+    vector<LevelNode> level = {{treeNode, ZZ_ZERO, DATA_MAX}};
+
+    // elements that the server is owed, sent along with the next level:  all of some nodes, and some of others
+    vector<CPISync *> owedAll;
+    vector<pair<CPISync *, vec_ZZ_p>> owedHashes;
+
+    try {
+        while (true) {
+            // one message:  the elements owed from the previous level, and the evaluations of this one
+            stats.timerStart(SyncStats::COMM_TIME);
+            for (CPISync *node : owedAll)
+                node->sendAllElem(commSync, selfMinusOther);
+            for (auto &owed : owedHashes)
+                owed.first->sendElems(commSync, owed.second, selfMinusOther);
+            owedAll.clear();
+            owedHashes.clear();
+
+            for (const LevelNode &curr : level) {
+                if (emptyNode(curr.node))
+                    commSync->commSend((long) 0);
+                else
+                    curr.node->getDatum()->sendEvals(commSync);
+            }
+            stats.timerEnd(SyncStats::COMM_TIME);
+            if (level.empty()) {
+                countBytes(commSync, stats);
+                break;
+            }
+            Logger::gLog(Logger::METHOD_DETAILS, "Synchronizing a level of " + toStr(level.size()) + " nodes");
+            exchanges++;
+
+            // one reply:  the server's verdict on each node
+            vector<LevelNode> next;
+            for (const LevelNode &curr : level) {
+                stats.timerStart(SyncStats::COMM_TIME);
+                byte verdict = commSync->commRecv_byte();
+                if (verdict == CLIENT_EMPTY)
+                    CPISync::receiveAllElem(commSync, otherMinusSelf);
+                else if (verdict == SERVER_EMPTY)
+                    owedAll.push_back(curr.node->getDatum());
+                else if (verdict == NODE_SYNCED) {
+                    vec_ZZ_p theirs = commSync->commRecv_vec_ZZ_p(); // the server's self - other
+                    vec_ZZ_p mine = commSync->commRecv_vec_ZZ_p();   // the server's other - self
+                    curr.node->getDatum()->recvElems(commSync, theirs, otherMinusSelf);
+                    owedHashes.emplace_back(curr.node->getDatum(), mine);
+                }
+                stats.timerEnd(SyncStats::COMM_TIME);
+
+                if (verdict == NODE_FAILED) {
+                    stats.timerStart(SyncStats::COMP_TIME);
+                    _splitNode(curr, next);
+                    stats.timerEnd(SyncStats::COMP_TIME);
+                }
+            }
+            countBytes(commSync, stats);
+            level = std::move(next);
+        }
+    } catch (const SyncFailureException& s) {
+        Logger::gLog(Logger::METHOD_DETAILS, s.what());
+        commSync->commClose();
+        throw (s);
+    }
+
+    return true;
+}
+
+bool InterCPISync::_SyncServerBreadthFirst(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                                           list<shared_ptr<DataObject>> &otherMinusSelf, SyncStats &stats) {
+    Logger::gLog(Logger::METHOD, "Entering InterCPISync::SyncServerBreadthFirst");
+    vector<LevelNode> level = {{treeNode, ZZ_ZERO, DATA_MAX}};
+
+    // elements that the client owes, received along with the next level:  all of some nodes, and some of others
+    long owedAll = 0;
+    vector<pair<CPISync *, vec_ZZ_p>> owedHashes;
+
+    try {
+        while (true) {
+            stats.timerStart(SyncStats::COMM_TIME);
+            for (long ii = 0; ii < owedAll; ii++)
+                CPISync::receiveAllElem(commSync, otherMinusSelf);
+            for (auto &owed : owedHashes)
+                owed.first->recvElems(commSync, owed.second, otherMinusSelf);
+            owedAll = 0;
+            owedHashes.clear();
+            if (level.empty()) {
+                stats.timerEnd(SyncStats::COMM_TIME);
+                countBytes(commSync, stats);
+                break;
+            }
+            exchanges++;
+
+            // all of the level's evaluations arrive before any reply
+            vector<long> theirSizes;
+            vector<vec_ZZ_p> theirEvals;
+            for (size_t ii = 0; ii < level.size(); ii++) {
+                theirSizes.push_back(commSync->commRecv_long());
+                theirEvals.push_back(theirSizes.back() > 0 ? commSync->commRecv_vec_ZZ_p() : vec_ZZ_p());
+            }
+            stats.timerEnd(SyncStats::COMM_TIME);
+
+            vector<LevelNode> next;
+            for (size_t ii = 0; ii < level.size(); ii++) {
+                const LevelNode &curr = level[ii];
+                if (theirSizes[ii] == 0) {
+                    stats.timerStart(SyncStats::COMM_TIME);
+                    if (emptyNode(curr.node))
+                        commSync->commSend(NODE_EMPTY);
+                    else {
+                        commSync->commSend(CLIENT_EMPTY);
+                        curr.node->getDatum()->sendAllElem(commSync, selfMinusOther);
+                    }
+                    stats.timerEnd(SyncStats::COMM_TIME);
+                } else if (emptyNode(curr.node)) {
+                    commSync->commSend(SERVER_EMPTY);
+                    owedAll++;
+                } else {
+                    CPISync *node = curr.node->getDatum();
+                    vec_ZZ_p delta_self, delta_other;
+                    stats.timerStart(SyncStats::COMP_TIME);
+                    bool synced = node->reconcileEvals(theirSizes[ii], theirEvals[ii], delta_self, delta_other);
+                    if (!synced)
+                        _splitNode(curr, next);
+                    stats.timerEnd(SyncStats::COMP_TIME);
+
+                    stats.timerStart(SyncStats::COMM_TIME);
+                    if (synced) {
+                        commSync->commSend(NODE_SYNCED);
+                        commSync->commSend(delta_self);
+                        commSync->commSend(delta_other);
+                        node->sendElems(commSync, delta_self, selfMinusOther);
+                        owedHashes.emplace_back(node, delta_other);
+                    } else
+                        commSync->commSend(NODE_FAILED);
+                    stats.timerEnd(SyncStats::COMM_TIME);
+                }
+            }
+            countBytes(commSync, stats);
+            level = std::move(next);
+        }
+    } catch (const SyncFailureException& s) {
+        Logger::gLog(Logger::METHOD_DETAILS, s.what());
+        throw (s);
+    }
+
+    return true;
+}
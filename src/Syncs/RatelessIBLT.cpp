@@ -0,0 +1,175 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * Rateless IBLT encoding and decoding.  See RatelessIBLT.h.
+ */
+
+#include <cmath>
+#include <CPISync/Syncs/RatelessIBLT.h>
+
+namespace {
+    // the hash index that seeds the symbol mapping of an element, distinct from the IBLT cell and check hashes
+    const long MAPPING_HASH = N_HASHCHECK + 1;
+
+    // the multiplier of the mapping generator
+    const std::uint64_t MAPPING_MULT = 0xda942042e4dd58b5ULL;
+
+    // the next symbol of an element that maps to no more symbols
+    const std::uint64_t NEVER = UINT64_MAX;
+}
+
+RatelessIBLT::RatelessIBLT(IBLTHashScheme scheme) : hashScheme(scheme), numSyms(0) {
+}
+
+RatelessIBLT::Source RatelessIBLT::_source(const ZZ &key, long sign) const {
+    Source src;
+    src.key = key;
+    src.check = IBLT::_hashK(key, N_HASHCHECK, hashScheme);
+    src.sign = sign;
+    src.prng = IBLT::_hashK(key, MAPPING_HASH, hashScheme);
+    src.next = 0; // every element maps to the first symbol
+    return src;
+}
+
+void RatelessIBLT::_advance(Source &src) {
+    // the gap to the next symbol grows with the index, so that symbol ii holds each element
+    // with probability about 1/(1 + ii/2)
+    if (src.next == NEVER)
+        return;
+    src.prng *= MAPPING_MULT;
+    double gap = std::ceil(((double) src.next + 1.5) * ((double) (1ULL << 32) / std::sqrt((double) src.prng + 1) - 1));
+
+    // small draws give gaps past any index, which saturate rather than overflow the conversion or the index
+    if (gap >= std::ldexp(1.0, 64)) {
+        src.next = NEVER;
+        return;
+    }
+    std::uint64_t step = gap < 1 ? 1 : (std::uint64_t) gap;
+    src.next = step >= NEVER - src.next ? NEVER : src.next + step;
+}
+
+void RatelessIBLT::SourceQueue::push(const Source &src) {
+    sources.push_back(src);
+    queue.emplace(src.next, sources.size() - 1);
+}
+
+void RatelessIBLT::SourceQueue::apply(vector<Symbol> &symbols, std::uint64_t first, long sign) {
+    const std::uint64_t end = first + symbols.size();
+    while (!queue.empty() && queue.top().first < end) {
+        size_t ii = queue.top().second;
+        queue.pop();
+        Source &src = sources[ii];
+
+        Symbol &sym = symbols[src.next - first];
+        sym.count += sign * src.sign;
+        sym.keySum ^= src.key;
+        sym.keyCheck ^= src.check;
+
+        _advance(src);
+        queue.emplace(src.next, ii);
+    }
+}
+
+void RatelessIBLT::insert(const ZZ &key) {
+    localSources.push(_source(key, 1));
+}
+
+vector<byte> RatelessIBLT::encode(size_t num) {
+    vector<Symbol> batch(num);
+    localSources.apply(batch, numSyms, 1);
+    numSyms += num;
+
+    size_t total = 0;
+    for (const Symbol &sym : batch)
+        total += sizeof(long) + sizeof(hash_t) + serialSizeZZ(sym.keySum);
+
+    vector<byte> res(total);
+    byte *out = res.data();
+    for (const Symbol &sym : batch) {
+        out = writeWordLE((std::uint64_t) sym.count, out);
+        out = writeWordLE(sym.keyCheck, out);
+        out = writeBytesZZ(sym.keySum, out);
+    }
+    return res;
+}
+
+bool RatelessIBLT::decode(const byte *data, size_t len) {
+    // parse the peer's symbols, each a count, a hash-check and a length-prefixed key sum, checking every
+    // length against what is left, before anything changes ...
+    vector<Symbol> batch;
+    const byte *end = data + len;
+    while (data < end) {
+        if ((size_t) (end - data) < sizeof(long) + sizeof(hash_t) + sizeof(long)) {
+            Logger::gLog(Logger::METHOD_DETAILS, "Rateless IBLT symbol " + toStr(numSyms + batch.size())
+                                                 + " is truncated");
+            return false;
+        }
+        Symbol sym;
+        sym.count = (long) readWordLE(data);
+        data += sizeof(long);
+        sym.keyCheck = readWordLE(data);
+        data += sizeof(hash_t);
+        auto numBytes = (size_t) readWordLE(data);
+        data += sizeof(long);
+        if (numBytes > (size_t) (end - data)) {
+            Logger::gLog(Logger::METHOD_DETAILS, "Rateless IBLT symbol " + toStr(numSyms + batch.size())
+                                                 + " is truncated");
+            return false;
+        }
+        sym.keySum = ZZFromBytes(data, (long) numBytes);
+        data += numBytes;
+        batch.push_back(sym);
+    }
+
+    // ... take out the local elements and those already decoded ...
+    localSources.apply(batch, numSyms, -1);
+    decodedSources.apply(batch, numSyms, -1);
+
+    // ... and peel what has become pure
+    for (size_t ii = 0; ii < batch.size(); ii++) {
+        symbols.push_back(batch[ii]);
+        if (batch[ii].isPure(hashScheme))
+            candidates.push_back(numSyms + ii);
+    }
+    numSyms += batch.size();
+    _peel();
+
+    return decoded();
+}
+
+void RatelessIBLT::_peel() {
+    while (!candidates.empty()) {
+        Symbol &sym = symbols[candidates.back()];
+        candidates.pop_back();
+        if (!sym.isPure(hashScheme))
+            continue; // changed by an earlier peel
+
+        ZZ key = sym.keySum;
+        long count = sym.count;
+        (count == 1 ? remote : local).push_back(key);
+
+        // take the element out of every received symbol that it maps to ...
+        Source src = _source(key, count);
+        while (src.next < symbols.size()) {
+            Symbol &other = symbols[src.next];
+            other.count -= count;
+            other.keySum ^= key;
+            other.keyCheck ^= src.check;
+            if (other.count == 1 || other.count == -1)
+                candidates.push_back(src.next);
+            _advance(src);
+        }
+
+        // ... and out of the symbols still to come
+        decodedSources.push(src);
+    }
+}
+
+bool RatelessIBLT::decoded() const {
+    // every element maps to the first symbol, so it is empty only once every difference is decoded
+    return !symbols.empty() && symbols[0].empty();
+}
+
+size_t RatelessIBLT::numSymbols() const {
+    return numSyms;
+}
@@ -0,0 +1,180 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * Rateless IBLT synchronization.  See RatelessIBLTSync.h.
+ */
+
+#include <CPISync/Aux/Exceptions.h>
+#include <CPISync/Syncs/RatelessIBLTSync.h>
+
+namespace {
+    // the server's reply to a batch of symbols
+    const byte DECODED = SYNC_OK_FLAG;       // the difference is decoded; stop sending
+    const byte SEND_MORE = SYNC_SOME_INFO;   // keep sending
+    const byte GAVE_UP = SYNC_FAIL_FLAG;     // the symbol limit was reached without decoding; stop sending
+}
+
+RatelessIBLTSync::RatelessIBLTSync(IBLTHashScheme scheme) : hashScheme(scheme) {
+    SyncID = SYNC_TYPE::RatelessIBLTSync;
+}
+
+RatelessIBLTSync::~RatelessIBLTSync() = default;
+
+RatelessIBLT RatelessIBLTSync::_encoder() {
+    RatelessIBLT res(hashScheme);
+    for (auto iter = beginElements(); iter != endElements(); ++iter)
+        res.insert((*iter)->to_ZZ());
+    return res;
+}
+
+bool RatelessIBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) {
+    try {
+        Logger::gLog(Logger::METHOD, "Entering RatelessIBLTSync::SyncClient");
+
+        // call parent method for bookkeeping
+        SyncMethod::SyncClient(commSync, selfMinusOther, otherMinusSelf);
+
+        // connect to server
+        mySyncStats.timerStart(SyncStats::IDLE_TIME);
+        commSync->commConnect();
+        mySyncStats.timerEnd(SyncStats::IDLE_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        RatelessIBLT encoder = _encoder();
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+        // the server bounds the number of symbols by the sizes of both sets, and needs our hash family to peel them
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        commSync->commSend((long) getNumElem());
+        commSync->commSend((byte) hashScheme);
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+        // stream symbols in batches of about a quarter of those sent so far, until the server stops us
+        byte reply = SEND_MORE;
+        while (reply == SEND_MORE) {
+            size_t batch = encoder.numSymbols() / 4 < INITIAL_BATCH ? INITIAL_BATCH : encoder.numSymbols() / 4;
+
+            mySyncStats.timerStart(SyncStats::COMP_TIME);
+            vector<byte> symbols = encoder.encode(batch);
+            mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            commSync->commSend(ustring(symbols.begin(), symbols.end()));
+            reply = commSync->commRecv_byte();
+            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        }
+        Logger::gLog(Logger::METHOD_DETAILS, "RatelessIBLTSync: sent " + toStr(encoder.numSymbols()) + " symbols");
+
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        list<shared_ptr<DataObject>> newOMS = commSync->commRecv_DataObject_List();
+        list<shared_ptr<DataObject>> newSMO = commSync->commRecv_DataObject_List();
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        otherMinusSelf.insert(otherMinusSelf.end(), newOMS.begin(), newOMS.end());
+        selfMinusOther.insert(selfMinusOther.end(), newSMO.begin(), newSMO.end());
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+        stringstream msg;
+        msg << "RatelessIBLTSync " << (reply == DECODED ? "succeeded" : "may not have completely succeeded") << endl;
+        msg << "self - other = " << printListOfSharedPtrs(selfMinusOther) << endl;
+        msg << "other - self = " << printListOfSharedPtrs(otherMinusSelf) << endl;
+        Logger::gLog(Logger::METHOD, msg.str());
+
+        //Record Stats
+        mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
+        mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
+
+        return reply == DECODED;
+    } catch (SyncFailureException& s) {
+        Logger::gLog(Logger::METHOD_DETAILS, s.what());
+        throw (s);
+    } // might not need the try-catch
+}
+
+bool RatelessIBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) {
+    try {
+        Logger::gLog(Logger::METHOD, "Entering RatelessIBLTSync::SyncServer");
+
+        // call parent method for bookkeeping
+        SyncMethod::SyncServer(commSync, selfMinusOther, otherMinusSelf);
+
+        // listen for client
+        mySyncStats.timerStart(SyncStats::IDLE_TIME);
+        commSync->commListen();
+        mySyncStats.timerEnd(SyncStats::IDLE_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        RatelessIBLT decoder = _encoder();
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        auto theirElems = (size_t) commSync->commRecv_long();
+        auto theirScheme = (IBLTHashScheme) commSync->commRecv_byte();
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        const size_t limit = SYMBOL_LIMIT_FACTOR * (theirElems + getNumElem()) + INITIAL_BATCH;
+        if (theirScheme != hashScheme)
+            // their symbols would never peel, so refuse the first batch rather than run to the limit
+            Logger::error("RatelessIBLTSync: IBLT hash schemes do not match; both peers must set the same legacyIBLTHash.");
+
+        // peel each batch as it arrives, and ask for more until the difference is decoded
+        byte reply = SEND_MORE;
+        while (reply == SEND_MORE) {
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            ustring symbols = commSync->commRecv_ustring();
+            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMP_TIME);
+            size_t received = decoder.numSymbols();
+            if (theirScheme != hashScheme)
+                reply = GAVE_UP;
+            else if (decoder.decode(symbols.data(), symbols.size()))
+                reply = DECODED;
+            else if (decoder.numSymbols() == received) {
+                Logger::gLog(Logger::METHOD_DETAILS, "RatelessIBLTSync: malformed batch of symbols");
+                reply = GAVE_UP; // a batch is never empty
+            } else if (decoder.numSymbols() >= limit)
+                reply = GAVE_UP;
+            mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+            mySyncStats.timerStart(SyncStats::COMM_TIME);
+            commSync->commSend(reply);
+            mySyncStats.timerEnd(SyncStats::COMM_TIME);
+        }
+        Logger::gLog(Logger::METHOD_DETAILS, "RatelessIBLTSync: received " + toStr(decoder.numSymbols()) + " symbols");
+        if (reply == GAVE_UP)
+            Logger::gLog(Logger::METHOD_DETAILS,
+                         "Unable to completely reconcile, returning a partial list of differences");
+
+        mySyncStats.timerStart(SyncStats::COMP_TIME);
+        for (const ZZ &key : decoder.remoteOnly())
+            otherMinusSelf.push_back(make_shared<DataObject>(key));
+        for (const ZZ &key : decoder.localOnly())
+            selfMinusOther.push_back(make_shared<DataObject>(key));
+        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+
+        mySyncStats.timerStart(SyncStats::COMM_TIME);
+        commSync->commSend(selfMinusOther);
+        commSync->commSend(otherMinusSelf);
+        mySyncStats.timerEnd(SyncStats::COMM_TIME);
+
+        stringstream msg;
+        msg << "RatelessIBLTSync " << (reply == DECODED ? "succeeded" : "may not have completely succeeded") << endl;
+        msg << "self - other = " << printListOfSharedPtrs(selfMinusOther) << endl;
+        msg << "other - self = " << printListOfSharedPtrs(otherMinusSelf) << endl;
+        Logger::gLog(Logger::METHOD, msg.str());
+
+        //Record Stats
+        mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
+        mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
+
+        return reply == DECODED;
+    } catch (SyncFailureException& s) {
+        Logger::gLog(Logger::METHOD_DETAILS, s.what());
+        throw (s);
+    } // might not need the try-catch
+}
+
+string RatelessIBLTSync::getName() {
+    return "RatelessIBLTSync\n";
+}
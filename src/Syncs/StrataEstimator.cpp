@@ -0,0 +1,51 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * A strata estimator for the size of a set difference.  See StrataEstimator.h.
+ */
+
+#include <CPISync/Syncs/StrataEstimator.h>
+
+namespace {
+    // seeds the stratum hash apart from the hashes that place elements within an IBLT
+    const std::uint64_t STRATUM_SEED = 0x5354524154410000ULL;
+}
+
+StrataEstimator::StrataEstimator(size_t eltSize, IBLTHashScheme scheme)
+        : strata(NUM_STRATA, IBLT(STRATUM_ENTRIES, eltSize, scheme)) {
+}
+
+int StrataEstimator::_stratum(const ZZ &key) {
+    std::uint64_t hash = seededHash(key, STRATUM_SEED);
+    if (hash == 0)
+        return NUM_STRATA - 1;
+    int zeros = __builtin_ctzll(hash);
+    return zeros < NUM_STRATA - 1 ? zeros : NUM_STRATA - 1;
+}
+
+void StrataEstimator::insert(const ZZ &key) {
+    // only the keys are needed to count differences, so values are left empty
+    strata[_stratum(key)].insert(key, ZZ::zero());
+}
+
+void StrataEstimator::erase(const ZZ &key) {
+    strata[_stratum(key)].erase(key, ZZ::zero());
+}
+
+size_t StrataEstimator::estimate(const StrataEstimator &other) const {
+    size_t count = 0;
+    for (int ii = NUM_STRATA - 1; ii >= 0; ii--) {
+        IBLT diff = strata[ii] - other.strata[ii];
+        vector<pair<ZZ, ZZ>> positive, negative;
+        if (!diff.listEntries(positive, negative)) {
+            // strata ii+1 and up hold about 1/2^(ii+1) of the elements
+            size_t res = std::max<size_t>(count, 1) << (ii + 1);
+            Logger::gLog(Logger::METHOD_DETAILS, "Strata estimator: stratum " + toStr(ii)
+                                                 + " did not decode; estimated difference " + toStr(res));
+            return res;
+        }
+        count += positive.size() + negative.size();
+    }
+    Logger::gLog(Logger::METHOD_DETAILS, "Strata estimator: exact difference " + toStr(count));
+    return count;
+}
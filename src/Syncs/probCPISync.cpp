@@ -6,8 +6,8 @@
 #include <CPISync/Syncs/CPISync.h>
 #include <CPISync/Syncs/ProbCPISync.h>
 
-ProbCPISync::ProbCPISync(long m_bar, long bits, int epsilon,bool hashes) :
-CPISync(m_bar, bits, epsilon + (int) ceil(log(bits) / log(2)), 0, hashes) // adding lg(b) gives an equivalent probability of error for CPISync
+ProbCPISync::ProbCPISync(long m_bar, long bits, int epsilon,bool hashes, RatFuncSolver solver) :
+CPISync(m_bar, bits, epsilon + (int) ceil(log(bits) / log(2)), 0, hashes, solver) // adding lg(b) gives an equivalent probability of error for CPISync
 {
 
   // tweak parameters of CPISync for probabilistic implementation
@@ -75,6 +75,28 @@ void AuxiliaryTest::testSplit()
     }
 }
 
+void AuxiliaryTest::testSeededHash() {
+    for (int ii = 0; ii < NUM_ITERS; ii++) {
+        ZZ num = RandomBits_ZZ(1 + ii * 4); // spans one to several 64-bit words
+        auto len = (size_t) NumBytes(num);
+        vector<byte> bytes(len);
+        BytesFromZZ(bytes.data(), num, len);
+        vector<std::uint64_t> words((len + 7) / 8, 0);
+        for (size_t jj = 0; jj < len; jj++)
+            words[jj / 8] |= ((std::uint64_t) bytes[jj]) << (8 * (jj % 8));
+
+        CPPUNIT_ASSERT_EQUAL(seededHash(bytes.data(), len, ii), seededHash(num, ii));
+        CPPUNIT_ASSERT_EQUAL(seededHash(bytes.data(), len, ii), seededHashWords(words.data(), len, ii));
+        CPPUNIT_ASSERT(seededHash(num, ii) != seededHash(num, ii + 1));
+        CPPUNIT_ASSERT(seededHashK(seededHash(num, 0), ii) != seededHashK(seededHash(num, 0), ii + 1));
+    }
+
+    // leading zero bytes and the sign are significant
+    const byte zeros[2] = {0, 0};
+    CPPUNIT_ASSERT(seededHash(zeros, 1, 0) != seededHash(zeros, 2, 0));
+    CPPUNIT_ASSERT(seededHash(ZZ(5), 0) != seededHash(ZZ(-5), 0));
+}
+
 void AuxiliaryTest::testBase64_encode() {
     std::string expectedEncode = "_MMwdA==";
   
@@ -25,6 +25,7 @@ class AuxiliaryTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testMultisetUnion);
     CPPUNIT_TEST(testMultisetSubset);
 	CPPUNIT_TEST(testSplit);
+    CPPUNIT_TEST(testSeededHash);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -55,6 +56,11 @@ private:
 	 * Test split string to vector
 	 **/
 	static void testSplit();
+
+	/**
+	 * Tests that the byte, word and ZZ forms of seededHash agree, and that seeds select different hashes
+	 */
+	static void testSeededHash();
 	
 	/**
 	 * Tests encoding strings to base64 (Only use 0-9,a-z,A-Z and +/) {Equals sign is used as padding}
@@ -1,14 +1,190 @@
 //
 // Created by Sean Brandenburg on 2019-06-10.
 //
+#include <thread>
 #include <cppunit/extensions/HelperMacros.h>
 #include <CPISync/Syncs/CPISync.h>
 #include "CPISyncTest.h"
 #include <CPISync/Syncs/InterCPISync.h>
+#include <CPISync/Syncs/ProbCPISync.h>
 #include "TestAuxiliary.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CPISyncTest);
 
+namespace {
+	// exposes the rational function interpolation of CPISync
+	class CPISyncInterp : public CPISync {
+	public:
+		CPISyncInterp(long m_bar, RatFuncSolver solver) : CPISync(m_bar, 32, err, 0, false, solver) {}
+		using CPISync::ratFuncInterp;
+		using CPISync::find_roots;
+		using CPISync::sampleLoc;
+	};
+
+	// @return the roots of the numerator and denominator interpolated by sync, sorted, or empty lists if it fails
+	pair<vector<ZZ>, vector<ZZ>> interpRoots(CPISyncInterp &sync, const vec_ZZ_p &evals, long mA, long mB) {
+		vec_ZZ_p P_vec, Q_vec, numerator, denominator;
+		pair<vector<ZZ>, vector<ZZ>> res;
+		if (!sync.ratFuncInterp(evals, mA, mB, P_vec, Q_vec) ||
+			!CPISyncInterp::find_roots(P_vec, Q_vec, numerator, denominator))
+			return res;
+		for (const ZZ_p &root : numerator)
+			res.first.push_back(rep(root));
+		for (const ZZ_p &root : denominator)
+			res.second.push_back(rep(root));
+		sort(res.first.begin(), res.first.end());
+		sort(res.second.begin(), res.second.end());
+		return res;
+	}
+
+	// what the client of an InterCPISync sync reports
+	struct InterReport {
+		bool success;
+		long exchanges;
+		unsigned long xmit, recv;
+	};
+
+	// Synchronizes an InterCPISync client with a server that has diffs more elements, with an mbar small enough that
+	// the sync recurses several levels deep
+	InterReport interSync(bool breadthFirst, bool hashes, int diffs) {
+		const int interCPImBar = 5;
+		const int SHARED = 50;
+		auto client = make_shared<InterCPISync>(interCPImBar, eltSize * 8, err, numParts, hashes);
+		auto server = make_shared<InterCPISync>(interCPImBar, eltSize * 8, err, numParts, hashes);
+		client->setBreadthFirst(breadthFirst);
+		server->setBreadthFirst(breadthFirst);
+		GenSync clientSync({make_shared<CommSocket>(port, host)}, {client});
+		GenSync serverSync({make_shared<CommSocket>(port)}, {server});
+		for (int ii = 0; ii < SHARED; ii++) {
+			auto elem = make_shared<DataObject>(randZZ());
+			clientSync.addElem(elem);
+			serverSync.addElem(elem);
+		}
+		for (int ii = 0; ii < diffs; ii++)
+			serverSync.addElem(make_shared<DataObject>(randZZ()));
+
+		InterReport res;
+		res.success = forkHandle(clientSync, serverSync).success
+				&& clientSync.dumpElements().size() == (size_t) (SHARED + diffs);
+		res.exchanges = client->getExchanges();
+		res.xmit = clientSync.getXmitBytes(0);
+		res.recv = clientSync.getRecvBytes(0);
+		return res;
+	}
+
+	// Checks that breadth-first syncs count their bytes, and that their exchanges grow with the depth of the tree,
+	// i.e. with the log of the number of differences, rather than with the number of nodes, as depth-first ones do
+	void checkBreadthFirstExchanges(bool hashes) {
+		const int FEW = 40, MANY = 160;
+		InterReport breadthFew = interSync(true, hashes, FEW), breadthMany = interSync(true, hashes, MANY);
+		InterReport depthFew = interSync(false, hashes, FEW), depthMany = interSync(false, hashes, MANY);
+		for (const InterReport &rep : {breadthFew, breadthMany, depthFew, depthMany}) {
+			CPPUNIT_ASSERT(rep.success);
+			CPPUNIT_ASSERT(rep.xmit > 0);
+			CPPUNIT_ASSERT(rep.recv > 0);
+		}
+
+		// four times the differences add a level or two to the tree, but about four times the nodes
+		CPPUNIT_ASSERT(breadthMany.exchanges < depthMany.exchanges / 4);
+		CPPUNIT_ASSERT(breadthMany.exchanges - breadthFew.exchanges < (depthMany.exchanges - depthFew.exchanges) / 4);
+	}
+
+	// the bound on differences of the ProbCPISync tests; their syncs start from a bound of 1, and double it each round
+	const long PROB_MBAR = 64;
+
+	// the first of the ports of the in-process ProbCPISync syncs, one per sync
+	int probPort = 8401;
+
+	// the differences that a CPISync server finds, printed
+	struct ServerDiffs {
+		bool success;
+		multiset<string> selfMinusOther, otherMinusSelf;
+
+		bool operator==(const ServerDiffs &other) const {
+			return success == other.success && selfMinusOther == other.selfMinusOther &&
+				   otherMinusSelf == other.otherMinusSelf;
+		}
+	};
+
+	// @return a ProbCPISync holding elems
+	shared_ptr<ProbCPISync> probPeer(const vector<shared_ptr<DataObject>> &elems) {
+		auto peer = make_shared<ProbCPISync>(PROB_MBAR, eltSize * 8, err);
+		for (const auto &elem : elems)
+			peer->addElem(elem);
+		return peer;
+	}
+
+	// @return num new random elements
+	vector<shared_ptr<DataObject>> newElems(int num) {
+		vector<shared_ptr<DataObject>> res;
+		for (int ii = 0; ii < num; ii++)
+			res.push_back(make_shared<DataObject>(randZZ()));
+		return res;
+	}
+
+	// @return the printed elements of elems
+	multiset<string> printed(const vector<shared_ptr<DataObject>> &elems) {
+		multiset<string> res;
+		for (const auto &elem : elems)
+			res.insert(elem->print());
+		return res;
+	}
+
+	/**
+	 * Syncs server, in this thread, with a new ProbCPISync client holding clientElems, in another, so that the server
+	 * keeps its state across syncs. The client is made in its own thread, as NTL keeps a ZZ_p modulus per thread.
+	 * The server's elements are left as they are.
+	 * @return The differences that the server finds
+	 */
+	ServerDiffs probSync(CPISync &server, const vector<shared_ptr<DataObject>> &clientElems) {
+		int syncPort = probPort++;
+		auto clientComm = make_shared<CommSocket>(syncPort, host);
+		auto serverComm = make_shared<CommSocket>(syncPort);
+
+		bool clientOK = false;
+		std::thread clientThread([&]() {
+			try {
+				list<shared_ptr<DataObject>> selfMinusOther, otherMinusSelf;
+				clientOK = probPeer(clientElems)->SyncClient(clientComm, selfMinusOther, otherMinusSelf);
+			} catch (const std::exception &) {
+				clientOK = false;
+			}
+		});
+
+		ServerDiffs res;
+		list<shared_ptr<DataObject>> selfMinusOther, otherMinusSelf;
+		try {
+			res.success = server.SyncServer(serverComm, selfMinusOther, otherMinusSelf);
+		} catch (const std::exception &) {
+			res.success = false;
+		}
+		clientThread.join();
+		res.success = res.success && clientOK;
+		for (const auto &elem : selfMinusOther)
+			res.selfMinusOther.insert(elem->print());
+		for (const auto &elem : otherMinusSelf)
+			res.otherMinusSelf.insert(elem->print());
+		return res;
+	}
+
+	/**
+	 * Syncs server with a client that has shared and clientOnly, and checks that the server, which has shared and
+	 * serverOnly, finds the differences, as does a fresh server with the same elements
+	 */
+	void checkProbSync(CPISync &server, const vector<shared_ptr<DataObject>> &shared,
+					   const vector<shared_ptr<DataObject>> &serverOnly,
+					   const vector<shared_ptr<DataObject>> &clientOnly) {
+		vector<shared_ptr<DataObject>> clientElems(shared), serverElems(shared);
+		clientElems.insert(clientElems.end(), clientOnly.begin(), clientOnly.end());
+		serverElems.insert(serverElems.end(), serverOnly.begin(), serverOnly.end());
+
+		ServerDiffs expected = {true, printed(serverOnly), printed(clientOnly)};
+		ServerDiffs found = probSync(server, clientElems);
+		CPPUNIT_ASSERT(found == expected);
+		CPPUNIT_ASSERT(probSync(*probPeer(serverElems), clientElems) == found);
+	}
+}
+
 CPISyncTest::CPISyncTest() = default;
 
 CPISyncTest::~CPISyncTest() = default;
@@ -56,6 +232,70 @@ void CPISyncTest::testCPIAddDelElem() {
 	CPPUNIT_ASSERT(cpisync.printElem().empty());
 }
 
+void CPISyncTest::testCPIDelElemAnyOrder() {
+	const int ITEMS = 60;
+	CPISync cpisync(mBar, eltSizeSq, err, 0);
+	vector<shared_ptr<DataObject>> added;
+	for (int ii = 0; ii < ITEMS; ii++) {
+		added.push_back(make_shared<DataObject>(randZZ()));
+		CPPUNIT_ASSERT(cpisync.addElem(added.back()));
+	}
+
+	// delete every third element, from the back, and one element that is not there
+	multiset<shared_ptr<DataObject>, cmp<shared_ptr<DataObject>>> kept;
+	for (int ii = ITEMS - 1; ii >= 0; ii--) {
+		if (ii % 3 == 0)
+			CPPUNIT_ASSERT(cpisync.delElem(added[ii]));
+		else
+			kept.insert(added[ii]);
+	}
+	CPPUNIT_ASSERT(!cpisync.delElem(added[0]));
+	CPPUNIT_ASSERT_EQUAL((long) kept.size(), cpisync.getNumElem());
+
+	multiset<shared_ptr<DataObject>, cmp<shared_ptr<DataObject>>> resultingElts(cpisync.beginElements(), cpisync.endElements());
+	vector<shared_ptr<DataObject>> diff;
+	rangeDiff(resultingElts.begin(), resultingElts.end(), kept.begin(), kept.end(), back_inserter(diff));
+	CPPUNIT_ASSERT(diff.empty());
+	CPPUNIT_ASSERT_EQUAL(kept.size(), resultingElts.size());
+}
+
+void CPISyncTest::testCPIAddElemsDuplicate() {
+	const int ITEMS = 20, EXTRA = 5;
+	vector<shared_ptr<DataObject>> batch;
+	for (int ii = 0; ii < ITEMS; ii++)
+		batch.push_back(make_shared<DataObject>(randZZ()));
+	vector<shared_ptr<DataObject>> withDup(batch);
+	withDup.insert(withDup.begin() + ITEMS / 2, make_shared<DataObject>(batch[0]->to_ZZ()));
+
+	// the duplicate is refused, and everything else is added, as when adding one at a time
+	auto bulk = make_shared<CPISync>(mBar, eltSizeSq, err, 0);
+	CPPUNIT_ASSERT(!bulk->addElems(withDup));
+	CPISync single(mBar, eltSizeSq, err, 0);
+	for (const auto &datum : withDup)
+		single.addElem(datum);
+	CPPUNIT_ASSERT_EQUAL(single.getNumElem(), bulk->getNumElem());
+
+	// the server has the batch and a few more elements, which are all that the client should receive
+	multiset<string> expected;
+	for (const auto &datum : withDup)
+		expected.insert(datum->print());
+	vector<shared_ptr<DataObject>> serverElems(batch);
+	for (int ii = 0; ii < EXTRA; ii++) {
+		serverElems.push_back(make_shared<DataObject>(randZZ()));
+		expected.insert(serverElems.back()->print());
+	}
+
+	GenSync client({make_shared<CommSocket>(port, host)}, {bulk});
+	GenSync server({make_shared<CommSocket>(port)}, {make_shared<CPISync>(mBar, eltSizeSq, err, 0)});
+	server.addElems(serverElems);
+	CPPUNIT_ASSERT(forkHandle(client, server).success);
+
+	multiset<string> resulting;
+	for (auto iter = bulk->beginElements(); iter != bulk->endElements(); ++iter)
+		resulting.insert((*iter)->print());
+	CPPUNIT_ASSERT(expected == resulting);
+}
+
 void CPISyncTest::CPISyncSetReconcileTest() {
 		GenSync GenSyncServer = GenSync::Builder().
 				setProtocol(GenSync::SyncProtocol::CPISync).
@@ -187,6 +427,131 @@ void CPISyncTest::ProbCPISyncLargeSetReconcileTest(){
 	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, true));
 }
 
+void CPISyncTest::testEuclideanRatFuncInterp() {
+	const long SAMPLES = 20;
+	const long COMMON = 7; // elements shared by both sets, which cancel out of the rational function
+	CPISyncInterp gauss(SAMPLES, RatFuncSolver::Gaussian);
+	CPISyncInterp euclid(SAMPLES, RatFuncSolver::Euclidean);
+
+	for (long total = 0; total <= SAMPLES; total++)
+		for (long selfOnly = 0; selfOnly <= total; selfOnly++) {
+			// distinct elements only in the numerator's set and only in the denominator's set
+			vector<ZZ> self, other;
+			for (long ii = 0; ii < total; ii++)
+				(ii < selfOnly ? self : other).push_back(to_ZZ(1 + ii * 1009 + rand() % 1000));
+			sort(self.begin(), self.end());
+			sort(other.begin(), other.end());
+
+			vec_ZZ_p evals;
+			evals.SetLength(SAMPLES);
+			for (long ii = 0; ii < SAMPLES; ii++) {
+				ZZ_p num(1), den(1);
+				for (const ZZ &elem : self)
+					num *= euclid.sampleLoc[ii] - to_ZZ_p(elem);
+				for (const ZZ &elem : other)
+					den *= euclid.sampleLoc[ii] - to_ZZ_p(elem);
+				evals[ii] = num / den;
+			}
+
+			const long mA = selfOnly + COMMON, mB = total - selfOnly + COMMON;
+			pair<vector<ZZ>, vector<ZZ>> fast = interpRoots(euclid, evals, mA, mB);
+			CPPUNIT_ASSERT(fast.first == self);
+			CPPUNIT_ASSERT(fast.second == other);
+			CPPUNIT_ASSERT(fast == interpRoots(gauss, evals, mA, mB));
+		}
+}
+
+void CPISyncTest::testFindRoots() {
+	const long ROOTS = 40;
+	CPISyncInterp cpisync(ROOTS, RatFuncSolver::Gaussian); // sets up the field
+
+	// distinct roots for the numerator, the denominator, and both
+	vector<ZZ> self, other, common;
+	for (long ii = 0; ii < 3 * ROOTS; ii++)
+		(ii % 3 == 0 ? self : ii % 3 == 1 ? other : common).push_back(to_ZZ(1 + ii * 1009 + rand() % 1000));
+	vec_ZZ_p selfRoots, otherRoots;
+	for (const ZZ &root : self)
+		append(selfRoots, to_ZZ_p(root));
+	for (const ZZ &root : other)
+		append(otherRoots, to_ZZ_p(root));
+	for (const ZZ &root : common) {
+		append(selfRoots, to_ZZ_p(root));
+		append(otherRoots, to_ZZ_p(root));
+	}
+
+	ZZ_pX P_poly = BuildFromRoots(selfRoots), Q_poly = BuildFromRoots(otherRoots);
+	vec_ZZ_p P_vec = VectorCopy(P_poly, deg(P_poly) + 1), Q_vec = VectorCopy(Q_poly, deg(Q_poly) + 1);
+	vec_ZZ_p numerator, denominator;
+	CPPUNIT_ASSERT(CPISyncInterp::find_roots(P_vec, Q_vec, numerator, denominator));
+
+	vector<ZZ> foundSelf, foundOther;
+	for (const ZZ_p &root : numerator)
+		foundSelf.push_back(rep(root));
+	for (const ZZ_p &root : denominator)
+		foundOther.push_back(rep(root));
+	sort(foundSelf.begin(), foundSelf.end());
+	sort(foundOther.begin(), foundOther.end());
+	CPPUNIT_ASSERT(foundSelf == self);
+	CPPUNIT_ASSERT(foundOther == other);
+
+	// a factor x^2 - r, for a quadratic non-residue r, has no roots
+	ZZ_p nonResidue(to_ZZ_p(2));
+	while (IsOne(power(nonResidue, (ZZ_p::modulus() - 1) / 2)))
+		nonResidue += 1;
+	ZZ_pX quadratic;
+	SetCoeff(quadratic, 2);
+	SetCoeff(quadratic, 0, -nonResidue);
+	ZZ_pX irreducible = quadratic * Q_poly;
+	vec_ZZ_p irreducible_vec = VectorCopy(irreducible, deg(irreducible) + 1);
+	CPPUNIT_ASSERT(!CPISyncInterp::find_roots(P_vec, irreducible_vec, numerator, denominator));
+}
+
+void CPISyncTest::CPISyncEuclideanSetReconcileTest() {
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::CPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(mBar).
+			setErr(err).
+			setEuclideanInterp(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::CPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(mBar).
+			setErr(err).
+			setEuclideanInterp(true).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void CPISyncTest::ProbCPISyncEuclideanSetReconcileTest() {
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::ProbCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(mBar).
+			setErr(err).
+			setEuclideanInterp(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::ProbCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(mBar).
+			setErr(err).
+			setEuclideanInterp(true).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
 //InterCPISync Test Cases
 
 void CPISyncTest::testInterCPIAddDelElem() {
@@ -244,6 +609,93 @@ void CPISyncTest::InterCPISyncSetReconcileTest() {
 	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
 }
 
+void CPISyncTest::InterCPISyncParallelSetReconcileTest() {
+	//A small mBar so that InterCPISync is forced to recurse
+	const int interCPImBar = 15;
+	const size_t subtreeConns = 2;
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setSubtreeConnections(subtreeConns).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setSubtreeConnections(subtreeConns).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void CPISyncTest::InterCPISyncBreadthFirstSetReconcileTest() {
+	//A small mBar so that InterCPISync is forced to recurse
+	const int interCPImBar = 15;
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setBreadthFirst(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setBreadthFirst(true).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+
+	checkBreadthFirstExchanges(false);
+}
+
+void CPISyncTest::InterCPISyncBreadthFirstMultisetReconcileTest() {
+	//A small mBar so that InterCPISync is forced to recurse
+	const int interCPImBar = 15;
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setErr(err).
+			setHashes(true).
+			setBreadthFirst(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(eltSize * 8). // Bytes to bits
+			setMbar(interCPImBar).
+			setNumPartitions(numParts).
+			setErr(err).
+			setHashes(true).
+			setBreadthFirst(true).
+			build();
+
+	//(oneWay = false, Multiset = true, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, true, false));
+
+	checkBreadthFirstExchanges(true);
+}
+
 void CPISyncTest::InterCPISyncMultisetReconcileTest() {
 	//A small mBar so that InterCPISync is forced to recurse
 	const int interCPImBar = 15;
@@ -299,4 +751,23 @@ void CPISyncTest::InterCPISyncLargeSetReconcileTest() {
 
 	//(oneWay = false, Multiset = false, largeSync = true)
 	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, true));
-}
\ No newline at end of file
+}
+void CPISyncTest::ProbCPISyncMultiRoundTest() {
+	// 24 differences take bounds of 1, 2, 4, 8, 16 and 32
+	vector<shared_ptr<DataObject>> shared = newElems(50), serverOnly = newElems(12), clientOnly = newElems(12);
+	vector<shared_ptr<DataObject>> serverElems(shared);
+	serverElems.insert(serverElems.end(), serverOnly.begin(), serverOnly.end());
+
+	checkProbSync(*probPeer(serverElems), shared, serverOnly, clientOnly);
+}
+
+void CPISyncTest::ProbCPISyncRepeatedTest() {
+	vector<shared_ptr<DataObject>> shared = newElems(50), serverOnly = newElems(6);
+	vector<shared_ptr<DataObject>> serverElems(shared);
+	serverElems.insert(serverElems.end(), serverOnly.begin(), serverOnly.end());
+	auto server = probPeer(serverElems);
+
+	// many differences, then fewer than the last sync's final bound, then many again
+	for (int clientOnly : {24, 3, 40})
+		checkProbSync(*server, shared, serverOnly, newElems(clientOnly));
+}
@@ -15,14 +15,25 @@ class CPISyncTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST_SUITE(CPISyncTest);
 
 	CPPUNIT_TEST(testCPIAddDelElem);
+	CPPUNIT_TEST(testCPIDelElemAnyOrder);
+	CPPUNIT_TEST(testCPIAddElemsDuplicate);
 	CPPUNIT_TEST(CPISyncSetReconcileTest);
 	CPPUNIT_TEST(CPISyncMultisetReconcileTest);
 	CPPUNIT_TEST(CPISyncLargeSetReconcileTest);
 	CPPUNIT_TEST(ProbCPISyncSetReconcileTest);
 	CPPUNIT_TEST(ProbCPISyncMultisetReconcileTest);
 	CPPUNIT_TEST(ProbCPISyncLargeSetReconcileTest);
+	CPPUNIT_TEST(ProbCPISyncMultiRoundTest);
+	CPPUNIT_TEST(ProbCPISyncRepeatedTest);
+	CPPUNIT_TEST(testEuclideanRatFuncInterp);
+	CPPUNIT_TEST(testFindRoots);
+	CPPUNIT_TEST(CPISyncEuclideanSetReconcileTest);
+	CPPUNIT_TEST(ProbCPISyncEuclideanSetReconcileTest);
 	CPPUNIT_TEST(testInterCPIAddDelElem);
 	CPPUNIT_TEST(InterCPISyncSetReconcileTest);
+	CPPUNIT_TEST(InterCPISyncParallelSetReconcileTest);
+	CPPUNIT_TEST(InterCPISyncBreadthFirstSetReconcileTest);
+	CPPUNIT_TEST(InterCPISyncBreadthFirstMultisetReconcileTest);
 	CPPUNIT_TEST(InterCPISyncMultisetReconcileTest);
 	CPPUNIT_TEST(InterCPISyncLargeSetReconcileTest);
 
@@ -42,6 +53,17 @@ public:
 	 */
 	static void testCPIAddDelElem();
 
+	/**
+	 * Test deleting some of the elements of a CPISync, in an order unrelated to their addition
+	 */
+	static void testCPIDelElemAnyOrder();
+
+	/**
+	 * Test that a batch with a duplicate in its middle, which CPISync refuses without hashing, still adds every other
+	 * element of the batch, as adding them one at a time does, so that a later sync finds only the real differences
+	 */
+	static void testCPIAddElemsDuplicate();
+
 	/**
  	* Test a synchronization of sets with CPISync
 	 * CPISync does have a very small probability of failure but is not a probabilistic sync because it doesn't do partial reconcilliation
@@ -82,6 +104,40 @@ public:
 	 */
 	static void ProbCPISyncLargeSetReconcileTest();
 
+	/**
+	 * Test a ProbCPISync whose differences exceed the bound of its first rounds, so that the server extends the
+	 * evaluations and sample point powers of earlier rounds; it must find what a fresh server finds
+	 */
+	static void ProbCPISyncMultiRoundTest();
+
+	/**
+	 * Test one ProbCPISync server synced with several clients in turn, so that each sync starts with the state left
+	 * by a sync with other differences; each must find what a fresh server finds
+	 */
+	static void ProbCPISyncRepeatedTest();
+
+	/**
+	 * Test that the Euclidean interpolation recovers the same differences as the Gaussian one, for one-sided and
+	 * two-sided differences, up to as many differences as there are sample points
+	 */
+	static void testEuclideanRatFuncInterp();
+
+	/**
+	 * Test that find_roots recovers the distinct roots of a numerator and denominator that split into
+	 * linear factors, after cancelling common factors, and fails when one of them does not split
+	 */
+	static void testFindRoots();
+
+	/**
+	 * Test a synchronization of sets with CPISync, interpolating with the extended Euclidean algorithm
+	 */
+	static void CPISyncEuclideanSetReconcileTest();
+
+	/**
+	 * Test a synchronization of sets with ProbCPISync, interpolating with the extended Euclidean algorithm
+	 */
+	static void ProbCPISyncEuclideanSetReconcileTest();
+
 	//InterCPISync Test cases
 
 	/**
@@ -100,6 +156,19 @@ public:
  	*/
 	static void InterCPISyncSetReconcileTest();
 
+	/**
+	 * Test a synchronization of sets with InterCPISync, synchronizing the partitions of the root over extra connections
+	 */
+	static void InterCPISyncParallelSetReconcileTest();
+
+	/**
+	 * Test synchronizations of sets and of multisets with InterCPISync, synchronizing each depth of the tree in one round trip.
+	 * Also checks that their bytes are counted, and that their exchanges grow with the depth of the tree rather than the
+	 * number of nodes synchronized
+	 */
+	static void InterCPISyncBreadthFirstSetReconcileTest();
+	static void InterCPISyncBreadthFirstMultisetReconcileTest();
+
 	/**
  	 * Test a synchronization with InterCPISync
  	*/
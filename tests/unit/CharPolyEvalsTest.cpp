@@ -0,0 +1,123 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#include "CharPolyEvalsTest.h"
+#include <CPISync/Aux/Auxiliary.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CharPolyEvalsTest);
+
+CharPolyEvalsTest::CharPolyEvalsTest() = default;
+
+CharPolyEvalsTest::~CharPolyEvalsTest() = default;
+
+void CharPolyEvalsTest::setUp() {
+    const int SEED = 617;
+    srand(SEED);
+}
+
+void CharPolyEvalsTest::tearDown() {}
+
+namespace {
+    // @return sample points just above 2^bits, in a prime field just above those, as CPISync chooses them
+    vec_ZZ_p samplesAbove(long bits, long num) {
+        ZZ dataMax = power(ZZ_TWO, bits);
+        ZZ_p::init(NextPrime(dataMax + num));
+        vec_ZZ_p res;
+        res.SetLength(num);
+        for (long ii = 0; ii < num; ii++)
+            res[ii] = to_ZZ_p(dataMax) + ii + 1;
+        return res;
+    }
+}
+
+void CharPolyEvalsTest::testBackendChoice() {
+    const long SAMPLES = 4;
+    for (long bits : {8, 32, 61})
+        CPPUNIT_ASSERT(CharPolyEvals::make(samplesAbove(bits, SAMPLES))->wordSized());
+    for (long bits : {63, 64, 128})
+        CPPUNIT_ASSERT(!CharPolyEvals::make(samplesAbove(bits, SAMPLES))->wordSized());
+}
+
+void CharPolyEvalsTest::testAddRemove() {
+    const long SAMPLES = 30;
+    const int ELEMS = 100;
+
+    for (long bits : {16, 32, 61, 62, 80}) {
+        vec_ZZ_p samples = samplesAbove(bits, SAMPLES);
+        unique_ptr<CharPolyEvals> evals = CharPolyEvals::make(samples);
+        CPPUNIT_ASSERT_EQUAL(SAMPLES, evals->length());
+
+        // add elements, and remove every other one
+        vector<ZZ_p> elems;
+        for (int ii = 0; ii < ELEMS; ii++) {
+            elems.push_back(to_ZZ_p(RandomBits_ZZ(bits)));
+            evals->add(elems.back());
+        }
+        vector<ZZ_p> kept;
+        for (int ii = 0; ii < ELEMS; ii++)
+            if (ii % 2 == 0)
+                evals->remove(elems[ii]);
+            else
+                kept.push_back(elems[ii]);
+
+        for (long ii = 0; ii < SAMPLES; ii++) {
+            ZZ_p expected(to_ZZ_p(1));
+            for (const ZZ_p &elem : kept)
+                expected *= samples[ii] - elem;
+            CPPUNIT_ASSERT_EQUAL(expected, evals->get(ii));
+        }
+
+        for (const ZZ_p &elem : kept)
+            evals->remove(elem);
+        for (long ii = 0; ii < SAMPLES; ii++)
+            CPPUNIT_ASSERT(IsOne(evals->get(ii)));
+    }
+}
+
+void CharPolyEvalsTest::testAddAll() {
+    const long SAMPLES = 83;
+    const int ELEMS = 2000;
+
+    for (long bits : {32, 61, 80}) {
+        vec_ZZ_p samples = samplesAbove(bits, SAMPLES);
+        vector<ZZ_p> elems;
+        for (int ii = 0; ii < ELEMS; ii++)
+            elems.push_back(to_ZZ_p(RandomBits_ZZ(bits)));
+
+        unique_ptr<CharPolyEvals> single = CharPolyEvals::make(samples);
+        for (const ZZ_p &elem : elems)
+            single->add(elem);
+
+        for (unsigned threads : {1, 3, 0}) {
+            unique_ptr<CharPolyEvals> bulk = CharPolyEvals::make(samples);
+            bulk->add(elems[0]); // bulk additions continue from earlier ones
+            bulk->addAll(vector<ZZ_p>(elems.begin() + 1, elems.end()), threads);
+            for (long ii = 0; ii < SAMPLES; ii++)
+                CPPUNIT_ASSERT_EQUAL(single->get(ii), bulk->get(ii));
+        }
+    }
+}
+
+void CharPolyEvalsTest::testEmptyCopy() {
+    const long SAMPLES = 20;
+
+    for (long bits : {32, 80}) {
+        vec_ZZ_p samples = samplesAbove(bits, SAMPLES);
+        unique_ptr<CharPolyEvals> evals = CharPolyEvals::make(samples);
+        ZZ_p elem = to_ZZ_p(RandomBits_ZZ(bits));
+        evals->add(elem);
+
+        unique_ptr<CharPolyEvals> copy = evals->emptyCopy();
+        CPPUNIT_ASSERT_EQUAL(SAMPLES, copy->length());
+        CPPUNIT_ASSERT_EQUAL(evals->wordSized(), copy->wordSized());
+        for (long ii = 0; ii < SAMPLES; ii++)
+            CPPUNIT_ASSERT(IsOne(copy->get(ii)));
+
+        // the copy evaluates at the same points, and changes to it leave the original alone
+        ZZ_p other = to_ZZ_p(RandomBits_ZZ(bits));
+        copy->add(other);
+        for (long ii = 0; ii < SAMPLES; ii++) {
+            CPPUNIT_ASSERT_EQUAL(samples[ii] - other, copy->get(ii));
+            CPPUNIT_ASSERT_EQUAL(samples[ii] - elem, evals->get(ii));
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef CPISYNCLIB_CHARPOLYEVALSTEST_H
+#define CPISYNCLIB_CHARPOLYEVALSTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <CPISync/Syncs/CharPolyEvals.h>
+
+class CharPolyEvalsTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(CharPolyEvalsTest);
+
+    CPPUNIT_TEST(testBackendChoice);
+    CPPUNIT_TEST(testAddRemove);
+    CPPUNIT_TEST(testAddAll);
+    CPPUNIT_TEST(testEmptyCopy);
+
+    CPPUNIT_TEST_SUITE_END();
+public:
+    CharPolyEvalsTest();
+
+    ~CharPolyEvalsTest() override;
+    void setUp() override;
+    void tearDown() override;
+
+    /**
+     * Tests that word-sized arithmetic is chosen exactly for the moduli that fit in a word
+     */
+    static void testBackendChoice();
+
+    /**
+     * Tests that adding and removing elements gives the evaluations computed directly in ZZ_p,
+     * for moduli of various sizes, and that removing every element brings all evaluations back to 1
+     */
+    static void testAddRemove();
+
+    /**
+     * Tests that adding elements in bulk, with one or several threads, gives the same evaluations
+     * as adding them one by one, whether or not the sample points split evenly among the threads
+     */
+    static void testAddAll();
+
+    /**
+     * Tests that an empty copy starts from the empty set at the same sample points, independently of the original
+     */
+    static void testEmptyCopy();
+};
+
+#endif //CPISYNCLIB_CHARPOLYEVALSTEST_H
@@ -324,3 +324,40 @@ void CommunicantTest::testCommZZNoArgs(){
         CPPUNIT_ASSERT_EQUAL(exp, cRecv.commRecv_ZZ());
     }
 }
+
+void CommunicantTest::testCommIBLT() {
+    const int NUM_ELEMS = 3000; // enough cells for several IBLT_CHUNK_BYTES chunks
+    const size_t ELT_SIZE = sizeof(ZZ);
+    queue<char> qq;
+    CommDummy cSend(&qq);
+    CommDummy cRecv(&qq);
+
+    IBLT iblt(NUM_ELEMS, ELT_SIZE);
+    IBLTMultiset multi(NUM_ELEMS, ELT_SIZE);
+    IBLTFlat flat(NUM_ELEMS, ELT_SIZE);
+    for (int ii = 0; ii < NUM_ELEMS; ii++) {
+        ZZ item = randZZ();
+        iblt.insert(item, item);
+        multi.insert(item, item);
+        flat.insert(item, item);
+    }
+    iblt.hashes = {1, 2, 3}; // the IBLTSetOfSets trailer is sent after the cells
+
+    // the streamed bytes are exactly the length-prefixed byte representation
+    vector<byte> ibltBytes = iblt.toByteVector();
+    cSend.resetCommCounters();
+    cSend.commSend(iblt);
+    CPPUNIT_ASSERT_EQUAL(3 * sizeof(long) + ibltBytes.size(), (size_t) cSend.getXmitBytes());
+    IBLT ibltRecv = cRecv.commRecv_IBLT();
+    CPPUNIT_ASSERT(ibltBytes == ibltRecv.toByteVector());
+    CPPUNIT_ASSERT(iblt.hashes == ibltRecv.hashes);
+
+    cSend.commSend(multi, true);
+    IBLTMultiset multiRecv = cRecv.commRecv_IBLTMultiset(multi.size(), multi.eltSize());
+    CPPUNIT_ASSERT(multi.toByteVector() == multiRecv.toByteVector());
+
+    cSend.commSend(flat);
+    IBLTFlat flatRecv = cRecv.commRecv_IBLTFlat();
+    CPPUNIT_ASSERT(flat.toByteVector() == flatRecv.toByteVector());
+    CPPUNIT_ASSERT(qq.empty());
+}
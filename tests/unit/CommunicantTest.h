@@ -30,6 +30,7 @@ class CommunicantTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testCommVec_ZZ_p);
     CPPUNIT_TEST(testCommZZ);
     CPPUNIT_TEST(testCommZZNoArgs);
+    CPPUNIT_TEST(testCommIBLT);
     
     CPPUNIT_TEST_SUITE_END();
 
@@ -127,6 +128,11 @@ private:
  	*/
     void testCommZZNoArgs();
 
+	/**
+ 	* Tests commSend and Recv for IBLT, IBLTMultiset and IBLTFlat tables that span several send chunks
+ 	*/
+    static void testCommIBLT();
+
     
 
 };
@@ -75,3 +75,57 @@ void Compact2DBitArrayTest::readWriteTest() {
     for (size_t f=MIN_F_SIZE_TESTED; f<=MAX_F_SIZE_TESTED; f++)
         _test_various_columns_rows(f);
 }
+
+void Compact2DBitArrayTest::findEntryTest() {
+    for (size_t f=MIN_F_SIZE_TESTED; f<=MAX_F_SIZE_TESTED; f++)
+        for (size_t bSize=MIN_COLUMNS_TESTED; bSize<=MAX_COLUMNS_TESTED; bSize++) {
+            const size_t rows = MAX_ROWS_TESTED;
+            auto a = Compact2DBitArray(f, bSize, rows);
+
+            // few distinct values, so that buckets hold repeats and misses
+            vector<size_t> toAdd = _gen_range(min<size_t>((1LU << f) - 1, 8), bSize * rows);
+            _setEntries(a, toAdd);
+
+            for (size_t ii=0; ii<rows; ii++)
+                for (unsigned val=0; val<=8 && val < (1LU << f); val++) {
+                    Nullable<size_t> found = a.findEntry(ii, val);
+                    size_t jj = 0;
+                    while (jj < bSize && a.getEntry(ii, jj) != val)
+                        jj++;
+                    if (jj == bSize)
+                        CPPUNIT_ASSERT(found.isNullQ());
+                    else
+                        CPPUNIT_ASSERT_EQUAL(jj, *found);
+                }
+        }
+}
+
+void Compact2DBitArrayTest::rawLayoutTest() {
+    for (size_t f : {8, 12, 16})
+        for (size_t bSize=MIN_COLUMNS_TESTED; bSize<=MAX_COLUMNS_TESTED; bSize++) {
+            const size_t rows = MAX_ROWS_TESTED;
+            vector<size_t> toAdd = _gen_range((1LU << f) - 1, bSize * rows);
+
+            auto words = Compact2DBitArray(f, bSize, rows);
+            CPPUNIT_ASSERT_EQUAL(Compact2DBitArray::wordLayout(f, bSize) && f * bSize > 32, !words.words.empty());
+            // buckets of at most 32 bits take 32-bit words
+            CPPUNIT_ASSERT_EQUAL(Compact2DBitArray::wordLayout(f, bSize) && f * bSize <= 32,
+                                 !words.narrowWords.empty());
+            _setEntries(words, toAdd);
+
+            // the packed layout, over storage of its own
+            vector<unsigned char> storage(Compact2DBitArray::storageBytes(f, bSize, rows));
+            auto packed = Compact2DBitArray(f, bSize, rows, storage.data());
+            _setEntries(packed, toAdd);
+
+            CPPUNIT_ASSERT(words.getRaw() == packed.getRaw());
+
+            auto rebuilt = Compact2DBitArray(f, bSize, rows, words.getRaw());
+            auto added = _getEntries(rebuilt);
+            _assert_vectors_equal(toAdd, added);
+
+            auto copied = Compact2DBitArray(packed);
+            added = _getEntries(copied);
+            _assert_vectors_equal(toAdd, added);
+        }
+}
@@ -25,6 +25,8 @@ static const size_t MIN_F_SIZE_TESTED = 1,
 class Compact2DBitArrayTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST_SUITE(Compact2DBitArrayTest);
     CPPUNIT_TEST(readWriteTest);
+    CPPUNIT_TEST(findEntryTest);
+    CPPUNIT_TEST(rawLayoutTest);
     CPPUNIT_TEST_SUITE_END();
 public:
     Compact2DBitArrayTest();
@@ -36,6 +38,14 @@ public:
     // X columns count [MIN_COLUMNS_TESTED..MAX_COLUMNS_TESTED]
     // X rows count [MIN_ROWS_TESTED..MAX_ROWS_TESTED]
     static void readWriteTest();
+
+    // findEntry agrees with a search through getEntry, for the same
+    // dimensions as readWriteTest
+    static void findEntryTest();
+
+    // arrays in the word layout have the same raw content as arrays in
+    // the packed layout, and are reconstructed from it
+    static void rawLayoutTest();
 };
 
 #endif // COMPACT2DBITARRAYTEST_H
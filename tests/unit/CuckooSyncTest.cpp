@@ -6,12 +6,90 @@
  * Created on Mar, 2020.
  */
 
+#include <thread>
 #include "CuckooSyncTest.h"
 #include "TestAuxiliary.h"
 #include <CPISync/Syncs/GenSync.h>
+#include <CPISync/Syncs/CuckooSync.h>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CuckooSyncTest);
 
+namespace {
+    // Cuckoo parameters of the delta tests; fingerprints long enough
+    // that a false positive, which would hide a difference, is unlikely
+    const size_t DELTA_FNGPRT = 24;
+    const size_t DELTA_BUCKET = 4;
+    const size_t DELTA_FILTER = 1 << 10;
+    const int DELTA_SHARED = 1000; // elements common to all peers
+    const int DELTA_NEW = 5;       // elements added to a peer between syncs
+
+    // the first of the ports used by the delta tests, one per sync
+    int deltaPort = 8301;
+
+    // @return a CuckooSync with delta transfer, holding elems
+    shared_ptr<CuckooSync> deltaPeer(const vector<shared_ptr<DataObject>>& elems) {
+        auto peer = make_shared<CuckooSync>(DELTA_FNGPRT, DELTA_BUCKET, DELTA_FILTER,
+                                            Cuckoo::DEFAULT_MAX_KICKS, true);
+        for (const auto& elem : elems)
+            peer->addElem(elem);
+        return peer;
+    }
+
+    // @return num new random elements
+    vector<shared_ptr<DataObject>> newElems(int num) {
+        vector<shared_ptr<DataObject>> res;
+        for (int ii=0; ii<num; ii++)
+            res.push_back(make_shared<DataObject>(randZZ()));
+        return res;
+    }
+
+    // @return the elements of peer, printed
+    multiset<string> elemsOf(CuckooSync& peer) {
+        multiset<string> res;
+        for (auto iter = peer.beginElements(); iter != peer.endElements(); ++iter)
+            res.insert((*iter)->print());
+        return res;
+    }
+
+    /**
+     * Syncs two CuckooSyncs over a socket, with the server on a thread
+     * of this process, so that both keep their state between syncs,
+     * as long-lived peers do. Adds the differences found to each.
+     * @return The bytes that the client sent and received, or -1 if
+     * the sync failed
+     */
+    long syncPeers(CuckooSync& client, CuckooSync& server) {
+        int port = deltaPort++;
+        auto clientComm = make_shared<CommSocket>(port, host);
+        auto serverComm = make_shared<CommSocket>(port);
+        list<shared_ptr<DataObject>> clientSMO, clientOMS, serverSMO, serverOMS;
+
+        bool serverOK = false;
+        std::thread serverThread([&]() {
+            try {
+                serverOK = server.SyncServer(serverComm, serverSMO, serverOMS);
+            } catch (const std::exception&) {
+                serverOK = false;
+            }
+        });
+        bool clientOK = client.SyncClient(clientComm, clientSMO, clientOMS);
+        serverThread.join();
+        if (!clientOK || !serverOK)
+            return -1;
+
+        for (const auto& elem : clientOMS)
+            client.addElem(elem);
+        for (const auto& elem : serverOMS)
+            server.addElem(elem);
+        return long(clientComm->getXmitBytesTot() + clientComm->getRecvBytesTot());
+    }
+
+    // @return the bytes of a whole filter of the delta tests
+    long filterBytes() {
+        return long(Compact2DBitArray::storageBytes(DELTA_FNGPRT, DELTA_BUCKET, DELTA_FILTER));
+    }
+}
+
 CuckooSyncTest::CuckooSyncTest() = default;
 
 CuckooSyncTest::~CuckooSyncTest() = default;
@@ -60,3 +138,126 @@ void CuckooSyncTest::setReconcileTest() {
 
     CPPUNIT_ASSERT(syncTest(client, server, false, false, false));
 }
+
+void CuckooSyncTest::deltaReconcileTest() {
+    const size_t bits = sizeof(randZZ());
+    const size_t fngprtSize = 12;
+    const size_t bucketSize = 4;
+    const size_t filterSize = UCHAR_MAX + 1; // UCHAR_MAX is taken from syncTest
+    const size_t maxKicks = 500;
+
+    GenSync server = GenSync::Builder()
+        .setProtocol(GenSync::SyncProtocol::CuckooSync)
+        .setComm(GenSync::SyncComm::socket)
+        .setBits(bits)
+        .setFngprtSize(fngprtSize)
+        .setBucketSize(bucketSize)
+        .setFilterSize(filterSize)
+        .setMaxKicks(maxKicks)
+        .setDeltaTransfer(true)
+        .build();
+
+    GenSync client = GenSync::Builder()
+        .setProtocol(GenSync::SyncProtocol::CuckooSync)
+        .setComm(GenSync::SyncComm::socket)
+        .setBits(bits)
+        .setFngprtSize(fngprtSize)
+        .setBucketSize(bucketSize)
+        .setFilterSize(filterSize)
+        .setMaxKicks(maxKicks)
+        .setDeltaTransfer(true)
+        .build();
+
+    ZZ_p::init(randZZ()); // see setReconcileTest
+
+    CPPUNIT_ASSERT(syncTest(client, server, false, false, false));
+}
+
+void CuckooSyncTest::deltaRepeatedSyncTest() {
+    vector<shared_ptr<DataObject>> shared = newElems(DELTA_SHARED);
+    auto client = deltaPeer(shared);
+    auto server = deltaPeer(shared);
+
+    // the first sync sends both filters whole
+    for (const auto& elem : newElems(DELTA_NEW))
+        client->addElem(elem);
+    for (const auto& elem : newElems(DELTA_NEW))
+        server->addElem(elem);
+    long first = syncPeers(*client, *server);
+    CPPUNIT_ASSERT(first > 2 * filterBytes());
+    CPPUNIT_ASSERT(elemsOf(*client) == elemsOf(*server));
+
+    // later ones send the buckets changed since, both by the new
+    // elements and by those received in the previous sync
+    for (int round=0; round<2; round++) {
+        for (const auto& elem : newElems(DELTA_NEW))
+            client->addElem(elem);
+        for (const auto& elem : newElems(DELTA_NEW))
+            server->addElem(elem);
+        long later = syncPeers(*client, *server);
+        CPPUNIT_ASSERT(later > 0);
+        CPPUNIT_ASSERT(later < first / 4);
+        CPPUNIT_ASSERT(elemsOf(*client) == elemsOf(*server));
+    }
+}
+
+void CuckooSyncTest::deltaThreePeersTest() {
+    vector<shared_ptr<DataObject>> shared = newElems(DELTA_SHARED);
+    auto hub = deltaPeer(shared);
+    auto first = deltaPeer(shared);
+    auto second = deltaPeer(shared);
+
+    for (const auto& elem : newElems(DELTA_NEW))
+        first->addElem(elem);
+    CPPUNIT_ASSERT(syncPeers(*hub, *first) > 0);
+    CPPUNIT_ASSERT(elemsOf(*hub) == elemsOf(*first));
+
+    // the hub's delta is from the filter that first has, not second
+    for (const auto& elem : newElems(DELTA_NEW))
+        hub->addElem(elem);
+    CPPUNIT_ASSERT(syncPeers(*hub, *second) > 2 * filterBytes());
+    CPPUNIT_ASSERT(elemsOf(*hub) == elemsOf(*second));
+
+    // and now from the one that second has, not first; the hub also
+    // holds second's filter, not first's
+    for (const auto& elem : newElems(DELTA_NEW))
+        hub->addElem(elem);
+    for (const auto& elem : newElems(DELTA_NEW))
+        first->addElem(elem);
+    CPPUNIT_ASSERT(syncPeers(*hub, *first) > 2 * filterBytes());
+    CPPUNIT_ASSERT(elemsOf(*hub) == elemsOf(*first));
+}
+
+void CuckooSyncTest::snapshotResumeTest() {
+    const string fileName = temporaryDir() + "/CuckooSyncSnapshot." + toStr(getpid());
+    remove(fileName.c_str());
+    vector<shared_ptr<DataObject>> shared = newElems(DELTA_SHARED);
+
+    {
+        CuckooSync first(DELTA_FNGPRT, DELTA_BUCKET, DELTA_FILTER,
+                         Cuckoo::DEFAULT_MAX_KICKS, false, fileName);
+        CPPUNIT_ASSERT(!first.resumed());
+        for (const auto& elem : shared)
+            first.addElem(elem);
+    } // closing flushes the filter
+
+    CuckooSync restarted(DELTA_FNGPRT, DELTA_BUCKET, DELTA_FILTER,
+                         Cuckoo::DEFAULT_MAX_KICKS, false, fileName);
+    CPPUNIT_ASSERT(restarted.resumed());
+    for (const auto& elem : shared)
+        restarted.addElem(elem);
+    restarted.endReplay(); // the elements added from now on are new to the filter
+    for (const auto& elem : newElems(DELTA_NEW))
+        restarted.addElem(elem);
+
+    CuckooSync peer(DELTA_FNGPRT, DELTA_BUCKET, DELTA_FILTER, Cuckoo::DEFAULT_MAX_KICKS);
+    for (const auto& elem : shared)
+        peer.addElem(elem);
+    for (const auto& elem : newElems(DELTA_NEW))
+        peer.addElem(elem);
+
+    CPPUNIT_ASSERT(syncPeers(restarted, peer) > 0);
+    CPPUNIT_ASSERT(elemsOf(restarted) == elemsOf(peer));
+
+    remove(fileName.c_str());
+}
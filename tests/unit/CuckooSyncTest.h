@@ -14,6 +14,10 @@
 class CuckooSyncTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST_SUITE(CuckooSyncTest);
     CPPUNIT_TEST(setReconcileTest);
+    CPPUNIT_TEST(deltaReconcileTest);
+    CPPUNIT_TEST(deltaRepeatedSyncTest);
+    CPPUNIT_TEST(deltaThreePeersTest);
+    CPPUNIT_TEST(snapshotResumeTest);
     CPPUNIT_TEST_SUITE_END();
  public:
     CuckooSyncTest();
@@ -22,6 +26,32 @@ class CuckooSyncTest : public CPPUNIT_NS::TestFixture {
     void tearDown() override;
 
     void setReconcileTest();
+
+    /**
+     * Reconciles with filters sent as deltas, which the first sync
+     * between two peers sends whole.
+     */
+    void deltaReconcileTest();
+
+    /**
+     * Syncs the same pair of peers repeatedly, with new elements on
+     * both sides in between. Later syncs send deltas, and must
+     * reconcile with a fraction of the bytes of the first.
+     */
+    void deltaRepeatedSyncTest();
+
+    /**
+     * Syncs one peer with two others in turn, so that each of them
+     * lacks the base of the peer's next delta, and the whole filter
+     * must be sent instead.
+     */
+    void deltaThreePeersTest();
+
+    /**
+     * Restarts a CuckooSync whose filter is kept in a snapshot file,
+     * adds its elements back, and syncs it with a peer.
+     */
+    void snapshotResumeTest();
 };
 
 #endif // CPISYNCLIB_CUCKOOSYNCTEST_H
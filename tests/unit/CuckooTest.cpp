@@ -6,6 +6,7 @@
  * Created on Mar, 2020.
  */
 
+#include <cstdio>
 #include "CuckooTest.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CuckooTest);
@@ -242,6 +243,26 @@ void CuckooTest::testLookup() {
     CPPUNIT_ASSERT(falsePositives <= 30);
 }
 
+void CuckooTest::testLookupAll() {
+    for (size_t f : {9, 12}) {
+        Cuckoo c = Cuckoo(f, 4, (1 << 12), 500);
+        size_t rndRange = 1 << 16;
+        _populate(c, 1 << 12, rndRange);
+
+        // items from the range of the inserted ones, enough for two threads
+        vector<shared_ptr<DataObject>> batch;
+        for (size_t ii=0; ii<(1 << 15) + 3; ii++)
+            batch.push_back(make_shared<DataObject>(to_ZZ(Cuckoo::_rand(0, rndRange))));
+
+        for (unsigned threads : {1, 4}) {
+            vector<unsigned char> found = c.lookupAll(batch.begin(), batch.end(), threads);
+            CPPUNIT_ASSERT_EQUAL(batch.size(), found.size());
+            for (size_t ii=0; ii<batch.size(); ii++)
+                CPPUNIT_ASSERT_EQUAL(c.lookup(*batch[ii]), found[ii] != 0);
+        }
+    }
+}
+
 void CuckooTest::testErase() {
     auto f = [](const ZZ& x, size_t fngprtSize) {
                  return to_int(x) & ((1 << fngprtSize) - 1);
@@ -338,3 +359,162 @@ void CuckooTest::testErase() {
     int afterErasePos = static_cast<int>(lookupDeletedSucceeds - problemsF.size() - legitFP);
     CPPUNIT_ASSERT_EQUAL(0, afterErasePos);
 }
+
+void CuckooTest::testSnapshot() {
+    const size_t items = 1 << 12;
+    const string fileName = temporaryDir() + "/CuckooSnapshot." + toStr(getpid());
+    remove(fileName.c_str());
+
+    vector<DataObject> inserted;
+    vector<unsigned char> raw;
+    {
+        Cuckoo c(fileName, 12, 4, items / 2, Cuckoo::DEFAULT_MAX_KICKS);
+        CPPUNIT_ASSERT(!c.resumed());
+        for (size_t ii=0; ii<items; ii++) {
+            DataObject dObj = DataObject(ZZ(Cuckoo::_rand(0, (1 << 30))));
+            if (c.insert(dObj))
+                inserted.push_back(dObj);
+        }
+        CPPUNIT_ASSERT(c.erase(inserted.back()));
+        inserted.pop_back();
+
+        // a copy is held in memory, so changing it leaves the file alone
+        Cuckoo copy(c);
+        CPPUNIT_ASSERT(copy.erase(inserted.front()));
+        CPPUNIT_ASSERT(c.lookup(inserted.front()));
+
+        raw = c.getRawFilter();
+    } // closing flushes
+
+    {
+        Cuckoo resumed(fileName, 12, 4, items / 2, Cuckoo::DEFAULT_MAX_KICKS);
+        CPPUNIT_ASSERT(resumed.resumed());
+        CPPUNIT_ASSERT(raw == resumed.getRawFilter());
+        CPPUNIT_ASSERT_EQUAL(ZZ(inserted.size()), resumed.getItemsCount());
+        for (const auto& dObj : inserted)
+            CPPUNIT_ASSERT(resumed.lookup(dObj));
+    }
+
+    // a snapshot of other sizes starts over
+    Cuckoo other(fileName, 12, 4, items, Cuckoo::DEFAULT_MAX_KICKS);
+    CPPUNIT_ASSERT(!other.resumed());
+    CPPUNIT_ASSERT_EQUAL(ZZ(0), other.getItemsCount());
+
+    remove(fileName.c_str());
+}
+
+void CuckooTest::testDelta() {
+    for (size_t f : {7, 12, 20}) {
+        Cuckoo c = Cuckoo(f, 4, (1 << 10), 500);
+        vector<DataObject> inserted;
+        for (size_t ii=0; ii<(1 << 11); ii++) {
+            DataObject dObj = DataObject(ZZ(Cuckoo::_rand(0, (1 << 30))));
+            if (c.insert(dObj))
+                inserted.push_back(dObj);
+        }
+        c.trackChanges(true);
+        CPPUNIT_ASSERT(!c.hasChanges());
+        Cuckoo peer(c);
+
+        // a few changes, to a few buckets
+        for (size_t ii=0; ii<16; ii++)
+            c.insert(DataObject(ZZ(Cuckoo::_rand(0, (1 << 30)))));
+        for (size_t ii=0; ii<16; ii++)
+            CPPUNIT_ASSERT(c.erase(inserted[ii]));
+        CPPUNIT_ASSERT(c.hasChanges());
+
+        vector<byte> delta = c.deltaToByteVector();
+        CPPUNIT_ASSERT(delta.size() < c.toByteVector().size() / 4);
+
+        // a malformed delta changes nothing
+        vector<byte> cut(delta.begin(), delta.end() - 1);
+        CPPUNIT_ASSERT_THROW(peer.applyDelta(cut), runtime_error);
+        CPPUNIT_ASSERT(c.getRawFilter() != peer.getRawFilter());
+
+        peer.applyDelta(delta);
+        CPPUNIT_ASSERT(c.getRawFilter() == peer.getRawFilter());
+        CPPUNIT_ASSERT_EQUAL(c.getItemsCount(), peer.getItemsCount());
+
+        // once cleared, the delta is empty, and applying it changes nothing
+        c.clearChanges();
+        CPPUNIT_ASSERT(!c.hasChanges());
+        peer.applyDelta(c.deltaToByteVector());
+        CPPUNIT_ASSERT(c.getRawFilter() == peer.getRawFilter());
+        CPPUNIT_ASSERT_EQUAL(c.getItemsCount(), peer.getItemsCount());
+    }
+}
+
+void CuckooTest::testAlternativeBucket() {
+    Cuckoo c = Cuckoo(12, 4, 1000, 500);
+    for (size_t b=0; b<1000; b++)
+        for (size_t f=1; f<(1 << 12); f+=37)
+            CPPUNIT_ASSERT_EQUAL(b, c._alternativeBucket(c._alternativeBucket(b, f), f));
+
+    for (size_t ii=0; ii<(1 << 10); ii++) {
+        Cuckoo::PartialHash p = c._pHash(DataObject(ZZ(Cuckoo::_rand(0, (1 << 30)))));
+        CPPUNIT_ASSERT(p.i1 < 1000 && p.i2 < 1000);
+        CPPUNIT_ASSERT_EQUAL(p.i1, c._alternativeBucket(p.i2, p.f));
+    }
+}
+
+void CuckooTest::testNoFalseNegatives() {
+    Cuckoo c = Cuckoo(12, 4, 1000, 500);
+    auto inserted = _populate(c, 3800, 1 << 30);
+
+    CPPUNIT_ASSERT(_failed_insert_count(inserted) < 3800 / 10);
+    CPPUNIT_ASSERT_EQUAL(0LU, _lost_items(c, inserted));
+}
+
+void CuckooTest::testZeroFingerprint() {
+    // with one bit of fingerprint, about half of the items have it 0
+    Cuckoo c = Cuckoo(1, 4, 1000, 500);
+    vector<DataObject> inserted;
+    for (size_t ii=0; ii<(1 << 8); ii++) {
+        DataObject dObj = DataObject(ZZ(Cuckoo::_rand(0, (1 << 30))));
+        CPPUNIT_ASSERT_EQUAL(1LU, c._pHash(dObj).f);
+        CPPUNIT_ASSERT(!c.isZeroF(dObj));
+        if (c.insert(dObj))
+            inserted.push_back(dObj);
+    }
+    for (const auto& dObj : inserted)
+        CPPUNIT_ASSERT(c.lookup(dObj));
+}
+
+void CuckooTest::testCustomHashNotSent() {
+    // hashes under which the alternative bucket is symmetric
+    Cuckoo c(12, 4, 1000, Cuckoo::DEFAULT_MAX_KICKS,
+             [](const ZZ& e, size_t fngprtSize) { return size_t(conv<long>(e % ((1 << fngprtSize) - 1)) + 1); },
+             [](const ZZ& e, size_t filterSize) { return e % filterSize; });
+    c.trackChanges(true);
+    DataObject dObj(ZZ(42));
+    CPPUNIT_ASSERT(c.insert(dObj));
+    CPPUNIT_ASSERT(c.lookup(dObj));
+
+    // a receiver would look the elements up with the native hashes
+    CPPUNIT_ASSERT_THROW(c.toByteVector(), Cuckoo::CuckooFilterError);
+    CPPUNIT_ASSERT_THROW(c.deltaToByteVector(), Cuckoo::CuckooFilterError);
+}
+
+void CuckooTest::testOldSnapshot() {
+    const std::uint64_t OLD_MAGIC = 0x435049434b4f4f01ULL;
+    const string fileName = temporaryDir() + "/CuckooOldSnapshot." + toStr(getpid());
+    remove(fileName.c_str());
+
+    {
+        Cuckoo c(fileName, 12, 4, 1000, Cuckoo::DEFAULT_MAX_KICKS);
+        for (size_t ii=0; ii<(1 << 10); ii++)
+            c.insert(DataObject(ZZ(Cuckoo::_rand(0, (1 << 30)))));
+    } // closing flushes, and marks the file clean
+
+    // the same file, but as the previous version wrote it
+    FILE* file = fopen(fileName.c_str(), "r+b");
+    CPPUNIT_ASSERT(file != nullptr);
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, fwrite(&OLD_MAGIC, sizeof(OLD_MAGIC), 1, file));
+    fclose(file);
+
+    Cuckoo old(fileName, 12, 4, 1000, Cuckoo::DEFAULT_MAX_KICKS);
+    CPPUNIT_ASSERT(!old.resumed());
+    CPPUNIT_ASSERT_EQUAL(ZZ(0), old.getItemsCount());
+
+    remove(fileName.c_str());
+}
@@ -17,8 +17,16 @@ class CuckooTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testInsert);
     // CPPUNIT_TEST(testInsertHuge);
     CPPUNIT_TEST(testLookup);
+    CPPUNIT_TEST(testLookupAll);
     CPPUNIT_TEST(testErase);
     CPPUNIT_TEST(testSmartConstructor);
+    CPPUNIT_TEST(testSnapshot);
+    CPPUNIT_TEST(testDelta);
+    CPPUNIT_TEST(testAlternativeBucket);
+    CPPUNIT_TEST(testNoFalseNegatives);
+    CPPUNIT_TEST(testZeroFingerprint);
+    CPPUNIT_TEST(testOldSnapshot);
+    CPPUNIT_TEST(testCustomHashNotSent);
     CPPUNIT_TEST(testConfigF3);
     CPPUNIT_TEST(testConfigF7);
     CPPUNIT_TEST(testConfigF13);
@@ -57,6 +65,13 @@ public:
      */
     static void testLookup();
 
+    /*
+     * Batched lookups, on one thread and on several, agree with
+     * lookup for inserted and other items, in both storage layouts
+     * of the filter.
+     */
+    static void testLookupAll();
+
     /*
      * Uses twice as big filter as testLookup. Inserts from the same
      * range as testLookup. Checks:
@@ -74,6 +89,51 @@ public:
      */
     static void testSmartConstructor();
 
+    /**
+     * Tests that a filter kept in a snapshot file is resumed with its
+     * content and item count, and that copies are independent of the
+     * file.
+     */
+    static void testSnapshot();
+
+    /**
+     * Tests that a copy of a filter that applies the filter's delta
+     * catches up with its content and item count, for fingerprints of
+     * one to three bytes, and that a malformed delta is refused
+     * without changing the copy.
+     */
+    static void testDelta();
+
+    /**
+     * Tests that the alternative of the alternative bucket is the
+     * bucket itself when the filter size is not a power of two.
+     */
+    static void testAlternativeBucket();
+
+    /**
+     * Tests that every item inserted into a filter whose size is not
+     * a power of two is found, after enough inserts to make it kick.
+     */
+    static void testNoFalseNegatives();
+
+    /**
+     * Tests that an item whose fingerprint bits are all zero gets the
+     * fingerprint 1, since 0 marks an empty entry.
+     */
+    static void testZeroFingerprint();
+
+    /**
+     * Tests that a snapshot file written with the ZZ and string
+     * hashes, under the previous magic word, is not resumed.
+     */
+    static void testOldSnapshot();
+
+    /**
+     * Tests that a filter with custom hash functions refuses to be
+     * serialized, since a receiver would use the native hashes.
+     */
+    static void testCustomHashNotSent();
+
     /**
      * Tests for different configurations of Cuckoo Filter.
      * TODO: Here we generate random numbers in each test run and thus
@@ -3,12 +3,45 @@
 // Created by eliez on 8/10/2018.
 //
 
+#include <thread>
 #include "IBLTSyncTest.h"
 #include <CPISync/Syncs/GenSync.h>
 #include <CPISync/Syncs/IBLTSync.h>
 #include "TestAuxiliary.h"
 CPPUNIT_TEST_SUITE_REGISTRATION(IBLTSyncTest);
 
+namespace {
+    // the first of the ports used by the snapshot test, one per sync
+    int snapshotPort = 8501;
+
+    /**
+     * Syncs two IBLTSyncs over a socket, with the server on a thread of this process, so that the state of
+     * both outlives the sync.
+     * @param serverSMO Receives the elements that the server found only it has
+     * @param serverOMS Receives the elements that the server found only the client has
+     * @return true iff both sides succeeded
+     */
+    bool syncPeers(IBLTSync &client, IBLTSync &server,
+                   list<shared_ptr<DataObject>> &serverSMO, list<shared_ptr<DataObject>> &serverOMS) {
+        int port = snapshotPort++;
+        auto clientComm = make_shared<CommSocket>(port, host);
+        auto serverComm = make_shared<CommSocket>(port);
+        list<shared_ptr<DataObject>> clientSMO, clientOMS;
+
+        bool serverOK = false;
+        std::thread serverThread([&]() {
+            try {
+                serverOK = server.SyncServer(serverComm, serverSMO, serverOMS);
+            } catch (const std::exception&) {
+                serverOK = false;
+            }
+        });
+        bool clientOK = client.SyncClient(clientComm, clientSMO, clientOMS);
+        serverThread.join();
+        return clientOK && serverOK;
+    }
+}
+
 IBLTSyncTest::IBLTSyncTest() = default;
 
 IBLTSyncTest::~IBLTSyncTest() = default;
@@ -84,6 +117,103 @@ void IBLTSyncTest::IBLTSyncLargeSetReconcileTest() {
 	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, true));
 }
 
+void IBLTSyncTest::IBLTSyncEstimatedSetReconcileTest() {
+	const int BITS = sizeof(randZZ());
+
+	// the expected number of elements is far too small, and is replaced by the estimate
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setEstimateIBLTSize(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setEstimateIBLTSize(true).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void IBLTSyncTest::IBLTSyncRetrySetReconcileTest() {
+	const int BITS = sizeof(randZZ());
+	const size_t RETRIES = 16; // enough doublings to reach any difference in the test
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setIBLTRetries(RETRIES).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setIBLTRetries(RETRIES).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void IBLTSyncTest::IBLTSyncFlatSetReconcileTest() {
+	const int BITS = sizeof(randZZ());
+
+	// the server subtracts and decodes a flat IBLT; the wire format is the same
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			setFlatIBLT(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void IBLTSyncTest::IBLTSyncFlatRetrySetReconcileTest() {
+	const int BITS = sizeof(randZZ());
+	const size_t RETRIES = 16; // enough doublings to reach any difference in the test
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setIBLTRetries(RETRIES).
+			setFlatIBLT(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(1).
+			setIBLTRetries(RETRIES).
+			setFlatIBLT(true).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
 void IBLTSyncTest::testAddDelElem() {
     // number of elems to add
     const int ITEMS = 50;
@@ -137,4 +267,64 @@ void IBLTSyncTest::testIBLTParamMismatch(){
 
 	//(oneWay = false, Multiset = false, largeSync = false)
 	CPPUNIT_ASSERT(!(syncTest(GenSyncClient, GenSyncServer, false, false, false)));
-}
\ No newline at end of file
+}
+
+void IBLTSyncTest::testIBLTHashMismatch(){
+    const int BITS = sizeof(randZZ());
+
+    GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			//Different hash families would decode each other's cells to garbage, so the handshake must refuse them
+			setLegacyIBLTHash(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(!(syncTest(GenSyncClient, GenSyncServer, false, false, false)));
+}
+
+void IBLTSyncTest::IBLTSyncSnapshotResumeTest() {
+    const size_t BITS = sizeof(randZZ());
+    const int SHARED = 200, SERVER_NEW = 7, CLIENT_NEW = 5;
+    const string fileName = temporaryDir() + "/IBLTSyncSnapshot." + toStr(getpid());
+    remove(fileName.c_str());
+
+    vector<shared_ptr<DataObject>> shared;
+    for (int ii = 0; ii < SHARED; ii++)
+        shared.push_back(make_shared<DataObject>(randZZ()));
+
+    {
+        IBLTSync first(numExpElem, BITS, IBLTHashScheme::Seeded, false, 0, false, fileName);
+        CPPUNIT_ASSERT(!first.resumed());
+        first.addElems(shared);
+    } // closing flushes the IBLT
+
+    IBLTSync restarted(numExpElem, BITS, IBLTHashScheme::Seeded, false, 0, false, fileName);
+    CPPUNIT_ASSERT(restarted.resumed());
+    restarted.addElems(shared);
+    restarted.endReplay(); // the elements added from now on are new to the IBLT
+    for (int ii = 0; ii < SERVER_NEW; ii++)
+        restarted.addElem(make_shared<DataObject>(randZZ()));
+
+    IBLTSync peer(numExpElem, BITS);
+    peer.addElems(shared);
+    for (int ii = 0; ii < CLIENT_NEW; ii++)
+        peer.addElem(make_shared<DataObject>(randZZ()));
+
+    // shared elements inserted twice, or new ones left out, would show up as differences
+    list<shared_ptr<DataObject>> serverSMO, serverOMS;
+    CPPUNIT_ASSERT(syncPeers(peer, restarted, serverSMO, serverOMS));
+    CPPUNIT_ASSERT_EQUAL((size_t) SERVER_NEW, serverSMO.size());
+    CPPUNIT_ASSERT_EQUAL((size_t) CLIENT_NEW, serverOMS.size());
+
+    remove(fileName.c_str());
+}
@@ -15,9 +15,15 @@ class IBLTSyncTest : public CPPUNIT_NS::TestFixture {
         CPPUNIT_TEST(IBLTSyncSetReconcileTest);
 		CPPUNIT_TEST(IBLTSyncMultisetReconcileTest);
 		CPPUNIT_TEST(IBLTSyncLargeSetReconcileTest);
+		CPPUNIT_TEST(IBLTSyncEstimatedSetReconcileTest);
+		CPPUNIT_TEST(IBLTSyncRetrySetReconcileTest);
+		CPPUNIT_TEST(IBLTSyncFlatSetReconcileTest);
+		CPPUNIT_TEST(IBLTSyncFlatRetrySetReconcileTest);
+		CPPUNIT_TEST(IBLTSyncSnapshotResumeTest);
 		CPPUNIT_TEST(testAddDelElem);
         CPPUNIT_TEST(testGetStrings);
 		CPPUNIT_TEST(testIBLTParamMismatch);
+		CPPUNIT_TEST(testIBLTHashMismatch);
 
     CPPUNIT_TEST_SUITE_END();
 public:
@@ -44,6 +50,33 @@ public:
 	 */
 	void IBLTSyncLargeSetReconcileTest();
 
+	/**
+	 * Tests reconciliation of sets when the IBLT is sized from a strata estimate of the difference
+	 */
+	void IBLTSyncEstimatedSetReconcileTest();
+
+	/**
+	 * Tests reconciliation of sets with an undersized IBLT, which succeeds by retrying with larger IBLTs
+	 */
+	void IBLTSyncRetrySetReconcileTest();
+
+	/**
+	 * Tests reconciliation of sets between a server that keeps its IBLT as an IBLTFlat and a client that does not
+	 */
+	void IBLTSyncFlatSetReconcileTest();
+
+	/**
+	 * Tests reconciliation of sets between peers that both keep their IBLTs as IBLTFlats, with undersized IBLTs,
+	 * so that the server subtracts and scans flat IBLTs over several rounds
+	 */
+	void IBLTSyncFlatRetrySetReconcileTest();
+
+	/**
+	 * Tests that an IBLTSync restarted from its snapshot file, with its elements added back, syncs as though it
+	 * had kept running
+	 */
+	void IBLTSyncSnapshotResumeTest();
+
 	/**
 	 * Test adding and deleting elements
 	 */
@@ -59,6 +92,11 @@ public:
  	*/
     void testIBLTParamMismatch();
 
+	/**
+ 	* Test that IBLT Sync reports failure when one peer uses the legacy hashes and the other the seeded ones
+ 	*/
+    void testIBLTHashMismatch();
+
 	/**
  	* Test that IBLT Functions properly for very large inputs
  	*/
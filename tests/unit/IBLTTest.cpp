@@ -4,6 +4,7 @@
 //
 
 #include <climits>
+#include <fstream>
 #include "IBLTTest.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IBLTTest);
@@ -217,4 +218,258 @@ void IBLTTest::testIBLTMultisetSubtract() {
 
     CPPUNIT_ASSERT_EQUAL(items.size(), plus.size() + minus.size());
     CPPUNIT_ASSERT(recon == allItems);
-}
\ No newline at end of file
+}
+void IBLTTest::testIBLTFlat() {
+    const int SIZE = 50; // should be even
+
+    // one-word (sizeof(ZZ)) and multi-word (two ZZs) cells
+    for (size_t itemSize : {sizeof(ZZ), 2 * sizeof(ZZ)}) {
+        vector<pair<ZZ, ZZ>> items;
+        for (int ii = 0; ii < SIZE; ii++) {
+            ZZ key = itemSize > sizeof(ZZ) ? RandomBits_ZZ(8 * itemSize) : randZZ();
+            items.push_back({key, randZZ()});
+        }
+
+        IBLTFlat iblt(SIZE * 2, itemSize);
+        CPPUNIT_ASSERT_EQUAL(itemSize, iblt.eltSize());
+        for (unsigned int ii = 0; ii < SIZE / 2; ii++)
+            iblt.insert(items.at(ii).first, items.at(ii).second);
+
+        // subtracting an IBLTFlat is the same as erasing its entries
+        IBLTFlat other(SIZE * 2, itemSize);
+        for (unsigned int ii = SIZE / 2; ii < SIZE; ii++)
+            other.insert(items.at(ii).first, items.at(ii).second);
+        iblt -= other;
+
+        for (unsigned int ii = 0; ii < SIZE; ii++) {
+            IBLTFlat ibltCopy(iblt); // make a copy each time because getting is destructive
+            auto pair = items.at(ii);
+            ZZ value;
+            CPPUNIT_ASSERT(ibltCopy.get(pair.first, value));
+            CPPUNIT_ASSERT_EQUAL(pair.second, value);
+        }
+
+        vector<pair<ZZ, ZZ>> plus = {}, minus = {};
+        CPPUNIT_ASSERT(iblt.listEntries(plus, minus));
+        CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, plus.size());
+        CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, minus.size());
+        for (auto &entry : plus)
+            CPPUNIT_ASSERT(std::find(items.begin(), items.begin() + SIZE / 2, entry) != items.begin() + SIZE / 2);
+        for (auto &entry : minus)
+            CPPUNIT_ASSERT(std::find(items.begin() + SIZE / 2, items.end(), entry) != items.end());
+    }
+}
+
+void IBLTTest::testIBLTFlatCompatibility() {
+    for (IBLTHashScheme scheme : {IBLTHashScheme::Seeded, IBLTHashScheme::Legacy})
+        checkIBLTFlatCompatibility(scheme);
+}
+
+void IBLTTest::checkIBLTFlatCompatibility(IBLTHashScheme scheme) {
+    const int SIZE = 50;
+    const size_t ITEM_SIZE = sizeof(ZZ);
+
+    IBLT iblt(SIZE, ITEM_SIZE, scheme);
+    IBLTFlat flat(SIZE, ITEM_SIZE, scheme);
+    CPPUNIT_ASSERT_EQUAL(iblt.size(), flat.size());
+
+    std::set<ZZ> inserted;
+    for (int ii = 0; ii < SIZE / 2; ii++) {
+        ZZ item = randZZ();
+        iblt.insert(item, item);
+        flat.insert(item, item);
+        inserted.insert(item);
+    }
+    // include a zero key and value, which are sent as a single byte
+    iblt.insert(ZZ(0), ZZ(0));
+    flat.insert(ZZ(0), ZZ(0));
+    inserted.insert(ZZ(0));
+
+    vector<byte> ibltBytes = iblt.toByteVector();
+    CPPUNIT_ASSERT(ibltBytes == flat.toByteVector());
+
+    // an IBLTFlat parses an IBLT ...
+    IBLTFlat flatFromIBLT(SIZE, ITEM_SIZE, scheme);
+    flatFromIBLT.fromByteVector(ibltBytes);
+    vector<pair<ZZ, ZZ>> plus = {}, minus = {};
+    CPPUNIT_ASSERT(flatFromIBLT.listEntries(plus, minus));
+    CPPUNIT_ASSERT(minus.empty());
+    std::set<ZZ> recovered;
+    for (auto &entry : plus) recovered.insert(entry.first);
+    CPPUNIT_ASSERT(recovered == inserted);
+
+    // ... and an IBLT parses an IBLTFlat
+    IBLT ibltFromFlat(SIZE, ITEM_SIZE, scheme);
+    ibltFromFlat.fromByteVector(flat.toByteVector());
+    plus.clear();
+    CPPUNIT_ASSERT(ibltFromFlat.listEntries(plus, minus));
+    recovered.clear();
+    for (auto &entry : plus) recovered.insert(entry.first);
+    CPPUNIT_ASSERT(recovered == inserted);
+}
+
+void IBLTTest::testListEntriesSparse() {
+    const int SHARED = 2000, DIFF = 50;
+    const size_t ITEM_SIZE = sizeof(ZZ);
+
+    IBLT ours(SHARED, ITEM_SIZE), theirs(SHARED, ITEM_SIZE);
+    IBLTFlat oursFlat(SHARED, ITEM_SIZE), theirsFlat(SHARED, ITEM_SIZE);
+    std::set<ZZ> onlyOurs, onlyTheirs;
+    for (int ii = 0; ii < SHARED + 2 * DIFF; ii++) {
+        ZZ item = randZZ();
+        if (ii < SHARED || ii % 2 == 0) {
+            ours.insert(item, item);
+            oursFlat.insert(item, item);
+        }
+        if (ii < SHARED || ii % 2 == 1) {
+            theirs.insert(item, item);
+            theirsFlat.insert(item, item);
+        }
+        if (ii >= SHARED)
+            (ii % 2 == 0 ? onlyOurs : onlyTheirs).insert(item);
+    }
+
+    vector<pair<ZZ, ZZ>> plus, minus;
+    CPPUNIT_ASSERT((ours -= theirs).listEntries(plus, minus));
+    vector<pair<ZZ, ZZ>> plusFlat, minusFlat;
+    CPPUNIT_ASSERT((oursFlat -= theirsFlat).listEntries(plusFlat, minusFlat));
+
+    for (auto *list : {&plus, &plusFlat}) {
+        std::set<ZZ> recovered;
+        for (auto &entry : *list) recovered.insert(entry.first);
+        CPPUNIT_ASSERT(recovered == onlyOurs);
+    }
+    for (auto *list : {&minus, &minusFlat}) {
+        std::set<ZZ> recovered;
+        for (auto &entry : *list) recovered.insert(entry.first);
+        CPPUNIT_ASSERT(recovered == onlyTheirs);
+    }
+}
+
+void IBLTTest::testBulkInsert() {
+    const int SIZE = 20000; // enough for several threads
+    const unsigned THREADS = 4;
+    const size_t ITEM_SIZE = sizeof(ZZ);
+
+    vector<shared_ptr<DataObject>> elems;
+    for (int ii = 0; ii < SIZE; ii++)
+        elems.push_back(make_shared<DataObject>(randZZ()));
+
+    IBLT sequential(SIZE, ITEM_SIZE), bulk(SIZE, ITEM_SIZE);
+    for (auto &elem : elems)
+        sequential.insert(elem->to_ZZ(), elem->to_ZZ());
+    bulk.bulkInsert(elems.begin(), elems.end(), THREADS);
+    CPPUNIT_ASSERT(sequential.toByteVector() == bulk.toByteVector());
+
+    // bulk insertion adds to what is already in the IBLT
+    IBLT halves(SIZE, ITEM_SIZE);
+    halves.bulkInsert(elems.begin(), elems.begin() + SIZE / 2, THREADS);
+    halves.bulkInsert(elems.begin() + SIZE / 2, elems.end(), THREADS);
+    CPPUNIT_ASSERT(sequential.toByteVector() == halves.toByteVector());
+
+    // multisets, with repeated elements
+    for (int ii = 0; ii < SIZE / 4; ii++)
+        elems.push_back(elems[rand() % SIZE]);
+    IBLTMultiset sequentialMulti(SIZE, ITEM_SIZE), bulkMulti(SIZE, ITEM_SIZE);
+    for (auto &elem : elems)
+        sequentialMulti.insert(elem->to_ZZ(), elem->to_ZZ());
+    bulkMulti.bulkInsert(elems.begin(), elems.end(), THREADS);
+    CPPUNIT_ASSERT(sequentialMulti.toByteVector() == bulkMulti.toByteVector());
+}
+
+void IBLTTest::testIBLTFlatSubtract() {
+    const int SHARED = 500, DIFF = 40;
+    const size_t ITEM_SIZE = sizeof(ZZ);
+
+    // one-word keys: the difference must be byte-for-byte that of IBLT
+    IBLT ibltA(SHARED + DIFF, ITEM_SIZE), ibltB(SHARED + DIFF, ITEM_SIZE);
+    IBLTFlat flatA(SHARED + DIFF, ITEM_SIZE), flatB(SHARED + DIFF, ITEM_SIZE);
+    for (int ii = 0; ii < SHARED + DIFF; ii++) {
+        ZZ item = randZZ();
+        if (ii < SHARED || ii % 2 == 0) {
+            ibltA.insert(item, item);
+            flatA.insert(item, item);
+        }
+        if (ii < SHARED || ii % 2 == 1) {
+            ibltB.insert(item, item);
+            flatB.insert(item, item);
+        }
+    }
+    CPPUNIT_ASSERT((ibltA - ibltB).toByteVector() == (flatA - flatB).toByteVector());
+    CPPUNIT_ASSERT((ibltB - ibltA).toByteVector() == (flatB - flatA).toByteVector());
+    // a table minus itself is empty
+    vector<pair<ZZ, ZZ>> plus, minus;
+    CPPUNIT_ASSERT((flatA - flatA).listEntries(plus, minus));
+    CPPUNIT_ASSERT(plus.empty() && minus.empty());
+
+    // multi-word keys, spanning several vectors per cell
+    const size_t WIDE_SIZE = 40;
+    IBLTFlat wideA(SHARED + DIFF, WIDE_SIZE), wideB(SHARED + DIFF, WIDE_SIZE);
+    std::set<ZZ> onlyA, onlyB;
+    for (int ii = 0; ii < SHARED + DIFF; ii++) {
+        ZZ item = RandomBits_ZZ(8 * WIDE_SIZE - 1);
+        if (ii < SHARED || ii % 2 == 0) wideA.insert(item, item);
+        if (ii < SHARED || ii % 2 == 1) wideB.insert(item, item);
+        if (ii >= SHARED) (ii % 2 == 0 ? onlyA : onlyB).insert(item);
+    }
+    CPPUNIT_ASSERT((wideA -= wideB).listEntries(plus, minus));
+    std::set<ZZ> recoveredA, recoveredB;
+    for (auto &entry : plus) recoveredA.insert(entry.first);
+    for (auto &entry : minus) recoveredB.insert(entry.first);
+    CPPUNIT_ASSERT(recoveredA == onlyA);
+    CPPUNIT_ASSERT(recoveredB == onlyB);
+}
+
+void IBLTTest::testIBLTFlatSnapshot() {
+    const int ITEMS = 300;
+    const size_t ITEM_SIZE = sizeof(ZZ);
+    const string fileName = temporaryDir() + "/IBLTFlatSnapshot." + toStr(getpid());
+    remove(fileName.c_str());
+
+    IBLTFlat inMemory(ITEMS, ITEM_SIZE);
+    vector<ZZ> items;
+    {
+        IBLTFlat snapshot(fileName, ITEMS, ITEM_SIZE);
+        CPPUNIT_ASSERT(!snapshot.resumed());
+        for (int ii = 0; ii < ITEMS; ii++) {
+            items.push_back(randZZ());
+            snapshot.insert(items.back(), items.back());
+            inMemory.insert(items.back(), items.back());
+        }
+        // erases update the file in place too
+        snapshot.erase(items.back(), items.back());
+        inMemory.erase(items.back(), items.back());
+    } // closing flushes
+
+    {
+        IBLTFlat snapshot(fileName, ITEMS, ITEM_SIZE);
+        CPPUNIT_ASSERT(snapshot.resumed());
+        CPPUNIT_ASSERT(snapshot.toByteVector() == inMemory.toByteVector());
+
+        // a copy is held in memory, so peeling it leaves the snapshot alone
+        vector<pair<ZZ, ZZ>> plus, minus;
+        IBLTFlat copy(snapshot);
+        CPPUNIT_ASSERT(copy.listEntries(plus, minus));
+        CPPUNIT_ASSERT_EQUAL((size_t) ITEMS - 1, plus.size());
+        CPPUNIT_ASSERT(snapshot.toByteVector() == inMemory.toByteVector());
+
+        // a change after the last flush is not resumed after an unclean exit, which a copy of the file stands for
+        snapshot.flush();
+        snapshot.insert(items.front(), items.front());
+        std::ifstream src(fileName, std::ios::binary);
+        std::ofstream dst(fileName + ".crash", std::ios::binary);
+        dst << src.rdbuf();
+    }
+    {
+        IBLTFlat crashed(fileName + ".crash", ITEMS, ITEM_SIZE);
+        CPPUNIT_ASSERT(!crashed.resumed());
+        CPPUNIT_ASSERT(crashed.toByteVector() == IBLTFlat(ITEMS, ITEM_SIZE).toByteVector());
+    }
+
+    // a snapshot with other parameters starts over
+    IBLTFlat other(fileName, 2 * ITEMS, ITEM_SIZE);
+    CPPUNIT_ASSERT(!other.resumed());
+
+    remove(fileName.c_str());
+    remove((fileName + ".crash").c_str());
+}
@@ -9,6 +9,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <CPISync/Syncs/IBLT.h>
 #include <CPISync/Syncs/IBLTMultiset.h>
+#include <CPISync/Syncs/IBLTFlat.h>
 #include <CPISync/Aux/Auxiliary.h>
 #include <iostream>
 #include <algorithm>
@@ -20,6 +21,12 @@ class IBLTTest : public CPPUNIT_NS::TestFixture{
     CPPUNIT_TEST(IBLTNestedInsertRetrieveTest);
     CPPUNIT_TEST(testIBLTMultisetInsert);
     CPPUNIT_TEST(testIBLTMultisetSubtract);
+    CPPUNIT_TEST(testIBLTFlat);
+    CPPUNIT_TEST(testIBLTFlatCompatibility);
+    CPPUNIT_TEST(testListEntriesSparse);
+    CPPUNIT_TEST(testBulkInsert);
+    CPPUNIT_TEST(testIBLTFlatSubtract);
+    CPPUNIT_TEST(testIBLTFlatSnapshot);
 
     CPPUNIT_TEST_SUITE_END();
 public:
@@ -53,6 +60,38 @@ public:
      */
     static void testIBLTMultisetSubtract();
 
+    /**
+     * Tests insert, erase, get, subtract and listEntries on the fixed-width IBLT layout
+     */
+    static void testIBLTFlat();
+
+    /**
+     * Tests that IBLT and IBLTFlat serialize identically and can parse each other, under every hash scheme
+     */
+    static void testIBLTFlatCompatibility();
+    static void checkIBLTFlatCompatibility(IBLTHashScheme scheme);
+
+    /**
+     * Tests that peeling recovers exactly a small difference between two large, mostly equal IBLTs
+     */
+    static void testListEntriesSparse();
+
+    /**
+     * Tests that multithreaded bulk insertion builds the same IBLT and IBLTMultiset as sequential insertion
+     */
+    static void testBulkInsert();
+
+    /**
+     * Tests that IBLTFlat subtraction matches IBLT subtraction, for one-word and multi-word cells
+     */
+    static void testIBLTFlatSubtract();
+
+    /**
+     * Tests that an IBLTFlat kept in a snapshot file is resumed by a later process only if it was
+     * flushed after its last change and has the same parameters
+     */
+    static void testIBLTFlatSnapshot();
+
 
 };
 
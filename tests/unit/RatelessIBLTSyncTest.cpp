@@ -0,0 +1,64 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#include "RatelessIBLTSyncTest.h"
+#include <CPISync/Syncs/GenSync.h>
+#include "TestAuxiliary.h"
+CPPUNIT_TEST_SUITE_REGISTRATION(RatelessIBLTSyncTest);
+
+RatelessIBLTSyncTest::RatelessIBLTSyncTest() = default;
+
+RatelessIBLTSyncTest::~RatelessIBLTSyncTest() = default;
+
+void RatelessIBLTSyncTest::setUp() {
+    const int SEED = 93;
+    srand(SEED);
+}
+
+void RatelessIBLTSyncTest::tearDown() {
+}
+
+void RatelessIBLTSyncTest::RatelessIBLTSyncSetReconcileTest() {
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
+
+void RatelessIBLTSyncTest::RatelessIBLTSyncLargeSetReconcileTest() {
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = true)
+	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, true));
+}
+
+void RatelessIBLTSyncTest::RatelessIBLTSyncHashMismatchTest() {
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setLegacyIBLTHash(true).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::RatelessIBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			build();
+
+	//(oneWay = false, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(!syncTest(GenSyncClient, GenSyncServer, false, false, false));
+}
@@ -0,0 +1,39 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef CPISYNCLIB_RATELESSIBLTSYNCTEST_H
+#define CPISYNCLIB_RATELESSIBLTSYNCTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class RatelessIBLTSyncTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(RatelessIBLTSyncTest);
+
+    CPPUNIT_TEST(RatelessIBLTSyncSetReconcileTest);
+    CPPUNIT_TEST(RatelessIBLTSyncLargeSetReconcileTest);
+    CPPUNIT_TEST(RatelessIBLTSyncHashMismatchTest);
+
+    CPPUNIT_TEST_SUITE_END();
+public:
+    RatelessIBLTSyncTest();
+
+    ~RatelessIBLTSyncTest() override;
+    void setUp() override;
+    void tearDown() override;
+
+    /**
+     * Tests reconciliation of sets using RatelessIBLTSync
+     */
+    void RatelessIBLTSyncSetReconcileTest();
+
+    /**
+     * Tests reconciliation of large sets using RatelessIBLTSync
+     */
+    void RatelessIBLTSyncLargeSetReconcileTest();
+
+    /**
+     * Tests that RatelessIBLTSync fails when one peer uses the legacy hashes and the other the seeded ones
+     */
+    void RatelessIBLTSyncHashMismatchTest();
+};
+
+#endif //CPISYNCLIB_RATELESSIBLTSYNCTEST_H
@@ -0,0 +1,159 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#include <algorithm>
+#include "RatelessIBLTTest.h"
+#include <CPISync/Aux/Auxiliary.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RatelessIBLTTest);
+
+RatelessIBLTTest::RatelessIBLTTest() = default;
+
+RatelessIBLTTest::~RatelessIBLTTest() = default;
+
+void RatelessIBLTTest::setUp() {
+    const int SEED = 711;
+    srand(SEED);
+}
+
+void RatelessIBLTTest::tearDown() {}
+
+namespace {
+    /**
+     * Streams symbols from sender to receiver, batch symbols at a time, until the receiver decodes.
+     * @return the number of symbols sent, or 0 if more than limit symbols did not suffice
+     */
+    size_t stream(RatelessIBLT &sender, RatelessIBLT &receiver, size_t batch, size_t limit) {
+        while (sender.numSymbols() < limit) {
+            vector<byte> symbols = sender.encode(batch);
+            if (receiver.decode(symbols.data(), symbols.size()))
+                return sender.numSymbols();
+        }
+        return 0;
+    }
+
+    bool sameElements(vector<ZZ> found, vector<ZZ> expected) {
+        auto less = [](const ZZ &a, const ZZ &b) { return a < b; };
+        std::sort(found.begin(), found.end(), less);
+        std::sort(expected.begin(), expected.end(), less);
+        return found == expected;
+    }
+}
+
+void RatelessIBLTTest::testDecodeDifference() {
+    const int SHARED = 300;
+
+    for (IBLTHashScheme scheme : {IBLTHashScheme::Seeded, IBLTHashScheme::Legacy}) {
+        for (size_t diff : {1, 2, 10, 75}) {
+            for (size_t batch : {1, 16}) {
+                RatelessIBLT sender(scheme), receiver(scheme);
+                for (int ii = 0; ii < SHARED; ii++) {
+                    ZZ item = randZZ();
+                    sender.insert(item);
+                    receiver.insert(item);
+                }
+                // split the difference between the two sides
+                vector<ZZ> senderOnly, receiverOnly;
+                for (size_t ii = 0; ii < diff; ii++) {
+                    ZZ item = randZZ();
+                    if (ii % 2 == 0) {
+                        senderOnly.push_back(item);
+                        sender.insert(item);
+                    } else {
+                        receiverOnly.push_back(item);
+                        receiver.insert(item);
+                    }
+                }
+
+                CPPUNIT_ASSERT(stream(sender, receiver, batch, 10 * diff + 100) > 0);
+                CPPUNIT_ASSERT(receiver.decoded());
+                CPPUNIT_ASSERT(sameElements(receiver.remoteOnly(), senderOnly));
+                CPPUNIT_ASSERT(sameElements(receiver.localOnly(), receiverOnly));
+            }
+        }
+    }
+}
+
+void RatelessIBLTTest::testIdenticalSets() {
+    const int SHARED = 1000;
+
+    RatelessIBLT sender, receiver;
+    CPPUNIT_ASSERT(!receiver.decoded());
+    for (int ii = 0; ii < SHARED; ii++) {
+        ZZ item = randZZ();
+        sender.insert(item);
+        receiver.insert(item);
+    }
+
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, stream(sender, receiver, 1, 1));
+    CPPUNIT_ASSERT(receiver.remoteOnly().empty());
+    CPPUNIT_ASSERT(receiver.localOnly().empty());
+}
+
+void RatelessIBLTTest::testSymbolOverhead() {
+    const int SHARED = 2000, DIFF = 1000;
+
+    RatelessIBLT sender, receiver;
+    for (int ii = 0; ii < SHARED; ii++) {
+        ZZ item = randZZ();
+        sender.insert(item);
+        receiver.insert(item);
+    }
+    for (int ii = 0; ii < DIFF; ii++)
+        (ii % 3 == 0 ? sender : receiver).insert(randZZ());
+
+    // about 1.35 symbols per difference are needed on average
+    size_t sent = stream(sender, receiver, 1, 2 * DIFF);
+    CPPUNIT_ASSERT(sent > 0);
+    CPPUNIT_ASSERT_EQUAL((size_t) DIFF, receiver.remoteOnly().size() + receiver.localOnly().size());
+}
+
+void RatelessIBLTTest::testMalformedSymbols() {
+    const int SHARED = 100, DIFF = 5;
+    RatelessIBLT sender, receiver;
+    vector<ZZ> senderOnly;
+    for (int ii = 0; ii < SHARED; ii++) {
+        ZZ item = randZZ();
+        sender.insert(item);
+        receiver.insert(item);
+    }
+    for (int ii = 0; ii < DIFF; ii++) {
+        senderOnly.push_back(randZZ());
+        sender.insert(senderOnly.back());
+    }
+    vector<byte> symbols = sender.encode(4 * DIFF);
+
+    // cut inside the last key sum, inside the first symbol's header, and just after it
+    for (size_t len : {symbols.size() - 1, (size_t) 3, sizeof(long) + sizeof(hash_t) + 1}) {
+        CPPUNIT_ASSERT(!receiver.decode(symbols.data(), len));
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, receiver.numSymbols());
+    }
+
+    // the first key sum claims more bytes than the whole buffer
+    vector<byte> overlong(symbols);
+    writeWordLE((std::uint64_t) overlong.size(), overlong.data() + sizeof(long) + sizeof(hash_t));
+    CPPUNIT_ASSERT(!receiver.decode(overlong.data(), overlong.size()));
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, receiver.numSymbols());
+
+    // nothing was taken in, so the intact symbols still decode
+    CPPUNIT_ASSERT(receiver.decode(symbols.data(), symbols.size()) || stream(sender, receiver, 1, 40 * DIFF) != 0);
+    CPPUNIT_ASSERT(sameElements(receiver.remoteOnly(), senderOnly));
+    CPPUNIT_ASSERT(receiver.localOnly().empty());
+}
+
+void RatelessIBLTTest::testMappingSaturates() {
+    for (std::uint64_t prng : {(std::uint64_t) 0, (std::uint64_t) 1, (std::uint64_t) 1 << 20}) {
+        RatelessIBLT::Source src;
+        src.prng = prng;
+        src.next = 0;
+        for (int ii = 0; ii < 200 && src.next != UINT64_MAX; ii++) {
+            std::uint64_t prev = src.next;
+            RatelessIBLT::_advance(src);
+            CPPUNIT_ASSERT(src.next > prev);
+        }
+        CPPUNIT_ASSERT_EQUAL(UINT64_MAX, src.next);
+
+        // and stays there
+        RatelessIBLT::_advance(src);
+        CPPUNIT_ASSERT_EQUAL(UINT64_MAX, src.next);
+    }
+}
@@ -0,0 +1,55 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef CPISYNCLIB_RATELESSIBLTTEST_H
+#define CPISYNCLIB_RATELESSIBLTTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <CPISync/Syncs/RatelessIBLT.h>
+
+class RatelessIBLTTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(RatelessIBLTTest);
+
+    CPPUNIT_TEST(testDecodeDifference);
+    CPPUNIT_TEST(testIdenticalSets);
+    CPPUNIT_TEST(testSymbolOverhead);
+    CPPUNIT_TEST(testMalformedSymbols);
+    CPPUNIT_TEST(testMappingSaturates);
+
+    CPPUNIT_TEST_SUITE_END();
+public:
+    RatelessIBLTTest();
+
+    ~RatelessIBLTTest() override;
+    void setUp() override;
+    void tearDown() override;
+
+    /**
+     * Tests that differences of various sizes, in both directions, are decoded exactly from symbols
+     * received one at a time and in batches, for both hash schemes
+     */
+    static void testDecodeDifference();
+
+    /**
+     * Tests that identical sets are found to be identical from the first symbol
+     */
+    static void testIdenticalSets();
+
+    /**
+     * Tests that a large difference decodes from a small constant number of symbols per difference
+     */
+    static void testSymbolOverhead();
+
+    /**
+     * Tests that truncated symbols, and symbols whose key sum claims more bytes than there are, are
+     * refused without changing the receiver, which then decodes the intact symbols
+     */
+    static void testMalformedSymbols();
+
+    /**
+     * Tests that an element whose gaps between symbols outgrow the symbol indices, including one whose
+     * generator is stuck at 0, ends up mapping to no more symbols rather than wrapping around
+     */
+    static void testMappingSaturates();
+};
+
+#endif //CPISYNCLIB_RATELESSIBLTTEST_H
@@ -0,0 +1,77 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#include "StrataEstimatorTest.h"
+#include <CPISync/Aux/Auxiliary.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StrataEstimatorTest);
+
+StrataEstimatorTest::StrataEstimatorTest() = default;
+
+StrataEstimatorTest::~StrataEstimatorTest() = default;
+
+void StrataEstimatorTest::setUp() {
+    const int SEED = 617;
+    srand(SEED);
+}
+
+void StrataEstimatorTest::tearDown() {}
+
+void StrataEstimatorTest::testSmallDifference() {
+    const int SHARED = 1000;
+    const size_t ELT_SIZE = sizeof(randZZ());
+
+    for (size_t diff : {0, 1, 7, 20}) {
+        StrataEstimator mine(ELT_SIZE), theirs(ELT_SIZE);
+        for (int ii = 0; ii < SHARED; ii++) {
+            ZZ item = randZZ();
+            mine.insert(item);
+            theirs.insert(item);
+        }
+        // split the difference between the two sides
+        for (size_t ii = 0; ii < diff; ii++)
+            (ii % 2 == 0 ? mine : theirs).insert(randZZ());
+
+        CPPUNIT_ASSERT_EQUAL(diff, mine.estimate(theirs));
+        CPPUNIT_ASSERT_EQUAL(diff, theirs.estimate(mine));
+    }
+}
+
+void StrataEstimatorTest::testLargeDifference() {
+    const int SHARED = 2000, DIFF = 5000;
+    const size_t ELT_SIZE = sizeof(randZZ());
+
+    StrataEstimator mine(ELT_SIZE), theirs(ELT_SIZE);
+    for (int ii = 0; ii < SHARED; ii++) {
+        ZZ item = randZZ();
+        mine.insert(item);
+        theirs.insert(item);
+    }
+    for (int ii = 0; ii < DIFF; ii++)
+        (ii % 3 == 0 ? mine : theirs).insert(randZZ());
+
+    size_t estimate = mine.estimate(theirs);
+    CPPUNIT_ASSERT(estimate >= DIFF / 2);
+    CPPUNIT_ASSERT(estimate <= 2 * DIFF);
+}
+
+void StrataEstimatorTest::testErase() {
+    const int SHARED = 500, DIFF = 100;
+    const size_t ELT_SIZE = sizeof(randZZ());
+
+    StrataEstimator mine(ELT_SIZE), theirs(ELT_SIZE);
+    for (int ii = 0; ii < SHARED; ii++) {
+        ZZ item = randZZ();
+        mine.insert(item);
+        theirs.insert(item);
+    }
+    vector<ZZ> extra;
+    for (int ii = 0; ii < DIFF; ii++) {
+        extra.push_back(randZZ());
+        mine.insert(extra.back());
+    }
+    CPPUNIT_ASSERT(mine.estimate(theirs) > 0);
+
+    for (const ZZ &item : extra)
+        mine.erase(item);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, mine.estimate(theirs));
+}
@@ -0,0 +1,40 @@
+/* This code is part of the CPISync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef CPISYNCLIB_STRATAESTIMATORTEST_H
+#define CPISYNCLIB_STRATAESTIMATORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <CPISync/Syncs/StrataEstimator.h>
+
+class StrataEstimatorTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(StrataEstimatorTest);
+
+    CPPUNIT_TEST(testSmallDifference);
+    CPPUNIT_TEST(testLargeDifference);
+    CPPUNIT_TEST(testErase);
+
+    CPPUNIT_TEST_SUITE_END();
+public:
+    StrataEstimatorTest();
+
+    ~StrataEstimatorTest() override;
+    void setUp() override;
+    void tearDown() override;
+
+    /**
+     * Tests that small differences are counted exactly, in both directions
+     */
+    static void testSmallDifference();
+
+    /**
+     * Tests that a difference far larger than a stratum is estimated within a factor of two
+     */
+    static void testLargeDifference();
+
+    /**
+     * Tests that erasing the elements that make up a difference leaves identical estimators
+     */
+    static void testErase();
+};
+
+#endif //CPISYNCLIB_STRATAESTIMATORTEST_H